@@ -0,0 +1,400 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
+#include "Host.h"
+
+// Timebase.cpp in PROFILER builds only
+extern "C" void TIMER1_OVF_vect(void) __attribute__((weak));
+
+// EECR, see avr/io.h
+HostEecr host_eecr_reg;
+
+extern "C" {
+
+// Registers (see avr/io.h), all 0 at reset
+volatile uint8_t _PINB;
+volatile uint8_t _PINC;
+volatile uint8_t _PIND;
+volatile uint8_t _PORTB;
+volatile uint8_t _PORTC;
+volatile uint8_t _PORTD;
+volatile uint8_t _DDRB;
+volatile uint8_t _DDRC;
+volatile uint8_t _DDRD;
+volatile uint8_t _TWBR;
+volatile uint8_t _TWSR;
+volatile uint8_t _TWAR;
+volatile uint8_t _TWDR;
+volatile uint8_t _TWCR;
+volatile uint8_t _TWAMR;
+volatile uint8_t _SREG;
+volatile uint8_t _MCUSR;
+volatile uint8_t _MCUCR;
+volatile uint8_t _SMCR;
+volatile uint8_t _PRR;
+volatile uint8_t _CLKPR;
+volatile uint8_t _OSCCAL;
+volatile uint8_t _TCCR0A;
+volatile uint8_t _TCCR0B;
+volatile uint8_t _TIMSK0;
+volatile uint8_t _TIFR0;
+volatile uint8_t _TCNT0;
+volatile uint8_t _OCR0A;
+volatile uint8_t _OCR0B;
+volatile uint8_t _TCCR1A;
+volatile uint8_t _TCCR1B;
+volatile uint8_t _TCCR1C;
+volatile uint8_t _TIMSK1;
+volatile uint8_t _TIFR1;
+volatile uint8_t _TCNT1L;
+volatile uint8_t _TCNT1H;
+volatile uint8_t _ICR1L;
+volatile uint8_t _ICR1H;
+volatile uint8_t _OCR1AL;
+volatile uint8_t _OCR1AH;
+volatile uint8_t _OCR1BL;
+volatile uint8_t _OCR1BH;
+volatile uint8_t _TCCR2A;
+volatile uint8_t _TCCR2B;
+volatile uint8_t _TIMSK2;
+volatile uint8_t _TIFR2;
+volatile uint8_t _TCNT2;
+volatile uint8_t _OCR2A;
+volatile uint8_t _OCR2B;
+volatile uint8_t _ASSR;
+volatile uint8_t _GTCCR;
+volatile uint8_t _UCSR0A;
+volatile uint8_t _UCSR0B;
+volatile uint8_t _UCSR0C;
+volatile uint8_t _UDR0;
+volatile uint8_t _UBRR0L;
+volatile uint8_t _UBRR0H;
+volatile uint8_t _ADCSRA;
+volatile uint8_t _ADCSRB;
+volatile uint8_t _ADMUX;
+volatile uint8_t _ADCL;
+volatile uint8_t _ADCH;
+volatile uint8_t _DIDR0;
+volatile uint8_t _DIDR1;
+volatile uint8_t _ACSR;
+volatile uint8_t _PCICR;
+volatile uint8_t _PCIFR;
+volatile uint8_t _PCMSK0;
+volatile uint8_t _PCMSK1;
+volatile uint8_t _PCMSK2;
+volatile uint8_t _EICRA;
+volatile uint8_t _EIMSK;
+volatile uint8_t _EIFR;
+volatile uint8_t _SPL;
+volatile uint8_t _SPH;
+volatile uint8_t _EECR;
+volatile uint8_t _EEDR;
+volatile uint8_t _EEARL;
+volatile uint8_t _EEARH;
+volatile uint8_t _WDTCSR;
+volatile uint16_t _TCNT1;
+volatile uint16_t _ICR1;
+volatile uint16_t _OCR1A;
+volatile uint16_t _OCR1B;
+volatile uint16_t _UBRR0;
+volatile uint16_t _SP;
+volatile uint16_t _EEAR;
+volatile uint16_t _ADC;
+
+}
+
+HostDevice *Host::devices[4];
+uint8_t Host::last_port[3];
+uint8_t Host::last_ddr[3];
+unsigned long Host::timer1_rest = 0;
+unsigned long long Host::cycles = 0;
+bool Host::in_isr = false;
+uint8_t Host::eeprom[1024];
+
+static volatile uint8_t *const port_regs[3] = { &_PORTB, &_PORTC, &_PORTD };
+static volatile uint8_t *const ddr_regs[3] = { &_DDRB, &_DDRC, &_DDRD };
+static volatile uint8_t *const pin_regs[3] = { &_PINB, &_PINC, &_PIND };
+
+/* Detaches all devices, erases the EEPROM. Registers are left alone */
+void Host::reset() {
+	memset(Host::devices, 0, sizeof(Host::devices));
+	memset(Host::eeprom, 0xFF, sizeof(Host::eeprom));
+}
+
+void Host::attach(HostDevice *device) {
+	for(int i = 0; i < 4; i++) {
+		if(!Host::devices[i]) {
+			Host::devices[i] = device;
+			return;
+		}
+	}
+}
+
+/* Timer1 counts at the prescaler set in TCCR1B, TOV1 is set when it wraps */
+void Host::timer1(unsigned long c) {
+	static const unsigned int div[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+	unsigned int d = div[_TCCR1B & 0x07];
+	unsigned long t;
+
+	if(!d)
+		return;
+
+	t = Host::timer1_rest + c;
+	Host::timer1_rest = t % d;
+	t = _TCNT1 + t / d;
+
+	if(t > 0xFFFF)
+		_TIFR1 |= _BV(TOV1);
+
+	_TCNT1 = t;
+}
+
+/* Advances the virtual clock, no interrupt point */
+void Host::run(unsigned long c) {
+	Host::cycles += c;
+	Host::timer1(c);
+}
+
+/* A SREG / PINx access, takes a few cycles */
+void Host::access() {
+	Host::run(HOST_ACCESS_CYCLES);
+	Host::poll();
+}
+
+/*
+ * Tells the devices about output changes and, with interrupts enabled,
+ * lets them interrupt.
+ */
+void Host::poll() {
+	bool changed = false;
+
+	for(int p = 0; p < 3; p++) {
+		if(*port_regs[p] != Host::last_port[p] || *ddr_regs[p] != Host::last_ddr[p]) {
+			Host::last_port[p] = *port_regs[p];
+			Host::last_ddr[p] = *ddr_regs[p];
+			changed = true;
+		}
+	}
+
+	for(int i = 0; i < 4; i++) {
+		if(changed && Host::devices[i])
+			Host::devices[i]->pins();
+	}
+
+	if(!(_SREG & 0x80) || Host::in_isr)
+		return;
+
+	if((_TIMSK1 & _BV(TOIE1)) && (_TIFR1 & _BV(TOV1)) && TIMER1_OVF_vect) {
+		_TIFR1 &= ~_BV(TOV1);
+		Host::isr(TIMER1_OVF_vect);
+	}
+
+	for(int i = 0; i < 4; i++) {
+		if(Host::devices[i]) {
+			Host::in_isr = true;
+			_SREG &= ~0x80;
+
+			Host::devices[i]->interrupt();
+
+			_SREG |= 0x80;
+			Host::in_isr = false;
+		}
+	}
+}
+
+/* Runs f as an ISR: I cleared, no other interrupt until it returns */
+void Host::isr(void (*f)(void)) {
+	uint8_t sreg = _SREG;
+	bool nested = Host::in_isr;
+
+	Host::in_isr = true;
+	_SREG &= ~0x80;
+
+	f();
+
+	_SREG = sreg;
+	Host::in_isr = nested;
+}
+
+/* Line levels of a port: outputs as written, inputs as driven (or pulled up) */
+uint8_t Host::pin_level(uint8_t port) {
+	uint8_t level = 0xFF;
+
+	for(int i = 0; i < 4; i++) {
+		if(Host::devices[i])
+			level &= Host::devices[i]->drive(port);
+	}
+
+	return (*port_regs[port] & *ddr_regs[port]) | (level & ~*ddr_regs[port]);
+}
+
+/* What the adapter puts on a pin: the output level, or 1 if it is an input */
+bool Host::output(uint8_t pin) {
+	uint8_t bit = _BV(HOST_PIN_BIT(pin));
+	uint8_t port = HOST_PIN_PORT(pin);
+
+	return !(*ddr_regs[port] & bit) || (*port_regs[port] & bit);
+}
+
+/* Line level of a pin, as read through PINx */
+bool Host::level(uint8_t pin) {
+	return Host::pin_level(HOST_PIN_PORT(pin)) & _BV(HOST_PIN_BIT(pin));
+}
+
+extern "C" {
+
+volatile uint8_t *host_pin(uint8_t port) {
+	uint8_t p = (port == 'B') ? HOST_PORT_B : ((port == 'C') ? HOST_PORT_C : HOST_PORT_D);
+
+	Host::access();
+
+	*pin_regs[p] = Host::pin_level(p);
+
+	return pin_regs[p];
+}
+
+volatile uint8_t *host_sreg(void) {
+	Host::access();
+
+	return &_SREG;
+}
+
+/* A STOP is sent right away, TWSTO is never seen set */
+volatile uint8_t *host_twcr(void) {
+	_TWCR &= ~_BV(TWSTO);
+
+	return &_TWCR;
+}
+
+/* EECR written: EERE reads, EEPE writes if EEMPE was set, at once (EEPE never reads back set) */
+void host_eecr(uint8_t set) {
+	if(set & _BV(EERE))
+		_EEDR = Host::eeprom[_EEAR & 0x3FF];
+
+	if((set & _BV(EEPE)) && (_EECR & _BV(EEMPE)))
+		Host::eeprom[_EEAR & 0x3FF] = _EEDR;
+
+	// EEMPE holds until EEPE, which is done at once
+	_EECR = (set & _BV(EEPE)) ? 0 : (set & _BV(EEMPE));
+}
+
+/* Long delays are cut in 8us slices, interrupts can come in between */
+void host_delay_cycles(unsigned long cycles) {
+	while(cycles) {
+		unsigned long c = (cycles > 64) ? 64 : cycles;
+
+		Host::run(c);
+		cycles -= c;
+
+		if(cycles)
+			Host::poll();
+	}
+}
+
+// Arduino core, what the firmware uses of it
+
+static volatile uint8_t *pin_port(uint8_t pin, volatile uint8_t *const *regs) {
+	return regs[HOST_PIN_PORT(pin)];
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	uint8_t sreg = SREG;
+
+	cli();
+
+	if(mode)
+		*pin_port(pin, ddr_regs) |= _BV(HOST_PIN_BIT(pin));
+	else
+		*pin_port(pin, ddr_regs) &= ~_BV(HOST_PIN_BIT(pin));
+
+	SREG = sreg;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+	uint8_t sreg = SREG;
+
+	cli();
+
+	if(value)
+		*pin_port(pin, port_regs) |= _BV(HOST_PIN_BIT(pin));
+	else
+		*pin_port(pin, port_regs) &= ~_BV(HOST_PIN_BIT(pin));
+
+	SREG = sreg;
+}
+
+int digitalRead(uint8_t pin) {
+	uint8_t port = HOST_PIN_PORT(pin);
+
+	return (*host_pin("BCD"[port]) & _BV(HOST_PIN_BIT(pin))) ? 1 : 0;
+}
+
+unsigned long micros(void) {
+	Host::access();
+
+	return Host::us();
+}
+
+unsigned long millis(void) {
+	Host::access();
+
+	return Host::us() / 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+	host_delay_cycles((unsigned long)us * (F_CPU / 1000000UL));
+}
+
+void delay(unsigned long ms) {
+	while(ms--)
+		host_delay_cycles(F_CPU / 1000UL);
+}
+
+// EEPROM, addresses are offsets into Host::eeprom
+
+uint8_t eeprom_read_byte(const uint8_t *addr) {
+	return Host::eeprom[(uintptr_t)addr & 0x3FF];
+}
+
+void eeprom_write_byte(uint8_t *addr, uint8_t value) {
+	Host::eeprom[(uintptr_t)addr & 0x3FF] = value;
+}
+
+void eeprom_update_byte(uint8_t *addr, uint8_t value) {
+	eeprom_write_byte(addr, value);
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t n) {
+	for(size_t i = 0; i < n; i++)
+		((uint8_t *)dst)[i] = eeprom_read_byte((const uint8_t *)src + i);
+}
+
+void eeprom_write_block(const void *src, void *dst, size_t n) {
+	for(size_t i = 0; i < n; i++)
+		eeprom_write_byte((uint8_t *)dst + i, ((const uint8_t *)src)[i]);
+}
+
+void eeprom_update_block(const void *src, void *dst, size_t n) {
+	eeprom_write_block(src, dst, n);
+}
+
+}
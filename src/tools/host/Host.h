@@ -0,0 +1,113 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Host build of the firmware
+--------------------------
+
+The firmware sources are built for the PC, unchanged, against the stand-in
+AVR headers in this directory (avr/, util/, compat/) and the real Wire /
+twi.c. This file is the glue: a virtual clock, interrupt points, pin level
+models and an EEPROM. The tests (wra-*-test.cpp, see Makefile) drive the
+firmware through it.
+
+Virtual clock. Host::cycles counts CPU cycles at F_CPU. DELAY_US(),
+_delay_us() and delayMicroseconds() advance it exactly, every SREG or PINx
+access advances it by HOST_ACCESS_CYCLES. It is only a rough guide to
+real time between delays: host code takes no cycles of its own. Timer1
+(TCNT1, TOV1 in TIFR1) counts from it, so Timebase works as on the chip.
+
+Interrupts. Every SREG access is an interrupt point. If the I bit is set,
+the attached devices' interrupt() run there, with I cleared, as an ISR
+would. Host::isr() runs a function the same way, from test code. The
+Timer1 overflow ISR runs there too when TIMSK1 enables it (PROFILER
+builds, see Timebase.h), no other timer interrupt is delivered.
+
+Pins. Reading PINB/C/D gives, for each pin, the PORT bit if it is an
+output, else the wired-AND of what the attached devices drive (1 is
+released, pulled up). Devices are told about output changes (pins()) at
+the next SREG or PINx access after them. digitalWriteFast() always goes
+through SREG on the host (the registers are above its 0x40 I/O range, see
+the Makefile), so every single write is seen.
+
+A device that wants the test to stop (script done) throws HostStop.
+*/
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include <stdint.h>
+
+// Cycles taken by a SREG / PINx access (a few instructions around it)
+#define HOST_ACCESS_CYCLES	4
+
+#define HOST_PORT_B	0
+#define HOST_PORT_C	1
+#define HOST_PORT_D	2
+
+/* Arduino pin number to port / bit, as on the ATmega328p */
+#define HOST_PIN_PORT(pin)	((pin) < 8 ? HOST_PORT_D : ((pin) < 14 ? HOST_PORT_B : HOST_PORT_C))
+#define HOST_PIN_BIT(pin)	((pin) < 8 ? (pin) : ((pin) < 14 ? (pin) - 8 : (pin) - 14))
+
+class HostDevice {
+
+public:
+	virtual ~HostDevice() { }
+
+	/* Adapter outputs or pull-ups changed, see Host::output() */
+	virtual void pins() { }
+
+	/* Levels driven on a port's pins, a 0 bit pulls the pin low */
+	virtual uint8_t drive(uint8_t port) { return 0xFF; }
+
+	/* Interrupt point with interrupts enabled */
+	virtual void interrupt() { }
+};
+
+class HostStop {
+};
+
+class Host {
+
+private:
+	static HostDevice *devices[4];
+	static uint8_t last_port[3], last_ddr[3];
+	static unsigned long timer1_rest;
+
+	static void timer1(unsigned long c);
+
+public:
+	static unsigned long long cycles;
+	static bool in_isr;
+
+	static void reset();
+	static void attach(HostDevice *device);
+	static void run(unsigned long c);
+	static void access();
+	static void poll();
+	static void isr(void (*f)(void));
+
+	static uint8_t pin_level(uint8_t port);
+	static bool output(uint8_t pin);
+	static bool level(uint8_t pin);
+	static unsigned long long us() { return Host::cycles / (F_CPU / 1000000UL); }
+
+	static uint8_t eeprom[1024];
+};
+
+#endif /* HOST_H_ */
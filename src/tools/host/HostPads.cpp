@@ -0,0 +1,413 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <avr/io.h>
+#include "Host.h"
+#include "HostPads.h"
+
+// Detect pins (DETPIN0..4 in wra.cpp): DB9 pins 2, 4, 6, 7, 9
+#define DB9_P2	3
+#define DB9_P4	5
+#define DB9_P6	6
+#define DB9_P7	7
+#define DB9_P9	8
+
+// NES / SNES (NESPad.h)
+#define NES_CLOCK	2
+#define NES_LATCH	3
+#define NES_DATA	4
+
+// N64 / GameCube (GCPad.cpp)
+#define JOYBUS_DATA	2
+
+// Genesis (genesis.cpp), DB9 pins
+#define GENESIS_P1	2
+#define GENESIS_P2	3
+#define GENESIS_P3	4
+#define GENESIS_P4	5
+#define GENESIS_P6	6
+#define GENESIS_P7	7
+#define GENESIS_P9	8
+
+// Six button pad count reset, in cycles (1.5ms)
+#define GENESIS_RESET	(1500UL * (F_CPU / 1000000UL))
+
+// Saturn (saturn.cpp)
+#define SATURN_D1	2
+#define SATURN_D0	3
+#define SATURN_S0	4
+#define SATURN_S1	6
+#define SATURN_D3	7
+#define SATURN_D2	8
+
+// TG16 (tg16.cpp)
+#define TG16_SELECT_PIN	7
+#define TG16_OE_PIN		8
+
+// PS2 (PS2Pad.h)
+#define PS2_DAT	2
+#define PS2_CMD	3
+#define PS2_ATT	4
+#define PS2_CLK	5
+
+HostPad::HostPad() {
+	memset(this->ground, 0, sizeof(this->ground));
+}
+
+void HostPad::tie(uint8_t pin) {
+	this->ground[HOST_PIN_PORT(pin)] |= _BV(HOST_PIN_BIT(pin));
+}
+
+void HostPad::put(uint8_t *levels, uint8_t pin, bool level) {
+	if(!level)
+		levels[HOST_PIN_PORT(pin)] &= ~_BV(HOST_PIN_BIT(pin));
+}
+
+uint8_t HostPad::drive(uint8_t port) {
+	return ~this->ground[port];
+}
+
+HostNesPad::HostNesPad() {
+	this->shift = 0;
+	this->clock = false;
+	this->buttons = 0;
+}
+
+HostNesPad::HostNesPad(bool snes) {
+	this->shift = 0;
+	this->clock = false;
+	this->buttons = 0;
+
+	// NES 00110: pin 9 to GND. SNES 00101: pin 7 to GND
+	this->tie(snes ? DB9_P7 : DB9_P9);
+}
+
+void HostNesPad::pins() {
+	bool clock = Host::output(NES_CLOCK);
+
+	if(Host::output(NES_LATCH))
+		this->shift = this->state();
+	else if(clock && !this->clock)
+		this->shift >>= 1;
+
+	this->clock = clock;
+}
+
+uint8_t HostNesPad::drive(uint8_t port) {
+	uint8_t levels[3] = { 0xFF, 0xFF, 0xFF };
+
+	this->put(levels, NES_DATA, !(this->shift & 1));
+
+	return levels[port] & HostPad::drive(port);
+}
+
+HostJoybusPad::HostJoybusPad(bool gc) {
+	this->gc = gc;
+	this->driven = false;
+	this->line = true;
+	this->initialized = false;
+	this->edges = 0;
+	this->count = this->at = 0;
+	this->reads = 0;
+
+	// GameCube 00011: pin 6 to GND. N64 00010: pins 6 and 9 to GND
+	memset(this->buttons, 0, sizeof(this->buttons));
+	this->tie(DB9_P6);
+
+	if(!gc)
+		this->tie(DB9_P9);
+	else
+		this->buttons[1] = 0x80;
+}
+
+/* PIND reads of GCPad_recv() for data, MSB first */
+void HostJoybusPad::reply(const uint8_t *data, uint8_t bits) {
+	this->count = this->at = 0;
+
+	for(uint8_t i = 0; i < bits; i++) {
+		bool bit = data[i / 8] & (0x80 >> (i % 8));
+
+		this->levels[this->count++] = 0;	// falling edge
+		this->levels[this->count++] = bit;	// sample point
+
+		if(i == bits - 1)
+			break;
+
+		if(!bit)
+			this->levels[this->count++] = 0;
+
+		this->levels[this->count++] = 1;	// back high
+	}
+}
+
+void HostJoybusPad::pins() {
+	static const uint8_t gc_id[3] = { 0x09, 0x00, 0x03 };
+	static const uint8_t n64_id[3] = { 0x05, 0x00, 0x02 };
+	bool driven = DDRD & _BV(JOYBUS_DATA);
+	bool line = Host::output(JOYBUS_DATA);
+
+	if(driven) {
+		if(this->line && !line)
+			this->edges++;
+
+		this->count = this->at = 0;
+	} else if(this->driven) {
+		if(this->edges > 16) {
+			this->reply(this->state(), 64);
+			this->reads++;
+		} else if(!this->initialized) {
+			this->reply(this->gc ? gc_id : n64_id, 24);
+			this->initialized = true;
+		} else {
+			this->reply(this->state(), 32);
+			this->reads++;
+		}
+
+		this->edges = 0;
+	}
+
+	this->driven = driven;
+	this->line = line;
+}
+
+uint8_t HostJoybusPad::drive(uint8_t port) {
+	uint8_t levels[3] = { 0xFF, 0xFF, 0xFF };
+
+	if(port == HOST_PORT_D && this->at < this->count)
+		this->put(levels, JOYBUS_DATA, this->levels[this->at++]);
+
+	return levels[port] & HostPad::drive(port);
+}
+
+HostNeoGeoPad::HostNeoGeoPad() {
+	// Neo Geo 00001: pins 6 and 7 to GND
+	this->tie(DB9_P6);
+	this->tie(DB9_P7);
+}
+
+HostGenesisPad::HostGenesisPad(bool six) {
+	this->six = six;
+	this->select = true;
+	this->edges = 0;
+	this->changed = 0;
+	this->buttons = 0;
+
+	// Genesis 00111: nothing to GND
+}
+
+/* SELECT falling edges since the count started over */
+uint8_t HostGenesisPad::phase() {
+	if(Host::cycles - this->changed > GENESIS_RESET)
+		return 0;
+
+	return this->edges;
+}
+
+void HostGenesisPad::pins() {
+	bool select = Host::output(GENESIS_P7);
+
+	if(select == this->select)
+		return;
+
+	this->edges = this->phase();
+
+	if(!select)
+		this->edges++;
+
+	this->select = select;
+	this->changed = Host::cycles;
+}
+
+uint8_t HostGenesisPad::drive(uint8_t port) {
+	uint8_t levels[3] = { 0xFF, 0xFF, 0xFF };
+	uint16_t s = this->state();
+	uint8_t phase = this->six ? this->phase() : 0;
+
+	if(this->select && phase == 3) {
+		this->put(levels, GENESIS_P1, !(s & 0x100));	// Z
+		this->put(levels, GENESIS_P2, !(s & 0x200));	// Y
+		this->put(levels, GENESIS_P3, !(s & 0x400));	// X
+		this->put(levels, GENESIS_P4, !(s & 0x800));	// MODE
+	} else if(this->select) {
+		this->put(levels, GENESIS_P1, !(s & 0x01));	// UP
+		this->put(levels, GENESIS_P2, !(s & 0x02));	// DOWN
+		this->put(levels, GENESIS_P3, !(s & 0x04));	// LEFT
+		this->put(levels, GENESIS_P4, !(s & 0x08));	// RIGHT
+	} else if(phase == 3) {
+		this->put(levels, GENESIS_P1, false);
+		this->put(levels, GENESIS_P2, false);
+		this->put(levels, GENESIS_P3, false);
+		this->put(levels, GENESIS_P4, false);
+	} else if(phase != 4) {
+		this->put(levels, GENESIS_P1, !(s & 0x01));	// UP
+		this->put(levels, GENESIS_P2, !(s & 0x02));	// DOWN
+		this->put(levels, GENESIS_P3, false);
+		this->put(levels, GENESIS_P4, false);
+	}
+
+	if(this->select) {
+		this->put(levels, GENESIS_P6, !(s & 0x10));	// B
+		this->put(levels, GENESIS_P9, !(s & 0x20));	// C
+	} else {
+		this->put(levels, GENESIS_P6, !(s & 0x40));	// A
+		this->put(levels, GENESIS_P9, !(s & 0x80));	// START
+	}
+
+	return levels[port] & HostPad::drive(port);
+}
+
+HostSaturnPad::HostSaturnPad() {
+	this->buttons = 0;
+
+	// Saturn 11111: pin 4 to GND
+	this->tie(DB9_P4);
+}
+
+uint8_t HostSaturnPad::drive(uint8_t port) {
+	static const uint8_t data[4] = { SATURN_D0, SATURN_D1, SATURN_D2, SATURN_D3 };
+	uint8_t levels[3] = { 0xFF, 0xFF, 0xFF };
+	uint16_t s = this->state();
+	uint8_t nibble;
+
+	// Line of the table in HostPads.h, S0 + 2 * S1
+	switch(Host::output(SATURN_S0) | (Host::output(SATURN_S1) << 1)) {
+	case 0:
+		nibble = s & 0x0F;			// Z Y X R
+		break;
+	case 1:
+		nibble = (s >> 4) & 0x0F;	// B C A START
+		break;
+	case 2:
+		nibble = (s >> 8) & 0x0F;	// UP DOWN LEFT RIGHT
+		break;
+	default:
+		nibble = 0x03 | ((s >> 9) & 0x08);	// 0 0 1 L
+		break;
+	}
+
+	for(uint8_t i = 0; i < 4; i++)
+		this->put(levels, data[i], !(nibble & (1 << i)));
+
+	return levels[port] & HostPad::drive(port);
+}
+
+HostTg16Pad::HostTg16Pad() {
+	this->buttons = 0;
+
+	// TG16 11011: pin 2 to GND, the data pins are low with /OE high
+	this->tie(DB9_P2);
+}
+
+uint8_t HostTg16Pad::drive(uint8_t port) {
+	static const uint8_t data[4] = { 2, 4, 5, 6 };
+	uint8_t levels[3] = { 0xFF, 0xFF, 0xFF };
+	uint8_t nibble = 0x0F;
+
+	if(!Host::output(TG16_OE_PIN))
+		nibble = Host::output(TG16_SELECT_PIN) ? this->state() & 0x0F : this->state() >> 4;
+
+	for(uint8_t i = 0; i < 4; i++)
+		this->put(levels, data[i], !(nibble & (1 << i)));
+
+	return levels[port] & HostPad::drive(port);
+}
+
+HostPs2Pad::HostPs2Pad() {
+	static const uint8_t released[6] = { 0xFF, 0xFF, 0x80, 0x80, 0x80, 0x80 };
+
+	this->att = this->clock = true;
+	this->started = false;
+	this->analog = this->config = false;
+	this->at = this->bit = 0;
+	this->polls = 0;
+	memset(this->cmd, 0, sizeof(this->cmd));
+	memcpy(this->buttons, released, sizeof(this->buttons));
+
+	// PS2 00100: pins 7 and 9 to GND
+	this->tie(DB9_P7);
+	this->tie(DB9_P9);
+}
+
+/* Byte i of the reply to the packet going on, 0xFF past its end */
+uint8_t HostPs2Pad::reply(uint8_t i) {
+	static const uint8_t type[6] = { 0x03, 0x02, 0x00, 0x02, 0x01, 0x00 };
+	uint8_t length = this->analog ? 9 : 5;
+
+	if(i == 0)
+		return 0xFF;
+	if(i == 1)
+		return this->config ? 0xF3 : (this->analog ? 0x73 : 0x41);
+	if(i == 2)
+		return 0x5A;
+
+	if(this->config) {
+		if(i >= 9)
+			return 0xFF;
+
+		return (this->cmd[1] == 0x45) ? type[i - 3] : 0x00;
+	}
+
+	if(i >= length || (this->cmd[1] != 0x42 && this->cmd[1] != 0x43))
+		return 0xFF;
+
+	return this->state()[i - 3];
+}
+
+void HostPs2Pad::pins() {
+	bool att = Host::output(PS2_ATT);
+	bool clock = Host::output(PS2_CLK);
+
+	if(!att && this->att) {
+		this->at = this->bit = 0;
+		this->started = false;
+		memset(this->cmd, 0, sizeof(this->cmd));
+	} else if(att && !this->att) {
+		// End of the packet: the mode changes
+		if(this->cmd[1] == 0x42)
+			this->polls++;
+		else if(this->cmd[1] == 0x43)
+			this->config = this->cmd[3] == 0x01;
+		else if(this->cmd[1] == 0x44 && this->config)
+			this->analog = this->cmd[3] == 0x01;
+	} else if(!att && this->at < sizeof(this->cmd)) {
+		if(!clock && this->clock) {
+			// Bit 0 is out from ATT low on, the first edge keeps it
+			if(this->started && ++this->bit == 8) {
+				this->bit = 0;
+				this->at++;
+			}
+
+			this->started = true;
+		} else if(clock && !this->clock && Host::output(PS2_CMD)) {
+			this->cmd[this->at] |= 1 << this->bit;
+		}
+	}
+
+	this->att = att;
+	this->clock = clock;
+}
+
+uint8_t HostPs2Pad::drive(uint8_t port) {
+	uint8_t levels[3] = { 0xFF, 0xFF, 0xFF };
+
+	if(!this->att && this->at < sizeof(this->cmd))
+		this->put(levels, PS2_DAT, this->reply(this->at) & (1 << this->bit));
+
+	return levels[port] & HostPad::drive(port);
+}
@@ -0,0 +1,234 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Pad models
+----------
+
+Pads on the DB9 port, as HostDevices. Each one grounds the detect pins its
+cable does (see detectPad() in wra.cpp) and answers the adapter's pad
+protocol on the pad pins.
+
+state() is what is held down, sampled whenever the pad latches it. Tests
+override it to press buttons at given times.
+*/
+
+#ifndef HOST_PADS_H_
+#define HOST_PADS_H_
+
+#include <stdint.h>
+#include "Host.h"
+
+class HostPad : public HostDevice {
+
+protected:
+	uint8_t ground[3];	// detect pins tied to GND, per port
+
+	void tie(uint8_t pin);
+	void put(uint8_t *levels, uint8_t pin, bool level);
+
+public:
+	HostPad();
+
+	virtual uint8_t drive(uint8_t port);
+};
+
+/*
+NES / SNES: a 4021 shift register. LATCH high loads the buttons, each
+CLOCK rising edge shifts the next one onto DATA (low = pressed). Bit 0 of
+state() comes out first, then bits 1..15, then released.
+*/
+class HostNesPad : public HostPad {
+
+private:
+	uint16_t shift;
+	bool clock;
+
+protected:
+	HostNesPad();
+
+public:
+	uint16_t buttons;
+
+	HostNesPad(bool snes);
+
+	virtual uint16_t state() { return this->buttons; }
+
+	virtual void pins();
+	virtual uint8_t drive(uint8_t port);
+};
+
+/*
+N64 / GameCube: one open collector data line (pin 2), commands from the
+adapter, then the pad's reply.
+
+GCPad_send() / GCPad_recv() are timed with nops, which take no virtual
+time, so the line can't be modelled in time. The pad goes by what the
+adapter does instead: it counts the falling edges while the adapter drives
+the line, and when the adapter lets go it answers each PIND read with what
+GCPad_recv() would see there (each bit is a falling edge, the bit at the
+sample point, then back high). The command is told by its length: 25
+edges is a GameCube status read (0x40 0x03 0x00), a 9 edge one is the
+init (0x00) the first time, then an N64 status read (0x01).
+
+The reply to a status read is state(), the 8 (GameCube) or the first 4
+(N64) bytes as they go on the wire. reads counts the status reads
+answered so far.
+*/
+class HostJoybusPad : public HostPad {
+
+private:
+	bool gc;
+	bool driven, line, initialized;
+	uint8_t edges;
+	uint8_t levels[4 * 64];
+	unsigned int count, at;
+
+	void reply(const uint8_t *data, uint8_t bits);
+
+public:
+	uint8_t buttons[8];
+	unsigned long reads;
+
+	HostJoybusPad(bool gc);
+
+	virtual const uint8_t *state() { return this->buttons; }
+
+	virtual void pins();
+	virtual uint8_t drive(uint8_t port);
+};
+
+/*
+Neo Geo: the cable's shift registers read like a SNES pad, 16 bits (see
+neogeo_loop() in wra.cpp for which is which). Pins 6 and 7 to GND.
+*/
+class HostNeoGeoPad : public HostNesPad {
+
+public:
+	HostNeoGeoPad();
+};
+
+/*
+Genesis: SELECT (DB9 pin 7) picks what pins 1-4, 6 and 9 show (low =
+pressed), state() is in the GENESIS_* layout of genesis.h:
+
+  SELECT high   UP DOWN LEFT RIGHT B C
+  SELECT low    UP DOWN 0 0 A START
+
+A six button pad counts the SELECT falling edges: after the third one it
+shows 0 0 0 0 on pins 1-4, and on the high after it Z Y X MODE. The count
+starts over once SELECT has not changed for 1.5ms.
+*/
+class HostGenesisPad : public HostPad {
+
+private:
+	bool six, select;
+	uint8_t edges;
+	unsigned long long changed;
+
+	uint8_t phase();
+
+public:
+	uint16_t buttons;
+
+	HostGenesisPad(bool six);
+
+	virtual uint16_t state() { return this->buttons; }
+
+	virtual void pins();
+	virtual uint8_t drive(uint8_t port);
+};
+
+/*
+Saturn: S0 (DB9 pin 3) and S1 (pin 6) pick what D0-D3 show (low =
+pressed), state() is in the SATURN_* layout of saturn.h:
+
+  S0 S1    D0 D1 D2 D3
+  0  0     Z  Y  X  R
+  1  0     B  C  A  START
+  0  1     UP DOWN LEFT RIGHT
+  1  1     0  0  1  L
+
+Pin 4 to GND (detects as 11111 with the pull-ups on S0 and S1).
+*/
+class HostSaturnPad : public HostPad {
+
+public:
+	uint16_t buttons;
+
+	HostSaturnPad();
+
+	virtual uint16_t state() { return this->buttons; }
+
+	virtual uint8_t drive(uint8_t port);
+};
+
+/*
+TurboGrafx 16: a 74HC157 behind /OE (DB9 pin 9) and SELECT (7). /OE high
+puts all four data pins low, else SELECT high shows UP RIGHT DOWN LEFT and
+low I II SELECT RUN (low = pressed). Bit i of state() is button i of
+tg16.h (TG16_UP .. TG16_RUN). Pin 2 to GND.
+*/
+class HostTg16Pad : public HostPad {
+
+public:
+	uint16_t buttons;
+
+	HostTg16Pad();
+
+	virtual uint16_t state() { return this->buttons; }
+
+	virtual uint8_t drive(uint8_t port);
+};
+
+/*
+PS2: a DualShock on ATT (DB9 pin 3), CLK (4), CMD (2) and DAT (1), LSB
+first. The pad puts a bit on DAT when CLK falls and takes the CMD bit
+when it rises; ATT low starts a packet.
+
+It answers the commands PS2Pad uses: 0x42 poll (and 0x43 outside config
+mode), 0x43 enter / exit config, 0x44 analog on / off, 0x45 type (0x03,
+a DualShock). It starts in digital mode (0x41), config mode is 0xF3. A
+poll gets the 6 bytes of state() after 0xFF, the mode and 0x5A, as they
+go on the wire: the buttons (low = pressed, PSB_* of PS2Pad.h), then RX
+RY LX LY, which a pad in digital mode leaves out. polls counts them.
+Pins 7 and 9 to GND.
+*/
+class HostPs2Pad : public HostPad {
+
+private:
+	bool att, clock, started;
+	bool analog, config;
+	uint8_t at, bit;
+	uint8_t cmd[32];
+
+	uint8_t reply(uint8_t i);
+
+public:
+	uint8_t buttons[6];
+	unsigned long polls;
+
+	HostPs2Pad();
+
+	virtual const uint8_t *state() { return this->buttons; }
+
+	virtual void pins();
+	virtual uint8_t drive(uint8_t port);
+};
+
+#endif /* HOST_PADS_H_ */
@@ -0,0 +1,165 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <avr/io.h>
+#include <util/twi.h>
+#include "Host.h"
+#include "HostTwi.h"
+
+extern "C" void TWI_vect(void);
+
+#define TWI_IDLE	0
+#define TWI_SRX		1	// adapter is receiving
+#define TWI_STX		2	// adapter is sending
+#define TWI_STX_END	3	// adapter sent its last byte, master still reading
+
+uint8_t HostTwi::state = TWI_IDLE;
+bool HostTwi::more = false;
+bool HostTwi::held = false;
+void (*HostTwi::on_hold)() = 0;
+
+/* Bus event seen by the TWI unit, the firmware ISR handles it */
+void HostTwi::event(uint8_t status) {
+	TWSR = status;
+	_TWCR |= _BV(TWINT);
+
+	Host::isr(TWI_vect);
+
+	// Left with the interrupt off: SCL held low, the event is still pending
+	HostTwi::held = !(_TWCR & _BV(TWIE));
+}
+
+/* Runs the held event again once the firmware let it go, true if not held */
+bool HostTwi::resume() {
+	if(!HostTwi::held)
+		return true;
+
+	if(!(_TWCR & _BV(TWIE)))
+		return false;
+
+	HostTwi::event(TWSR);
+
+	if(!HostTwi::held && HostTwi::state == TWI_STX)
+		HostTwi::more = _TWCR & _BV(TWEA);
+
+	return !HostTwi::held;
+}
+
+/* Lets on_hold() run the main loop if the bus is held, true if free then */
+bool HostTwi::wait() {
+	if(HostTwi::resume())
+		return true;
+
+	if(HostTwi::on_hold)
+		HostTwi::on_hold();
+
+	return HostTwi::resume();
+}
+
+bool HostTwi::start(bool read) {
+	if(HostTwi::held)
+		return false;
+
+	HostTwi::state = TWI_IDLE;
+
+	if((_TWAR >> 1) != HOST_TWI_ADDRESS || !(_TWCR & _BV(TWEN)) || !(_TWCR & _BV(TWEA)))
+		return false;
+
+	if(read) {
+		HostTwi::state = TWI_STX;
+		HostTwi::event(TW_ST_SLA_ACK);
+		if(!HostTwi::held)
+			HostTwi::more = _TWCR & _BV(TWEA);
+	} else {
+		HostTwi::state = TWI_SRX;
+		HostTwi::event(TW_SR_SLA_ACK);
+	}
+
+	return true;
+}
+
+bool HostTwi::write(uint8_t data) {
+	if(HostTwi::state != TWI_SRX)
+		return false;
+
+	TWDR = data;
+
+	if(!(_TWCR & _BV(TWEA))) {
+		HostTwi::event(TW_SR_DATA_NACK);
+		HostTwi::state = TWI_IDLE;
+		return false;
+	}
+
+	HostTwi::event(TW_SR_DATA_ACK);
+
+	return true;
+}
+
+uint8_t HostTwi::read(bool ack) {
+	uint8_t data;
+
+	if(HostTwi::state != TWI_STX)
+		return 0xFF;
+
+	data = TWDR;
+
+	if(!ack) {
+		HostTwi::event(TW_ST_DATA_NACK);
+		HostTwi::state = TWI_IDLE;
+	} else if(HostTwi::more) {
+		HostTwi::event(TW_ST_DATA_ACK);
+		HostTwi::more = _TWCR & _BV(TWEA);
+	} else {
+		HostTwi::event(TW_ST_LAST_DATA);
+		HostTwi::state = TWI_STX_END;
+	}
+
+	return data;
+}
+
+void HostTwi::stop() {
+	if(HostTwi::state == TWI_SRX)
+		HostTwi::event(TW_SR_STOP);
+
+	HostTwi::state = TWI_IDLE;
+}
+
+/* Writes n bytes from register addr on, as the Wiimote does */
+bool HostTwi::write_regs(uint8_t addr, const uint8_t *data, uint8_t n) {
+	bool ack = HostTwi::start(false) && HostTwi::write(addr);
+
+	for(uint8_t i = 0; ack && i < n; i++)
+		ack = HostTwi::write(data[i]);
+
+	HostTwi::stop();
+
+	return HostTwi::wait() && ack;
+}
+
+/* Sets the register address, then reads n bytes from it */
+bool HostTwi::read_regs(uint8_t addr, uint8_t *data, uint8_t n) {
+	if(!HostTwi::write_regs(addr, 0, 0) || !HostTwi::start(true) || !HostTwi::wait())
+		return false;
+
+	for(uint8_t i = 0; i < n; i++)
+		data[i] = HostTwi::read(i < n - 1);
+
+	HostTwi::stop();
+
+	return true;
+}
@@ -0,0 +1,76 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Wiimote side of the I2C bus
+---------------------------
+
+Plays the TWI peripheral and the bus master. Each bus event sets TWSR (and
+TWDR) as the chip does and runs the firmware's TWI ISR (twi.c), so Wire
+and WMExtension run unchanged. The slave ACKs when the ISR left TWEA set.
+
+start(read)   START and SLA+R/W, false if the adapter doesn't ACK
+write(data)   one byte to the adapter, false if it NACKs
+read(ack)     one byte from the adapter, ack if the master wants more
+              (0xFF once the adapter has nothing left to send)
+stop()        STOP
+
+write_regs() / read_regs() are whole Wiimote transactions, all in one go
+(no main loop code runs between the bytes). Timed transfers, with the
+main loop running between the bytes, are built on the calls above (see
+HostWiimote.h).
+
+The ISR holds the bus (SCL low) by returning with TWIE off, as twi.c does
+while TWINT is still set. held is set then, and resume() runs the ISR
+again on the same event once the firmware has turned TWIE back on, true
+when the bus is free. start() fails on a held bus. write_regs() and
+read_regs() call on_hold() (the main loop, as the test sees it) when the
+bus is held and fail if it is still held after that.
+*/
+
+#ifndef HOST_TWI_H_
+#define HOST_TWI_H_
+
+#include <stdint.h>
+
+#define HOST_TWI_ADDRESS	0x52
+
+class HostTwi {
+
+private:
+	static uint8_t state;
+	static bool more;
+
+	static void event(uint8_t status);
+	static bool wait();
+
+public:
+	static bool held;
+	static void (*on_hold)();
+
+	static bool resume();
+	static bool start(bool read);
+	static bool write(uint8_t data);
+	static uint8_t read(bool ack);
+	static void stop();
+
+	static bool write_regs(uint8_t addr, const uint8_t *data, uint8_t n);
+	static bool read_regs(uint8_t addr, uint8_t *data, uint8_t n);
+};
+
+#endif /* HOST_TWI_H_ */
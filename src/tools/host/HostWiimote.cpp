@@ -0,0 +1,205 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <avr/io.h>
+#include "Host.h"
+#include "HostTwi.h"
+#include "HostWiimote.h"
+
+#define W_START_W	0
+#define W_START_R	1
+#define W_WRITE		2
+#define W_READ		3	// data: ACK the byte
+#define W_STOP		4
+#define W_STOP_READ	5	// data: register address, hands the bytes to on_read
+
+HostWiimote::HostWiimote() {
+	this->head = this->tail = 0;
+	this->active = false;
+	this->due = this->requested = this->free_at = 0;
+	this->next_poll = this->started = this->bus_time = this->held_at = 0;
+	this->count = 0;
+
+	this->rate = 400000;
+	this->poll_us = 0;
+	this->length = 6;
+	this->on_read = 0;
+
+	this->transactions = this->nacks = 0;
+	this->stretch_max = this->service_max = 0;
+}
+
+void HostWiimote::push(uint8_t what, uint8_t data) {
+	if(this->idle() && !this->active)
+		this->requested = Host::cycles;
+
+	this->queue[this->tail].what = what;
+	this->queue[this->tail].data = data;
+	this->tail = (this->tail + 1) % HOST_WIIMOTE_QUEUE;
+
+	if(this->tail == this->head)
+		abort(); // a test queued way too much
+}
+
+/* Writes n bytes from register addr on */
+void HostWiimote::write(uint8_t addr, const uint8_t *data, uint8_t n) {
+	this->push(W_START_W, 0);
+	this->push(W_WRITE, addr);
+
+	for(uint8_t i = 0; i < n; i++)
+		this->push(W_WRITE, data[i]);
+
+	this->push(W_STOP, 0);
+}
+
+/* Sets the register address, then reads n bytes from it */
+void HostWiimote::read(uint8_t addr, uint8_t n) {
+	this->push(W_START_W, 0);
+	this->push(W_WRITE, addr);
+	this->push(W_STOP, 0);
+	this->push(W_START_R, 0);
+
+	for(uint8_t i = 0; i < n; i++)
+		this->push(W_READ, i < n - 1);
+
+	this->push(W_STOP_READ, addr);
+}
+
+unsigned long HostWiimote::bits(uint8_t what) {
+	switch(what) {
+	case W_START_W:
+	case W_START_R:
+		return 10;
+	case W_STOP:
+	case W_STOP_READ:
+		return 1;
+	default:
+		return 9;
+	}
+}
+
+/* Puts one event on the bus, false if the adapter NACKs it */
+bool HostWiimote::event(Event &e) {
+	switch(e.what) {
+	case W_START_W:
+		return HostTwi::start(false);
+	case W_START_R:
+		this->count = 0;
+		return HostTwi::start(true);
+	case W_WRITE:
+		return HostTwi::write(e.data);
+	case W_READ:
+		if(this->count < sizeof(this->buffer))
+			this->buffer[this->count++] = HostTwi::read(e.data);
+		else
+			HostTwi::read(e.data);
+		return true;
+	case W_STOP_READ:
+		HostTwi::stop();
+		if(this->on_read)
+			this->on_read(e.data, this->buffer, this->count);
+		return true;
+	default:
+		HostTwi::stop();
+		return true;
+	}
+}
+
+/* The adapter didn't ACK: the Wiimote gives up up to the next STOP */
+void HostWiimote::nack() {
+	this->nacks++;
+
+	while(!this->idle()) {
+		uint8_t what = this->queue[this->head].what;
+
+		if(what == W_STOP || what == W_STOP_READ)
+			return;
+
+		this->head = (this->head + 1) % HOST_WIIMOTE_QUEUE;
+	}
+}
+
+void HostWiimote::interrupt() {
+	unsigned long long now = Host::cycles;
+
+	if(this->poll_us && this->idle() && !this->active && now >= this->next_poll) {
+		this->read(0x00, this->length);
+		this->requested = this->next_poll;
+
+		this->next_poll += this->poll_us * (F_CPU / 1000000UL);
+		if(this->next_poll < now)
+			this->next_poll = now;
+	}
+
+	while(!this->idle()) {
+		Event e = this->queue[this->head];
+
+		if(!this->active) {
+			this->active = true;
+			this->started = (this->requested > this->free_at) ? this->requested : this->free_at;
+			this->due = this->started + this->bits(e.what) * this->bit_cycles();
+			this->bus_time = 0;
+		}
+
+		if(now < this->due)
+			return;
+
+		// Adapter holding the bus (SCL low) since the last event, this one's
+		// bits start once it lets go
+		if(HostTwi::held) {
+			if(!HostTwi::resume())
+				return;
+
+			now = Host::cycles;
+
+			if(now - this->held_at > this->stretch_max)
+				this->stretch_max = now - this->held_at;
+
+			this->due = now + this->bits(e.what) * this->bit_cycles();
+			continue;
+		}
+
+		if(now - this->due > this->stretch_max)
+			this->stretch_max = now - this->due;
+
+		this->bus_time += this->bits(e.what) * this->bit_cycles();
+		this->head = (this->head + 1) % HOST_WIIMOTE_QUEUE;
+
+		if(!this->event(e))
+			this->nack();
+
+		// The ISR ran in there, the next bits start once it is done
+		now = Host::cycles;
+
+		if(HostTwi::held)
+			this->held_at = now;
+
+		if(e.what == W_STOP || e.what == W_STOP_READ) {
+			this->transactions++;
+			if(now - this->started - this->bus_time > this->service_max)
+				this->service_max = now - this->started - this->bus_time;
+
+			this->active = false;
+			this->free_at = now;
+			this->requested = now;
+		} else if(!this->idle()) {
+			this->due = now + this->bits(this->queue[this->head].what) * this->bit_cycles();
+		}
+	}
+}
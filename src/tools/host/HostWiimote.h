@@ -0,0 +1,104 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Timed Wiimote
+-------------
+
+The Wiimote as a HostDevice, for timing. Transactions are queued and
+clocked out one bus event at a time from interrupt points, so the main
+loop runs between the bytes as it does on the real bus:
+
+ START + address     10 bit times
+ data byte           9 bit times (8 bits and the ACK)
+ STOP                1 bit time
+
+An event is due once its bits have gone by. If the adapter can't take it
+then (interrupts off, no interrupt point yet), SCL is held low until it
+does: that wait is the clock stretching, and the bytes after it move
+later by as much. The same goes for the adapter holding the bus after an
+event (HostTwi::held), up to when it lets go.
+
+rate      bus clock, 400kHz by default
+poll_us   fetch interval: when set, a report read (length bytes from 0x00)
+          is queued every poll_us, or as soon as the bus is free after
+on_read   called with the data of every read, when its STOP goes out
+
+Times are Host::cycles, so they are only as good as the virtual clock
+(see Host.h): a model of the firmware timing, not a measurement.
+*/
+
+#ifndef HOST_WIIMOTE_H_
+#define HOST_WIIMOTE_H_
+
+#include <stdint.h>
+#include "Host.h"
+
+#define HOST_WIIMOTE_QUEUE	4096
+
+class HostWiimote : public HostDevice {
+
+private:
+	struct Event {
+		uint8_t what;
+		uint8_t data;
+	};
+
+	Event queue[HOST_WIIMOTE_QUEUE];
+	unsigned int head, tail;
+
+	bool active;					// a transaction is on the bus
+	unsigned long long due;			// when the next event's bits are done
+	unsigned long long requested;	// when the Wiimote wanted the bus
+	unsigned long long free_at;		// end of the last transaction
+	unsigned long long next_poll;
+	unsigned long long started;		// START of the transaction
+	unsigned long long bus_time;	// its bits, without stretching
+	unsigned long long held_at;		// when the adapter held the bus
+
+	uint8_t buffer[32];
+	uint8_t count;
+
+	void push(uint8_t what, uint8_t data);
+	unsigned long bits(uint8_t what);
+	bool event(Event &e);
+	void nack();
+
+public:
+	unsigned long rate;
+	unsigned long poll_us;
+	uint8_t length;
+	void (*on_read)(uint8_t addr, const uint8_t *data, uint8_t n);
+
+	// Statistics, in cycles
+	unsigned long transactions;
+	unsigned long nacks;
+	unsigned long long stretch_max;	// longest wait for the adapter on one event
+	unsigned long long service_max;	// longest transaction, beyond its bus time
+
+	HostWiimote();
+
+	void write(uint8_t addr, const uint8_t *data, uint8_t n);
+	void read(uint8_t addr, uint8_t n);
+	bool idle() { return this->head == this->tail; }
+	unsigned long long bit_cycles() { return F_CPU / this->rate; }
+
+	virtual void interrupt();
+};
+
+#endif /* HOST_WIIMOTE_H_ */
@@ -0,0 +1,57 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Host stand-in for <avr/interrupt.h>, see Host.h. ISRs are plain functions */
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define sei()	(SREG |= 0x80)
+#define cli()	(SREG &= ~0x80)
+
+#ifdef __cplusplus
+#define ISR(vector, ...)	extern "C" void vector(void)
+#else
+#define ISR(vector, ...)	void vector(void)
+#endif
+
+#define SIGNAL(vector)			ISR(vector)
+#define EMPTY_INTERRUPT(vector)	ISR(vector) { }
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+#define ISR_ALIASOF(vector)
+
+#define INT0_vect			INT0_vect
+#define INT1_vect			INT1_vect
+#define PCINT0_vect			PCINT0_vect
+#define PCINT1_vect			PCINT1_vect
+#define PCINT2_vect			PCINT2_vect
+#define TIMER0_OVF_vect		TIMER0_OVF_vect
+#define TIMER1_CAPT_vect	TIMER1_CAPT_vect
+#define TIMER1_OVF_vect		TIMER1_OVF_vect
+#define TIMER2_COMPA_vect	TIMER2_COMPA_vect
+#define TIMER2_OVF_vect		TIMER2_OVF_vect
+#define USART_RX_vect		USART_RX_vect
+#define USART_UDRE_vect		USART_UDRE_vect
+#define TWI_vect			TWI_vect
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
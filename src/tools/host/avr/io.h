@@ -0,0 +1,490 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Host stand-in for <avr/io.h>
+----------------------------
+
+The ATmega328p / 168 registers the firmware touches, as plain variables
+(defined in Host.cpp), so firmware sources build unchanged with the host
+compiler (see Host.h). A few are accessed through a function so the host
+side sees every access:
+
+  PINB / PINC / PIND  levels computed from the adapter outputs and the
+                      attached pad / bus models
+  SREG                an interrupt point (pending interrupts run here if
+                      the I bit is set) and where output changes are seen
+  TWCR                TWSTO clears by itself, as on the chip
+  EECR                EERE reads Host::eeprom[EEAR] into EEDR, EEPE after
+                      EEMPE writes EEDR there, done at once (C++ only)
+
+TIFR1 / TIFR2 clear the flags written as 1, as on the chip (C++ only, the
+C sources don't touch them). Timer1 (TCNT1, TIFR1 TOV1) follows the
+virtual clock. Everything else only
+holds what was written.
+*/
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+volatile uint8_t *host_pin(uint8_t port);
+volatile uint8_t *host_sreg(void);
+volatile uint8_t *host_twcr(void);
+void host_eecr(uint8_t set);
+void host_delay_cycles(unsigned long cycles);
+
+extern volatile uint8_t _PINB;
+extern volatile uint8_t _PINC;
+extern volatile uint8_t _PIND;
+extern volatile uint8_t _PORTB;
+extern volatile uint8_t _PORTC;
+extern volatile uint8_t _PORTD;
+extern volatile uint8_t _DDRB;
+extern volatile uint8_t _DDRC;
+extern volatile uint8_t _DDRD;
+extern volatile uint8_t _TWBR;
+extern volatile uint8_t _TWSR;
+extern volatile uint8_t _TWAR;
+extern volatile uint8_t _TWDR;
+extern volatile uint8_t _TWCR;
+extern volatile uint8_t _TWAMR;
+extern volatile uint8_t _SREG;
+extern volatile uint8_t _MCUSR;
+extern volatile uint8_t _MCUCR;
+extern volatile uint8_t _SMCR;
+extern volatile uint8_t _PRR;
+extern volatile uint8_t _CLKPR;
+extern volatile uint8_t _OSCCAL;
+extern volatile uint8_t _TCCR0A;
+extern volatile uint8_t _TCCR0B;
+extern volatile uint8_t _TIMSK0;
+extern volatile uint8_t _TIFR0;
+extern volatile uint8_t _TCNT0;
+extern volatile uint8_t _OCR0A;
+extern volatile uint8_t _OCR0B;
+extern volatile uint8_t _TCCR1A;
+extern volatile uint8_t _TCCR1B;
+extern volatile uint8_t _TCCR1C;
+extern volatile uint8_t _TIMSK1;
+extern volatile uint8_t _TIFR1;
+extern volatile uint8_t _TCNT1L;
+extern volatile uint8_t _TCNT1H;
+extern volatile uint8_t _ICR1L;
+extern volatile uint8_t _ICR1H;
+extern volatile uint8_t _OCR1AL;
+extern volatile uint8_t _OCR1AH;
+extern volatile uint8_t _OCR1BL;
+extern volatile uint8_t _OCR1BH;
+extern volatile uint8_t _TCCR2A;
+extern volatile uint8_t _TCCR2B;
+extern volatile uint8_t _TIMSK2;
+extern volatile uint8_t _TIFR2;
+extern volatile uint8_t _TCNT2;
+extern volatile uint8_t _OCR2A;
+extern volatile uint8_t _OCR2B;
+extern volatile uint8_t _ASSR;
+extern volatile uint8_t _GTCCR;
+extern volatile uint8_t _UCSR0A;
+extern volatile uint8_t _UCSR0B;
+extern volatile uint8_t _UCSR0C;
+extern volatile uint8_t _UDR0;
+extern volatile uint8_t _UBRR0L;
+extern volatile uint8_t _UBRR0H;
+extern volatile uint8_t _ADCSRA;
+extern volatile uint8_t _ADCSRB;
+extern volatile uint8_t _ADMUX;
+extern volatile uint8_t _ADCL;
+extern volatile uint8_t _ADCH;
+extern volatile uint8_t _DIDR0;
+extern volatile uint8_t _DIDR1;
+extern volatile uint8_t _ACSR;
+extern volatile uint8_t _PCICR;
+extern volatile uint8_t _PCIFR;
+extern volatile uint8_t _PCMSK0;
+extern volatile uint8_t _PCMSK1;
+extern volatile uint8_t _PCMSK2;
+extern volatile uint8_t _EICRA;
+extern volatile uint8_t _EIMSK;
+extern volatile uint8_t _EIFR;
+extern volatile uint8_t _SPL;
+extern volatile uint8_t _SPH;
+extern volatile uint8_t _EECR;
+extern volatile uint8_t _EEDR;
+extern volatile uint8_t _EEARL;
+extern volatile uint8_t _EEARH;
+extern volatile uint8_t _WDTCSR;
+extern volatile uint16_t _TCNT1;
+extern volatile uint16_t _ICR1;
+extern volatile uint16_t _OCR1A;
+extern volatile uint16_t _OCR1B;
+extern volatile uint16_t _UBRR0;
+extern volatile uint16_t _SP;
+extern volatile uint16_t _EEAR;
+extern volatile uint16_t _ADC;
+
+#ifdef __cplusplus
+}
+
+/* Interrupt flag register: writing a 1 clears that flag */
+class HostFlags {
+	volatile uint8_t *reg;
+
+public:
+	HostFlags(volatile uint8_t *r) : reg(r) { }
+	operator uint8_t() const { return *reg; }
+	HostFlags &operator=(uint8_t v) { *reg &= ~v; return *this; }
+};
+
+/* EEPROM control register, the bits set go to host_eecr() */
+class HostEecr {
+
+public:
+	operator uint8_t() const { return _EECR; }
+	HostEecr &operator|=(uint8_t v) { host_eecr(_EECR | v); return *this; }
+	HostEecr &operator=(uint8_t v) { host_eecr(v); return *this; }
+};
+
+extern HostEecr host_eecr_reg;
+#endif
+
+#define PINB    (*host_pin('B'))
+#define PINC    (*host_pin('C'))
+#define PIND    (*host_pin('D'))
+#define PORTB   _PORTB
+#define PORTC   _PORTC
+#define PORTD   _PORTD
+#define DDRB    _DDRB
+#define DDRC    _DDRC
+#define DDRD    _DDRD
+#define TWBR    _TWBR
+#define TWSR    _TWSR
+#define TWAR    _TWAR
+#define TWDR    _TWDR
+#define TWCR    (*host_twcr())
+#define TWAMR   _TWAMR
+#define SREG    (*host_sreg())
+#define MCUSR   _MCUSR
+#define MCUCR   _MCUCR
+#define SMCR    _SMCR
+#define PRR     _PRR
+#define CLKPR   _CLKPR
+#define OSCCAL  _OSCCAL
+#define TCCR0A  _TCCR0A
+#define TCCR0B  _TCCR0B
+#define TIMSK0  _TIMSK0
+#define TIFR0   _TIFR0
+#define TCNT0   _TCNT0
+#define OCR0A   _OCR0A
+#define OCR0B   _OCR0B
+#define TCCR1A  _TCCR1A
+#define TCCR1B  _TCCR1B
+#define TCCR1C  _TCCR1C
+#define TIMSK1  _TIMSK1
+#ifdef __cplusplus
+#define TIFR1   (HostFlags(&_TIFR1))
+#else
+#define TIFR1   _TIFR1
+#endif
+#define TCNT1L  _TCNT1L
+#define TCNT1H  _TCNT1H
+#define ICR1L   _ICR1L
+#define ICR1H   _ICR1H
+#define OCR1AL  _OCR1AL
+#define OCR1AH  _OCR1AH
+#define OCR1BL  _OCR1BL
+#define OCR1BH  _OCR1BH
+#define TCCR2A  _TCCR2A
+#define TCCR2B  _TCCR2B
+#define TIMSK2  _TIMSK2
+#ifdef __cplusplus
+#define TIFR2   (HostFlags(&_TIFR2))
+#else
+#define TIFR2   _TIFR2
+#endif
+#define TCNT2   _TCNT2
+#define OCR2A   _OCR2A
+#define OCR2B   _OCR2B
+#define ASSR    _ASSR
+#define GTCCR   _GTCCR
+#define UCSR0A  _UCSR0A
+#define UCSR0B  _UCSR0B
+#define UCSR0C  _UCSR0C
+#define UDR0    _UDR0
+#define UBRR0L  _UBRR0L
+#define UBRR0H  _UBRR0H
+#define ADCSRA  _ADCSRA
+#define ADCSRB  _ADCSRB
+#define ADMUX   _ADMUX
+#define ADCL    _ADCL
+#define ADCH    _ADCH
+#define DIDR0   _DIDR0
+#define DIDR1   _DIDR1
+#define ACSR    _ACSR
+#define PCICR   _PCICR
+#define PCIFR   _PCIFR
+#define PCMSK0  _PCMSK0
+#define PCMSK1  _PCMSK1
+#define PCMSK2  _PCMSK2
+#define EICRA   _EICRA
+#define EIMSK   _EIMSK
+#define EIFR    _EIFR
+#define SPL     _SPL
+#define SPH     _SPH
+#ifdef __cplusplus
+#define EECR    host_eecr_reg
+#else
+#define EECR    _EECR
+#endif
+#define EEDR    _EEDR
+#define EEARL   _EEARL
+#define EEARH   _EEARH
+#define WDTCSR  _WDTCSR
+#define TCNT1   _TCNT1
+#define ICR1    _ICR1
+#define OCR1A   _OCR1A
+#define OCR1B   _OCR1B
+#define UBRR0   _UBRR0
+#define SP      _SP
+#define EEAR    _EEAR
+#define ADC     _ADC
+
+#define RAMSTART	0x100
+#define RAMEND		0x8FF
+#define E2END		0x3FF
+#define FLASHEND	0x7FFF
+
+#define _BV(b)						(1 << (b))
+#define _SFR_BYTE(x)				(x)
+#define _SFR_IO_ADDR(x)				0
+#define _SFR_MEM_ADDR(x)			0
+#define bit_is_set(r, b)			((r) & _BV(b))
+#define bit_is_clear(r, b)			(!((r) & _BV(b)))
+#define loop_until_bit_is_set(r, b)	do { } while(bit_is_clear(r, b))
+#define loop_until_bit_is_clear(r, b)	do { } while(bit_is_set(r, b))
+
+#define __AVR_ATmega328P__	1
+
+// Ports
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+#define PORTB0 0
+#define PORTB1 1
+#define PORTB2 2
+#define PORTB3 3
+#define PORTB4 4
+#define PORTB5 5
+#define PORTC0 0
+#define PORTC1 1
+#define PORTC2 2
+#define PORTC3 3
+#define PORTC4 4
+#define PORTC5 5
+#define PORTD0 0
+#define PORTD1 1
+#define PORTD2 2
+#define PORTD3 3
+#define PORTD4 4
+#define PORTD5 5
+#define PORTD6 6
+#define PORTD7 7
+
+// TWI
+#define TWINT	7
+#define TWEA	6
+#define TWSTA	5
+#define TWSTO	4
+#define TWWC	3
+#define TWEN	2
+#define TWIE	0
+#define TWPS1	1
+#define TWPS0	0
+#define TWGCE	0
+
+// Timers
+#define CS00	0
+#define CS01	1
+#define CS02	2
+#define WGM00	0
+#define WGM01	1
+#define WGM02	3
+#define COM0A0	6
+#define COM0A1	7
+#define COM0B0	4
+#define COM0B1	5
+#define TOIE0	0
+#define OCIE0A	1
+#define OCIE0B	2
+#define TOV0	0
+#define OCF0A	1
+#define OCF0B	2
+#define CS10	0
+#define CS11	1
+#define CS12	2
+#define WGM10	0
+#define WGM11	1
+#define WGM12	3
+#define WGM13	4
+#define ICES1	6
+#define ICNC1	7
+#define COM1A0	6
+#define COM1A1	7
+#define COM1B0	4
+#define COM1B1	5
+#define TOIE1	0
+#define OCIE1A	1
+#define OCIE1B	2
+#define ICIE1	5
+#define TOV1	0
+#define OCF1A	1
+#define OCF1B	2
+#define ICF1	5
+#define CS20	0
+#define CS21	1
+#define CS22	2
+#define WGM20	0
+#define WGM21	1
+#define WGM22	3
+#define COM2A0	6
+#define COM2A1	7
+#define COM2B0	4
+#define COM2B1	5
+#define TOIE2	0
+#define OCIE2A	1
+#define OCIE2B	2
+#define TOV2	0
+#define OCF2A	1
+#define OCF2B	2
+#define AS2		5
+#define TCN2UB	4
+#define OCR2AUB	3
+#define OCR2BUB	2
+#define TCR2AUB	1
+#define TCR2BUB	0
+#define PSRSYNC	0
+#define PSRASY	1
+#define TSM		7
+
+// USART
+#define RXC0	7
+#define TXC0	6
+#define UDRE0	5
+#define FE0		4
+#define DOR0	3
+#define UPE0	2
+#define U2X0	1
+#define RXCIE0	7
+#define TXCIE0	6
+#define UDRIE0	5
+#define RXEN0	4
+#define TXEN0	3
+#define UCSZ02	2
+#define UCSZ01	2
+#define UCSZ00	1
+
+// ADC, analog comparator
+#define ADEN	7
+#define ADSC	6
+#define ADATE	5
+#define ADIF	4
+#define ADIE	3
+#define ADPS2	2
+#define ADPS1	1
+#define ADPS0	0
+#define ACD		7
+#define ACBG	6
+#define ACO		5
+#define ACI		4
+#define ACIE	3
+#define ACME	6
+
+// Pin change / external interrupts
+#define PCIE0	0
+#define PCIE1	1
+#define PCIE2	2
+#define PCIF0	0
+#define PCIF1	1
+#define PCIF2	2
+#define ISC00	0
+#define ISC01	1
+#define ISC10	2
+#define ISC11	3
+#define INT0	0
+#define INT1	1
+#define INTF0	0
+#define INTF1	1
+
+// Sleep, power, clock, reset
+#define SE		0
+#define SM0		1
+#define SM1		2
+#define SM2		3
+#define PRADC	0
+#define PRUSART0	1
+#define PRSPI	2
+#define PRTIM1	3
+#define PRTIM0	5
+#define PRTIM2	6
+#define PRTWI	7
+#define CLKPCE	7
+#define BODS	6
+#define BODSE	5
+#define PUD		4
+#define PORF	0
+#define EXTRF	1
+#define BORF	2
+#define WDRF	3
+
+// EEPROM
+#define EERE	0
+#define EEPE	1
+#define EEMPE	2
+#define EERIE	3
+
+// Arduino pin numbers of the TWI and input capture pins
+#define SDA		18
+#define SCL		19
+#define ICP1	8
+
+#endif /* HOST_AVR_IO_H_ */
@@ -0,0 +1,47 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Host stand-in for <avr/power.h>, see Host.h */
+
+#ifndef HOST_AVR_POWER_H_
+#define HOST_AVR_POWER_H_
+
+#define power_adc_disable()		do { } while(0)
+#define power_adc_enable()		do { } while(0)
+#define power_spi_disable()		do { } while(0)
+#define power_spi_enable()		do { } while(0)
+#define power_usart0_disable()	do { } while(0)
+#define power_usart0_enable()	do { } while(0)
+#define power_timer0_disable()	do { } while(0)
+#define power_timer0_enable()	do { } while(0)
+#define power_timer1_disable()	do { } while(0)
+#define power_timer1_enable()	do { } while(0)
+#define power_timer2_disable()	do { } while(0)
+#define power_timer2_enable()	do { } while(0)
+#define power_twi_disable()		do { } while(0)
+#define power_twi_enable()		do { } while(0)
+
+typedef enum {
+	clock_div_1 = 0, clock_div_2, clock_div_4, clock_div_8,
+	clock_div_16, clock_div_32, clock_div_64, clock_div_128, clock_div_256
+} clock_div_t;
+
+#define clock_prescale_set(div)	do { } while(0)
+
+#endif /* HOST_AVR_POWER_H_ */
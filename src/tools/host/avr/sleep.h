@@ -0,0 +1,39 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Host stand-in for <avr/sleep.h>, see Host.h. The CPU never sleeps */
+
+#ifndef HOST_AVR_SLEEP_H_
+#define HOST_AVR_SLEEP_H_
+
+#define SLEEP_MODE_IDLE			0
+#define SLEEP_MODE_ADC			1
+#define SLEEP_MODE_PWR_DOWN		2
+#define SLEEP_MODE_PWR_SAVE		3
+#define SLEEP_MODE_STANDBY		6
+#define SLEEP_MODE_EXT_STANDBY	7
+
+#define set_sleep_mode(mode)	do { } while(0)
+#define sleep_enable()			do { } while(0)
+#define sleep_disable()			do { } while(0)
+#define sleep_cpu()				do { } while(0)
+#define sleep_mode()			do { } while(0)
+#define sleep_bod_disable()		do { } while(0)
+
+#endif /* HOST_AVR_SLEEP_H_ */
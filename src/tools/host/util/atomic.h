@@ -0,0 +1,39 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Host stand-in for <util/atomic.h>, see Host.h. Same SREG save / cli / restore */
+
+#ifndef HOST_UTIL_ATOMIC_H_
+#define HOST_UTIL_ATOMIC_H_
+
+#include <avr/interrupt.h>
+
+#define ATOMIC_RESTORESTATE	uint8_t host_sreg_save = SREG
+#define ATOMIC_FORCEON		uint8_t host_sreg_save = 0x80
+
+#define ATOMIC_BLOCK(type) \\
+	for(type, host_atomic_once = (cli(), 1); host_atomic_once; SREG = host_sreg_save, host_atomic_once = 0)
+
+#define NONATOMIC_BLOCK(type) \\
+	for(type, host_atomic_once = (sei(), 1); host_atomic_once; SREG = host_sreg_save, host_atomic_once = 0)
+
+#define NONATOMIC_RESTORESTATE	ATOMIC_RESTORESTATE
+#define NONATOMIC_FORCEOFF		uint8_t host_sreg_save = 0
+
+#endif /* HOST_UTIL_ATOMIC_H_ */
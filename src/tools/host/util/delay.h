@@ -0,0 +1,30 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Host stand-in for <util/delay.h>, see Host.h. Delays advance the virtual clock */
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include <avr/io.h>
+
+#define _delay_us(us)	host_delay_cycles((unsigned long)((us) * (F_CPU / 1000000.0) + 0.5))
+#define _delay_ms(ms)	host_delay_cycles((unsigned long)((ms) * (F_CPU / 1000.0) + 0.5))
+
+#endif /* HOST_UTIL_DELAY_H_ */
@@ -0,0 +1,116 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Stick center selection with cached centers (select_centers() and
+ * settle_centers() in wra.cpp): a stick held at plug-in keeps the cached
+ * centers, another pad of the same type resting elsewhere replaces them
+ * once its sticks have been still for CENTER_SETTLE_US.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <WProgram.h>
+#include "PadCache.h"
+#include "Timebase.h"
+#include "Host.h"
+
+// wra.cpp
+#define PAD_GC	3
+
+extern bool center_settling;
+void select_centers(int pad, PadCacheData *cache, bool cached, byte *center, byte axes);
+void settle_centers(int pad, PadCacheData *cache, byte *center, const byte *sample, byte axes);
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+	if(!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while(0)
+
+static PadCacheData cache;
+static byte center[4];
+
+/* Plug-in: cached centers all 0x80, first read lx, the rest at 0x80 */
+static void plug(bool cached, byte lx) {
+	memset(&cache, 0x00, sizeof(cache));
+	memset(cache.center, 0x80, 4);
+	memset(center, 0x80, 4);
+	center[0] = lx;
+
+	select_centers(PAD_GC, &cache, cached, center, 4);
+}
+
+/* ms of samples every 10ms, lx at lx + noise (-2 .. 2), the rest at 0x80 */
+static void hold(byte lx, int noise, unsigned int ms) {
+	byte sample[4];
+
+	for(unsigned int t = 0; t < ms && center_settling; t += 10) {
+		memset(sample, 0x80, 4);
+		sample[0] = lx + (noise ? (int)(t / 10 % 5) - 2 : 0);
+
+		Host::run(10 * (F_CPU / 1000));
+		settle_centers(PAD_GC, &cache, center, sample, 4);
+	}
+}
+
+int main() {
+	Host::reset();
+	Timebase::init();
+	sei(); // samples are 10ms apart, PROFILER builds need the Timer1 overflow ISR
+
+	plug(false, 0x90);
+	CHECK(center[0] == 0x90 && !center_settling, "no cache: first read not used");
+
+	plug(true, 0x86);
+	CHECK(center[0] == 0x86 && cache.center[0] == 0x86 && !center_settling,
+			"first read close to the cache not used");
+
+	// Another pad, resting at 0x8E: cached centers first, its own after a second
+	plug(true, 0x8E);
+	CHECK(center[0] == 0x80 && center_settling, "first read away from the cache used");
+	hold(0x8E, 1, 900);
+	CHECK(center[0] == 0x80 && center_settling, "rest position taken before the stick settled");
+	hold(0x8E, 1, 300);
+	CHECK(center[0] == 0x8E && cache.center[0] == 0x8E && !center_settling,
+			"settled rest position away from the cache not taken (center 0x%02X)", center[0]);
+
+	// Stick held right, then let go: the cache was right
+	plug(true, 0xF0);
+	hold(0xF0, 0, 3000);
+	CHECK(center[0] == 0x80 && center_settling, "held stick taken as the center (0x%02X)", center[0]);
+	hold(0x81, 1, 1200);
+	CHECK(center[0] == 0x80 && cache.center[0] == 0x80 && !center_settling,
+			"released stick not back on the cached center (0x%02X)", center[0]);
+
+	// Stick moving all the time: never settles
+	plug(true, 0x8E);
+	for(int i = 0; i < 30; i++)
+		hold(0x60 + (i % 3) * 0x20, 0, 100);
+	CHECK(center[0] == 0x80 && center_settling, "moving stick taken as the center (0x%02X)", center[0]);
+
+	printf(failures ? "FAILED (%d)\n" : "ok\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,236 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Wiimote encryption: golden vectors for WMCrypt::wiimote_gen_key() and the
+ * key setup states of WMExtension (pending key, read or write before the
+ * main loop set it up, encryption disabled while a key is pending). A read
+ * or write with the key pending must hold the bus until service() set the
+ * key up, the ISR never generates it.
+ *
+ * The vectors cover every ans_tbl index (keys whose last 6 bytes match
+ * genkey() for that index) and the idx = 7 fallback, a key that matches
+ * none and the all zero key. For that one the tables must be all 0x97,
+ * the same as the (x ^ 0x17) + 0x17 homebrew decryption.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <WProgram.h>
+#include "WMExtension.h"
+#include "WMCrypt.h"
+#include "Host.h"
+#include "HostTwi.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+	if(!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while(0)
+
+static const struct {
+	byte idx;
+	byte key[16];
+	byte ft[8];
+	byte sb[8];
+} vectors[] = {
+	{ 0, { 0xC3, 0x7D, 0x1F, 0xB6, 0x48, 0xE2, 0x07, 0x5C, 0x91, 0x3A, 0x4B, 0x5B, 0xE1, 0x0D, 0x3B, 0xA3 },
+		{ 0x64, 0x1E, 0x6B, 0x04, 0xDF, 0xB6, 0xDF, 0x5B },
+		{ 0x5D, 0xB5, 0x20, 0xDA, 0xC0, 0xD1, 0xAE, 0x0D } },
+	{ 1, { 0x1E, 0x0F, 0xF0, 0xDE, 0xBC, 0x9A, 0x78, 0x56, 0x34, 0x12, 0x9E, 0xEA, 0xD3, 0x2A, 0x0E, 0x02 },
+		{ 0x8D, 0xB1, 0xD2, 0x3F, 0x76, 0x53, 0x09, 0xE9 },
+		{ 0xA9, 0xC9, 0x9A, 0xD5, 0xDB, 0x90, 0x6F, 0x53 } },
+	{ 2, { 0x18, 0x81, 0xF0, 0x0F, 0x69, 0x96, 0x3C, 0xC3, 0x5A, 0xA5, 0x5B, 0x65, 0x21, 0x36, 0x56, 0x33 },
+		{ 0xFC, 0xED, 0xBE, 0xF8, 0xB7, 0x99, 0x2B, 0x4B },
+		{ 0x25, 0x8C, 0x01, 0x77, 0x8A, 0x5C, 0xF6, 0xD5 } },
+	{ 3, { 0x0A, 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x60, 0x44, 0x08, 0x6D, 0xDD, 0x35 },
+		{ 0xAD, 0x3E, 0x84, 0xFB, 0x8A, 0x90, 0x6F, 0xA8 },
+		{ 0x09, 0xB5, 0x8D, 0x7F, 0x3F, 0x03, 0xBD, 0x99 } },
+	{ 4, { 0xCD, 0xEF, 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0x05, 0x11, 0xA9, 0x8E, 0x10, 0xC6 },
+		{ 0x61, 0x9A, 0xF8, 0xC4, 0x99, 0x7C, 0x64, 0x28 },
+		{ 0x52, 0xD8, 0x3C, 0x70, 0x08, 0x7A, 0x3C, 0x25 } },
+	{ 5, { 0x3D, 0xF6, 0x53, 0xA8, 0x77, 0x0C, 0xD1, 0x94, 0x2E, 0x6B, 0xAE, 0xE6, 0xE3, 0x64, 0x9E, 0x31 },
+		{ 0x26, 0x54, 0x02, 0x39, 0x71, 0x36, 0x24, 0x44 },
+		{ 0x00, 0xFD, 0xD6, 0x05, 0xD2, 0xD9, 0xA2, 0xAB } },
+	{ 6, { 0x99, 0x42, 0xFE, 0xCA, 0xD0, 0xBA, 0x15, 0xEE, 0xFF, 0xC0, 0x54, 0xF0, 0xED, 0x24, 0x4B, 0xC9 },
+		{ 0xCE, 0x61, 0xBD, 0x77, 0x4A, 0xA5, 0x36, 0xF0 },
+		{ 0xD1, 0x18, 0x07, 0xD1, 0x35, 0xAB, 0xE4, 0x86 } },
+	{ 7, { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x01 },
+		{ 0x04, 0xA6, 0x54, 0x0C, 0x31, 0x50, 0xBD, 0x5B },
+		{ 0x88, 0x9B, 0xF6, 0x80, 0x76, 0x77, 0xE4, 0xDA } },
+	{ 7, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+		{ 0x97, 0x97, 0x97, 0x97, 0x97, 0x97, 0x97, 0x97 },
+		{ 0x97, 0x97, 0x97, 0x97, 0x97, 0x97, 0x97, 0x97 } },
+};
+
+#define VECTORS		(sizeof(vectors) / sizeof(vectors[0]))
+#define ZERO_KEY	(VECTORS - 1)
+
+static void golden() {
+	byte ft[8], sb[8];
+
+	for(unsigned int v = 0; v < VECTORS; v++) {
+		WMCrypt::wiimote_gen_key(vectors[v].key, ft, sb);
+
+		CHECK(!memcmp(ft, vectors[v].ft, 8) && !memcmp(sb, vectors[v].sb, 8),
+				"vector %u (idx %d): wrong tables", v, vectors[v].idx);
+	}
+
+	for(int x = 0; x < 256; x++) {
+		CHECK((byte)((x ^ 0x97) + 0x97) == (byte)((x ^ 0x17) + 0x17),
+				"zero key: 0x%02X doesn't decrypt as (x ^ 0x17) + 0x17", x);
+	}
+}
+
+/* Reads the ID at 0xFA, decrypted with vector v, -1 for none */
+static bool id_ok(int v) {
+	static const byte id[6] = { 0x00, 0x00, 0xA4, 0x20, 0x01, 0x01 };
+	byte r[6];
+
+	HostTwi::read_regs(0xFA, r, 6);
+
+	for(byte i = 0; v >= 0 && i < 6; i++)
+		r[i] = (r[i] ^ vectors[v].sb[(0xFA + i) % 8]) + vectors[v].ft[(0xFA + i) % 8];
+
+	return !memcmp(r, id, 6);
+}
+
+/*
+ * Reads the ID at every interrupt point once the key of vector v is in
+ * use, to catch the mirror half rebuilt by service()
+ */
+class Reader : public HostDevice {
+
+public:
+	int v, reads, bad;
+
+	void interrupt() {
+		if(v < 0 || memcmp(WMCrypt::wm_ft, vectors[v].ft, 8))
+			return;
+
+		reads++;
+		bad += !id_ok(v);
+	}
+};
+
+static Reader reader;
+
+/* Tables in use before the last set_key(), the ISR must leave them be */
+static byte old_ft[8];
+static int holds, isr_keys;
+
+/* The main loop, while the adapter holds the bus: sets the key up */
+static void hold() {
+	holds++;
+	isr_keys += memcmp(WMCrypt::wm_ft, old_ft, 8) != 0;
+
+	WMExtension::service();
+}
+
+static void set_key(int v) {
+	byte f0 = 0xAA;
+
+	memcpy(old_ft, WMCrypt::wm_ft, 8);
+
+	HostTwi::write_regs(0xF0, &f0, 1);
+	HostTwi::write_regs(0x40, vectors[v].key, 6);
+	HostTwi::write_regs(0x46, vectors[v].key + 6, 6);
+	HostTwi::write_regs(0x4C, vectors[v].key + 12, 4);
+}
+
+/* Key setup through the TWI slave, in each order the Wiimote can do it */
+static void states() {
+	byte data;
+
+	Host::reset();
+	sei();
+
+	WMExtension::init();
+	HostTwi::on_hold = hold;
+
+	// Read before the main loop got to the key: held until service() has it
+	for(unsigned int v = 0; v < VECTORS; v++) {
+		holds = 0;
+		set_key(v);
+		CHECK(id_ok(v), "vector %u: read before service() not encrypted with the new key", v);
+		CHECK(holds == 1, "vector %u: read before service() held %d times", v, holds);
+	}
+	CHECK(!isr_keys, "%d keys generated in the ISR", isr_keys);
+
+	// Set up by the main loop first
+	set_key(1);
+	WMExtension::service();
+	CHECK(id_ok(1), "key set up by service() not used");
+
+	// Reads while service() rebuilds the mirror, it lets them in every byte
+	reader.v = 4;
+	Host::attach(&reader);
+	set_key(4);
+	WMExtension::service();
+	reader.v = -1;
+	CHECK(reader.reads >= 64, "only %d reads while the mirror was rebuilt", reader.reads);
+	CHECK(!reader.bad, "%d of %d reads during the rebuild not encrypted with the new key", reader.bad, reader.reads);
+	CHECK(id_ok(4), "read after the rebuild not encrypted with the new key");
+
+	// Write before the main loop got to the key: held, then decrypted with
+	// the new key
+	holds = 0;
+	set_key(2);
+	data = (0x03 - vectors[2].ft[0xFE % 8]) ^ vectors[2].sb[0xFE % 8];
+	HostTwi::write_regs(0xFE, &data, 1);
+	CHECK(holds == 1, "write before service() held %d times", holds);
+	CHECK(!isr_keys, "key generated in the ISR for a write");
+	WMExtension::service();
+	CHECK(HostTwi::read_regs(0xFE, &data, 1) && (byte)((data ^ vectors[2].sb[0xFE % 8]) + vectors[2].ft[0xFE % 8]) == 0x03,
+			"write while the key was pending not decrypted with it");
+
+	// Disabled while pending: not held, the key is dropped, never generated
+	memset(WMCrypt::wm_ft, 0x5A, 8);
+	memset(WMCrypt::wm_sb, 0x5A, 8);
+	holds = 0;
+	set_key(3);
+	data = 0x55;
+	HostTwi::write_regs(0xF0, &data, 1);
+	CHECK(!holds, "write disabling encryption held");
+	CHECK(WMCrypt::wm_ft[0] == 0x5A && WMCrypt::wm_sb[0] == 0x5A, "pending key generated, then disabled");
+	WMExtension::service();
+	CHECK(WMCrypt::wm_ft[0] == 0x5A && WMCrypt::wm_sb[0] == 0x5A, "disabled key generated by service()");
+	data = 0x01;
+	HostTwi::write_regs(0xFE, &data, 1);
+	CHECK(id_ok(-1), "reads not plain after disabling a pending key");
+
+	// Old style: a single 0x00 to 0x40, the zero key
+	data = 0x00;
+	HostTwi::write_regs(0x40, &data, 1);
+	CHECK(id_ok(ZERO_KEY), "old style key setup");
+}
+
+int main() {
+	golden();
+	states();
+
+	printf(failures ? "FAILED (%d)\n" : "ok\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,346 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Golden reports: pad decoding and mapping.
+
+Runs the whole firmware, each vector in a fresh process, with a pad model
+(HostPads) holding the vector's buttons and a Wiimote fetching the report
+every 5ms (new style init, no encryption). After the pad loop has settled
+the report read must be the vector's, byte for byte: 6 bytes in data
+format 1, or 8 in format 3 (0xFE written with 0x03 first). This covers
+pad detection, the pad read and decode code (NESPad, GCPad, genesis,
+saturn, tg16, PS2Pad) and the button / stick mapping of the pad loops in
+wra.cpp.
+
+Usage: wra-golden-test [vectors]
+
+The vectors (wra-golden.txt by default) say how the lines go. Reports
+were worked out from the pad protocols and WMReport.h, not taken from a
+run: a failure is a mapping change to look at, not a file to regenerate.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <WProgram.h>
+#include "Host.h"
+#include "HostPads.h"
+#include "HostWiimote.h"
+
+// Fetches before the report is taken: init, plug-in read, loop running
+#define FETCHES	20
+
+// PS2 polls with the plug-in state: PS2Pad::init()'s two, the center read
+#define PS2_PLUG_POLLS	3
+
+#define MAX_VECTORS	128
+
+extern void setup();
+extern void loop();
+
+struct Vector {
+	char pad[12];
+	uint16_t plug_buttons, buttons;	// nes, snes, neogeo, genesis, saturn, tg16
+	uint8_t plug[8], state[8];		// n64, gc, ps2
+	uint8_t report[8];
+	uint8_t length;					// 6 (format 1) or 8 (format 3)
+	char comment[80];
+};
+
+/* Status read n: the plug-in state first, then the vector's */
+class GoldenJoybusPad : public HostJoybusPad {
+
+public:
+	const Vector *v;
+
+	GoldenJoybusPad(bool gc, const Vector *v) : HostJoybusPad(gc) {
+		this->v = v;
+	}
+
+	virtual const uint8_t *state() {
+		return this->reads ? this->v->state : this->v->plug;
+	}
+};
+
+/*
+Button pads: the plug-in state until the adapter first drives a pad pin
+low, detectPad() only pulls them up. Buttons on the detect pins held at
+plug-in change what is detected, as they do on the real adapter.
+*/
+template<class T> class GoldenButtonPad : public T {
+
+private:
+	bool plugged;
+
+public:
+	const Vector *v;
+
+	GoldenButtonPad(const Vector *v) : T() {
+		this->v = v;
+		this->plugged = false;
+	}
+
+	GoldenButtonPad(const Vector *v, bool arg) : T(arg) {
+		this->v = v;
+		this->plugged = false;
+	}
+
+	virtual uint16_t state() {
+		return this->plugged ? this->v->buttons : this->v->plug_buttons;
+	}
+
+	virtual void pins() {
+		for(uint8_t pin = 2; pin <= 8; pin++)
+			this->plugged |= !Host::output(pin);
+
+		T::pins();
+	}
+};
+
+/* Polls before the loop's center read get the plug-in state */
+class GoldenPs2Pad : public HostPs2Pad {
+
+public:
+	const Vector *v;
+
+	GoldenPs2Pad(const Vector *v) {
+		this->v = v;
+	}
+
+	virtual const uint8_t *state() {
+		return (this->polls >= PS2_PLUG_POLLS) ? this->v->state : this->v->plug;
+	}
+};
+
+// Pads whose state is a button word (hex)
+static const char *button_pads[] = {
+	"nes", "snes", "neogeo", "genesis", "genesis6", "saturn", "tg16", NULL
+};
+
+static HostWiimote wiimote;
+static uint8_t report[8];
+static unsigned long fetches = 0;
+
+static void on_read(uint8_t addr, const uint8_t *data, uint8_t n) {
+	if(addr != 0x00 || n != wiimote.length)
+		return;
+
+	memcpy(report, data, n);
+
+	if(++fetches == FETCHES)
+		throw HostStop();
+}
+
+/* Hex digits to bytes, false if there aren't n bytes */
+static bool hex(const char *s, uint8_t *b, int n) {
+	for(int i = 0; i < n; i++) {
+		unsigned int x;
+
+		if(sscanf(s + 2 * i, "%2x", &x) != 1)
+			return false;
+
+		b[i] = x;
+	}
+
+	return strlen(s) == (size_t)(2 * n);
+}
+
+/* One vector line, false if it doesn't parse */
+static bool parse(const char *line, Vector *v) {
+	char plug[40], state[40];
+	const char *c;
+	unsigned int r[8];
+	int size, n;
+
+	memset(v, 0, sizeof(*v));
+
+	n = sscanf(line, "%11s %39s %39s : %x %x %x %x %x %x %x %x", v->pad, plug, state,
+			&r[0], &r[1], &r[2], &r[3], &r[4], &r[5], &r[6], &r[7]);
+
+	if(n != 9 && n != 11)
+		return false;
+
+	v->length = n - 3;
+
+	for(int i = 0; i < v->length; i++)
+		v->report[i] = r[i];
+
+	c = strchr(line, '#');
+	snprintf(v->comment, sizeof(v->comment), "%s", c ? c + 2 : "");
+	v->comment[strcspn(v->comment, "\r\n")] = 0;
+
+	for(const char **p = button_pads; *p; p++) {
+		char *end;
+
+		if(strcmp(v->pad, *p))
+			continue;
+
+		v->buttons = strtoul(state, &end, 16);
+
+		if(*end)
+			return false;
+
+		if(!strcmp(plug, "-")) {
+			v->plug_buttons = v->buttons;
+			return true;
+		}
+
+		v->plug_buttons = strtoul(plug, &end, 16);
+
+		return !*end;
+	}
+
+	if(!strcmp(v->pad, "n64"))
+		size = 4;
+	else if(!strcmp(v->pad, "gc"))
+		size = 8;
+	else if(!strcmp(v->pad, "ps2"))
+		size = 6;
+	else
+		return false;
+
+	if(!hex(state, v->state, size))
+		return false;
+
+	if(!strcmp(plug, "-"))
+		memcpy(v->plug, v->state, size);
+	else if(!hex(plug, v->plug, size))
+		return false;
+
+	return true;
+}
+
+/* The vector's pad model, parse() has checked the name */
+static HostDevice *pad(const Vector *v) {
+	const char *p = v->pad;
+
+	if(!strcmp(p, "n64") || !strcmp(p, "gc"))
+		return new GoldenJoybusPad(!strcmp(p, "gc"), v);
+	if(!strcmp(p, "ps2"))
+		return new GoldenPs2Pad(v);
+	if(!strcmp(p, "neogeo"))
+		return new GoldenButtonPad<HostNeoGeoPad>(v);
+	if(!strncmp(p, "genesis", 7))
+		return new GoldenButtonPad<HostGenesisPad>(v, !strcmp(p, "genesis6"));
+	if(!strcmp(p, "saturn"))
+		return new GoldenButtonPad<HostSaturnPad>(v);
+	if(!strcmp(p, "tg16"))
+		return new GoldenButtonPad<HostTg16Pad>(v);
+
+	return new GoldenButtonPad<HostNesPad>(v, !strcmp(p, "snes"));
+}
+
+/* Bytes as hex, for the failure line */
+static const char *bytes(const uint8_t *b, int n) {
+	static char s[2][32];
+	static int which = 0;
+	char *p = s[which ^= 1];
+
+	for(int i = 0; i < n; i++)
+		sprintf(p + 3 * i, "%02X ", b[i]);
+
+	p[3 * n - 1] = 0;
+
+	return p;
+}
+
+/* One vector, on a fresh firmware (run in its own process) */
+static int run(const Vector *v) {
+	static const uint8_t init1 = 0x55, init2 = 0x00, format3 = 0x03;
+
+	Host::reset();
+	Host::attach(pad(v));
+	Host::attach(&wiimote);
+
+	wiimote.poll_us = 5000;
+	wiimote.on_read = on_read;
+	wiimote.length = v->length;
+	wiimote.write(0xF0, &init1, 1);
+	wiimote.write(0xFB, &init2, 1);
+
+	if(v->length == 8)
+		wiimote.write(0xFE, &format3, 1);
+
+	sei();
+
+	try {
+		setup();
+
+		for(;;)
+			loop();
+	} catch(HostStop &) {
+	}
+
+	if(fetches == FETCHES && !memcmp(report, v->report, v->length))
+		return 0;
+
+	printf("FAIL %s (%s): got %s after %lu fetches, want %s\n", v->pad, v->comment,
+			bytes(report, v->length), fetches, bytes(v->report, v->length));
+
+	return 1;
+}
+
+int main(int argc, char **argv) {
+	static Vector vectors[MAX_VECTORS];
+	const char *file = (argc > 1) ? argv[1] : "wra-golden.txt";
+	char line[256];
+	int lines = 0, n = 0, status, failed = 0;
+	FILE *f = fopen(file, "r");
+
+	if(!f) {
+		perror(file);
+		return 2;
+	}
+
+	// All read first, the children would share the file position
+	while(fgets(line, sizeof(line), f) && n < MAX_VECTORS) {
+		lines++;
+
+		if(line[strspn(line, " \t\r\n")] == 0 || line[0] == '#')
+			continue;
+
+		if(!parse(line, &vectors[n])) {
+			printf("%s:%d: bad vector\n", file, lines);
+			failed++;
+			continue;
+		}
+
+		n++;
+	}
+
+	fclose(f);
+	fflush(stdout);
+
+	for(int i = 0; i < n; i++) {
+		if(!fork())
+			exit(run(&vectors[i]));
+
+		wait(&status);
+		if(!WIFEXITED(status) || WEXITSTATUS(status))
+			failed++;
+	}
+
+	printf("%d vectors\n", n);
+	printf(failed ? "FAILED (%d)\n" : "ok\n", failed);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Pad to Wiimote latency, on the host model.
+
+The whole firmware runs (setup() and the NES pad loop) against a NES pad
+model and a Wiimote fetching the report at a fixed interval over a timed
+400kHz bus (HostWiimote). A is pressed at random points of the fetch
+cycle and held until a report has it. For every press this gives the time
+from the pad contact closing to the first report with A on the wire, and
+the bus side worst cases along the way.
+
+Usage: wra-latency-test [-p poll_us] [-r bus_hz] [-n presses]
+
+The times come from the virtual clock (see Host.h), they model the
+firmware's timing. They are not AVR cycles: only delays and register
+accesses take virtual time, the code between them takes none. Cycle exact
+figures for a real wra.elf come from the simavr bench,
+src/tools/wra-bench.c (none recorded yet, see there).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <WProgram.h>
+#include "Host.h"
+#include "HostPads.h"
+#include "HostWiimote.h"
+
+// NES A is bit 0 of the shift register, report byte 5 bit 4 (0 = pressed)
+#define NES_A	0x0001
+#define A_BIT	0x10
+
+#define NEVER	(~0ULL)
+
+extern void setup();
+extern void loop();
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+	if(!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while(0)
+
+/* A held from press_at until release_at */
+class TestPad : public HostNesPad {
+
+public:
+	unsigned long long press_at, release_at;
+
+	TestPad() : HostNesPad(false) {
+		this->press_at = this->release_at = NEVER;
+	}
+
+	virtual uint16_t state() {
+		return (Host::cycles >= this->press_at && Host::cycles < this->release_at) ? NES_A : 0;
+	}
+};
+
+static TestPad pad;
+static HostWiimote wiimote;
+
+static unsigned long presses = 0, wanted = 200;
+static unsigned long long latency_min = NEVER, latency_max = 0, latency_sum = 0;
+
+static unsigned long long random_cycles(unsigned long us) {
+	return (unsigned long long)(random() % us) * (F_CPU / 1000000UL);
+}
+
+/* Every report the Wiimote reads */
+static void on_read(uint8_t addr, const uint8_t *data, uint8_t n) {
+	unsigned long long now = Host::cycles;
+	bool a;
+
+	if(addr != 0x00 || n != 6)
+		return;
+
+	a = !(data[5] & A_BIT);
+
+	if(pad.release_at == NEVER) {
+		CHECK(!a || now >= pad.press_at, "A in a report before it was pressed");
+
+		if(a) {
+			unsigned long long latency = now - pad.press_at;
+
+			latency_sum += latency;
+			if(latency < latency_min)
+				latency_min = latency;
+			if(latency > latency_max)
+				latency_max = latency;
+
+			// Held for a couple of fetches, released at a random point
+			pad.release_at = now + random_cycles(3 * wiimote.poll_us);
+		}
+	} else if(now >= pad.release_at && !a) {
+		if(++presses == wanted)
+			throw HostStop();
+
+		pad.press_at = now + random_cycles(3 * wiimote.poll_us);
+		pad.release_at = NEVER;
+	}
+}
+
+static double us(unsigned long long cycles) {
+	return (double) cycles / (F_CPU / 1000000UL);
+}
+
+int main(int argc, char **argv) {
+	static const uint8_t init1 = 0x55, init2 = 0x00;
+	int opt;
+
+	wiimote.poll_us = 5000;
+
+	while((opt = getopt(argc, argv, "p:r:n:")) != -1) {
+		switch(opt) {
+		case 'p':
+			wiimote.poll_us = atol(optarg);
+			break;
+		case 'r':
+			wiimote.rate = atol(optarg);
+			break;
+		case 'n':
+			wanted = atol(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-p poll_us] [-r bus_hz] [-n presses]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	srandom(1);
+
+	Host::reset();
+	Host::attach(&pad);
+	Host::attach(&wiimote);
+
+	// New style init first, no encryption, then the fetches
+	wiimote.on_read = on_read;
+	wiimote.write(0xF0, &init1, 1);
+	wiimote.write(0xFB, &init2, 1);
+	pad.press_at = 20000 * (F_CPU / 1000000UL);
+
+	sei();
+
+	try {
+		setup();
+
+		for(;;)
+			loop();
+	} catch(HostStop &) {
+	}
+
+	printf("NES pad, Wiimote at %luHz fetching every %luus, %lu presses (host model)\n",
+			wiimote.rate, wiimote.poll_us, presses);
+	printf("  pad edge to report on the wire: min %.1fus avg %.1fus max %.1fus\n",
+			us(latency_min), us(latency_sum / presses), us(latency_max));
+	printf("  clock stretching: worst %.1fus on one byte\n", us(wiimote.stretch_max));
+	printf("  %lu transactions, worst %.1fus beyond bus time\n",
+			wiimote.transactions, us(wiimote.service_max));
+
+	// A press is in the next fetch after a pad pass has seen it: within one
+	// fetch interval, plus a pad pass and the read itself
+	CHECK(latency_max <= (wiimote.poll_us + 1000) * (F_CPU / 1000000UL),
+			"worst latency %.1fus over a fetch interval + 1ms", us(latency_max));
+	CHECK(wiimote.nacks == 0, "%lu NACKs", wiimote.nacks);
+
+	printf(failures ? "FAILED (%d)\n" : "ok\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,397 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Virtual Wiimote master: protocol conformance and throughput.
+
+Runs the whole firmware (NES pad loop, A and START held) against scripted
+Wiimote traffic on the timed bus (HostWiimote). Every byte read is
+decrypted as the Wiimote would and checked against a reference model of
+the Classic Controller registers: report, calibration, key, ID and
+format. Per script it prints the transactions per second of virtual time
+and the worst clock stretching / service time.
+
+Usage: wra-master-test [-r bus_hz] [-p gap_us] [script...]
+
+With no script the built-in ones run (Wiimote and NES Classic Mini
+patterns, below), each in a fresh process. -p is the bus idle time
+between script lines, 0 (back to back, the stress case) by default.
+
+Script lines, addresses and bytes in hex, lengths and counts in decimal:
+  w <addr> <byte>...          write, encrypted once a key is set (except
+                              0xF0 and the key itself, as the Wiimote does)
+  key <16 bytes>              key write to 0x40, in 6 + 6 + 4 byte chunks
+  r <addr> <n>[,<n>...] [x<count>]
+                              reads, the lengths back to back, count times
+  # ...                       comment
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <WProgram.h>
+#include "WMExtension.h"
+#include "WMCrypt.h"
+#include "Host.h"
+#include "HostPads.h"
+#include "HostWiimote.h"
+
+extern void setup();
+extern void loop();
+
+static const struct {
+	const char *name;
+	const char *script;
+} scripts[] = {
+	{ "new style init",
+		"w f0 55\n"
+		"w fb 00\n"
+		"r fa 6\n"
+		"r 20 16 x2\n"
+		"r 00 6 x100\n" },
+	{ "format switches (NES Classic Mini)",
+		"w f0 55\n"
+		"w fb 00\n"
+		"r fa 6\n"
+		"w fe 03\n"
+		"r fa 6\n"
+		"r 00 8 x100\n"
+		"w fe 01\n"
+		"r 00 6 x50\n"
+		"w fe 03\n"
+		"r 00 8 x50\n" },
+	{ "16 byte key",
+		"w f0 aa\n"
+		"key 11 22 33 44 55 66 77 88 99 aa bb cc dd ee ff 01\n"
+		"r fa 6\n"
+		"r 20 16\n"
+		"r 00 6 x100\n"
+		"w fe 03\n"
+		"r 00 8 x50\n"
+		"# new key over the old one\n"
+		"w f0 aa\n"
+		"key 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 17\n"
+		"r 00 8 x50\n" },
+	{ "old style key",
+		"w 40 00\n"
+		"r fa 6\n"
+		"r 20 16\n"
+		"r 00 6 x100\n" },
+	{ "back to back reads",
+		"w f0 55\n"
+		"w fb 00\n"
+		"r 00 6,8,21 x50\n"
+		"r 20 21\n"
+		"r 30 16\n"
+		"w f0 aa\n"
+		"key 10 32 54 76 98 ba dc fe 01 23 45 67 89 ab cd ef\n"
+		"r 00 6,8,21 x50\n"
+		"r 20 21\n" },
+};
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+	if(!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while(0)
+
+/*
+ * Reference Classic Controller, what the Wiimote expects to read. The pad
+ * holds A and START, sticks centered.
+ */
+static byte ref_regs[256];
+static bool encrypted = false;
+static unsigned char ft[8], sb[8];
+
+static void ref_init() {
+	static const byte cal[16] = { CAL_STICK_MAX, CAL_STICK_MIN, CAL_STICK_CENTER,
+			CAL_STICK_MAX, CAL_STICK_MIN, CAL_STICK_CENTER, CAL_STICK_MAX, CAL_STICK_MIN,
+			CAL_STICK_CENTER, CAL_STICK_MAX, CAL_STICK_MIN, CAL_STICK_CENTER, 0x00, 0x00,
+			(4 * (CAL_STICK_MAX + CAL_STICK_MIN + CAL_STICK_CENTER) + 0x55) & 0xFF,
+			(4 * (CAL_STICK_MAX + CAL_STICK_MIN + CAL_STICK_CENTER) + 0xAA) & 0xFF };
+	static const byte id[6] = { 0x00, 0x00, 0xA4, 0x20, 0x01, 0x01 };
+
+	memset(ref_regs, 0, sizeof(ref_regs));
+	memcpy(ref_regs + 0x20, cal, 16);
+	memcpy(ref_regs + 0x30, cal, 16);
+	memcpy(ref_regs + 0xFA, id, 6);
+}
+
+/* Report bytes for the data format in 0xFE */
+static byte ref_read(byte addr) {
+	// Format 1: 6 bit LX / LY, 5 bit RX / RY, no triggers
+	static const byte report1[8] = { 0x5E, 0xDE, 0x8F, 0x00, 0xFB, 0xEF, 0x00, 0x00 };
+	// Format 3: 8 bit axes, then the buttons
+	static const byte report3[8] = { CAL_STICK_CENTER, CAL_STICK_CENTER, CAL_STICK_CENTER,
+			CAL_STICK_CENTER, 0x00, 0x00, 0xFB, 0xEF };
+
+	if(addr < 8)
+		return (ref_regs[0xFE] == 0x03) ? report3[addr] : report1[addr];
+
+	return ref_regs[addr];
+}
+
+static void ref_write(byte addr, byte data, byte count) {
+	if((addr >= 0x40 && addr < 0x50) || addr == 0xF0 || addr >= 0xFA)
+		ref_regs[addr] = data;
+
+	if(addr == 0xF0 && (data == 0x55 || data == 0xAA))
+		encrypted = false;
+
+	// Old style: a single 0x00 to 0x40, the key is all zero
+	if(addr == 0x40 && data == 0x00 && count == 1)
+		memset(ref_regs + 0x40, 0, 16);
+
+	if(addr == 0x4F || (addr == 0x40 && data == 0x00 && count == 1)) {
+		WMCrypt::wiimote_gen_key(ref_regs + 0x40, ft, sb);
+		encrypted = true;
+	}
+}
+
+static HostWiimote wiimote;
+
+/* Every read, decrypted and checked */
+static void on_read(uint8_t addr, const uint8_t *data, uint8_t n) {
+	for(uint8_t i = 0; i < n; i++) {
+		byte a = addr + i;
+		byte d = data[i];
+
+		// The adapter sends at most up to register 0xFF
+		if(addr + i > 0xFF)
+			break;
+
+		if(encrypted)
+			d = (d ^ sb[a % 8]) + ft[a % 8];
+
+		CHECK(d == ref_read(a), "read %d bytes from 0x%02X: 0x%02X is 0x%02X, not 0x%02X%s",
+				n, addr, a, d, ref_read(a), encrypted ? " (encrypted)" : "");
+	}
+}
+
+/*
+ * Script player: takes the next line once the bus is idle (and the gap
+ * has gone by), queues its transactions and updates the reference.
+ */
+class Player : public HostDevice {
+
+private:
+	const char *next;
+	bool busy;
+	unsigned long long free_at;
+
+	void write(byte addr, const byte *data, byte n, bool plain) {
+		byte e[32];
+
+		for(byte i = 0; i < n; i++) {
+			byte a = addr + i;
+
+			e[i] = (encrypted && !plain) ? (data[i] - ft[a % 8]) ^ sb[a % 8] : data[i];
+		}
+
+		wiimote.write(addr, e, n);
+
+		for(byte i = 0; i < n; i++)
+			ref_write(addr + i, data[i], n);
+	}
+
+	void line(char *s) {
+		byte b[32];
+		int n = 0;
+		char *t = strtok(s, " \t");
+
+		if(!t || t[0] == '#')
+			return;
+
+		if(!strcmp(t, "w")) {
+			byte addr = strtoul(strtok(NULL, " \t"), NULL, 16);
+
+			while((t = strtok(NULL, " \t")) && n < 32)
+				b[n++] = strtoul(t, NULL, 16);
+
+			this->write(addr, b, n, addr == 0xF0);
+		} else if(!strcmp(t, "key")) {
+			while((t = strtok(NULL, " \t")) && n < 16)
+				b[n++] = strtoul(t, NULL, 16);
+
+			this->write(0x40, b, 6, true);
+			this->write(0x46, b + 6, 6, true);
+			this->write(0x4C, b + 12, 4, true);
+		} else if(!strcmp(t, "r")) {
+			byte addr = strtoul(strtok(NULL, " \t"), NULL, 16);
+			char *lengths = strtok(NULL, " \t");
+			char *repeat = strtok(NULL, " \t");
+			int count = repeat ? strtoul(repeat + 1, NULL, 10) : 1;
+
+			for(int i = 0; i < count; i++) {
+				for(char *l = lengths; l; l = strchr(l, ',') ? strchr(l, ',') + 1 : NULL)
+					wiimote.read(addr, strtoul(l, NULL, 10));
+			}
+		} else {
+			printf("FAIL: bad script line '%s'\n", t);
+			failures++;
+		}
+	}
+
+public:
+	unsigned long gap_us;
+	unsigned long long first, last;
+
+	Player(const char *script, unsigned long gap_us) {
+		this->next = script;
+		this->busy = false;
+		this->gap_us = gap_us;
+		this->first = this->last = 0;
+
+		// Starts once the firmware is up and has found the pad
+		this->free_at = 50000 * (F_CPU / 1000000UL);
+	}
+
+	virtual void interrupt() {
+		char s[256];
+		const char *end;
+
+		if(!wiimote.idle()) {
+			this->busy = true;
+			return;
+		}
+
+		if(this->busy) {
+			this->busy = false;
+			this->free_at = this->last = Host::cycles;
+		}
+
+		if(Host::cycles < this->free_at + this->gap_us * (F_CPU / 1000000UL))
+			return;
+
+		if(!*this->next)
+			throw HostStop();
+
+		if(!this->first)
+			this->first = Host::cycles;
+
+		end = strchr(this->next, '\n');
+		if(!end)
+			end = this->next + strlen(this->next);
+
+		snprintf(s, sizeof(s), "%.*s", (int)(end - this->next), this->next);
+		this->next = *end ? end + 1 : end;
+
+		this->line(s);
+	}
+};
+
+/* One script, on a fresh firmware (run in its own process) */
+static int run(const char *name, const char *script, unsigned long rate, unsigned long gap_us) {
+	HostNesPad pad(false);
+	Player player(script, gap_us);
+	double seconds;
+
+	ref_init();
+
+	Host::reset();
+	Host::attach(&pad);
+	Host::attach(&player);
+	Host::attach(&wiimote);
+
+	pad.buttons = 0x0009; // A, START
+	wiimote.rate = rate;
+	wiimote.on_read = on_read;
+
+	sei();
+
+	try {
+		setup();
+
+		for(;;)
+			loop();
+	} catch(HostStop &) {
+	}
+
+	seconds = (double)(player.last - player.first) / F_CPU;
+
+	printf("  %s: %lu transactions, %.0f/s, worst stretch %.1fus, worst service %.1fus beyond bus time\n",
+			name, wiimote.transactions, seconds > 0 ? wiimote.transactions / seconds : 0.0,
+			(double) wiimote.stretch_max / (F_CPU / 1000000UL),
+			(double) wiimote.service_max / (F_CPU / 1000000UL));
+
+	CHECK(wiimote.nacks == 0, "%s: %lu NACKs", name, wiimote.nacks);
+
+	return failures;
+}
+
+static char *load(const char *file) {
+	static char buffer[65536];
+	FILE *f = fopen(file, "r");
+	size_t n;
+
+	if(!f) {
+		perror(file);
+		exit(2);
+	}
+
+	n = fread(buffer, 1, sizeof(buffer) - 1, f);
+	buffer[n] = 0;
+	fclose(f);
+
+	return buffer;
+}
+
+int main(int argc, char **argv) {
+	unsigned long rate = 400000, gap_us = 0;
+	int opt, status, failed = 0;
+
+	while((opt = getopt(argc, argv, "r:p:")) != -1) {
+		switch(opt) {
+		case 'r':
+			rate = atol(optarg);
+			break;
+		case 'p':
+			gap_us = atol(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-r bus_hz] [-p gap_us] [script...]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("Wiimote at %luHz, %luus between script lines\n", rate, gap_us);
+	fflush(stdout);
+
+	for(int i = 0; i < (int)(optind < argc ? argc - optind : sizeof(scripts) / sizeof(scripts[0])); i++) {
+		const char *name = (optind < argc) ? argv[optind + i] : scripts[i].name;
+
+		if(!fork())
+			exit(run(name, (optind < argc) ? load(name) : scripts[i].script, rate, gap_us) ? 1 : 0);
+
+		wait(&status);
+		if(!WIFEXITED(status) || WEXITSTATUS(status))
+			failed++;
+	}
+
+	printf(failed ? "FAILED (%d)\n" : "ok\n", failed);
+
+	return failed ? 1 : 0;
+}
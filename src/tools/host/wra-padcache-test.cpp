@@ -0,0 +1,98 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * EEPROM pad cache (PadCache.cpp built with PAD_CACHE = 1, see the
+ * Makefile): records are kept per pad type, a pad's saves don't push out
+ * another pad's record, and a save cut by a power loss falls back to the
+ * previous one. Each load() is a power up.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <WProgram.h>
+#include "PadCache.h"
+#include "Host.h"
+
+// wra.cpp
+#define PAD_PS2	0b00100
+#define PAD_GC	0b00011
+#define PAD_N64	0b00010
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+	if(!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while(0)
+
+/* Saves centers all at c for pad, n bytes of it make it to the EEPROM */
+static void save(int pad, byte c, int n) {
+	PadCacheData d = { 0, c, { c, c, c, c } };
+
+	PadCache::store(pad, &d);
+
+	for(int i = 0; i < n; i++)
+		PadCache::service();
+}
+
+/* Power up with pad: its cached center, 0 if none */
+static byte boot(int pad) {
+	PadCacheData d;
+
+	return PadCache::load(pad, &d) ? d.center[0] : 0;
+}
+
+int main() {
+	Host::reset();
+
+	CHECK(!boot(PAD_GC), "empty EEPROM gave a record");
+	save(PAD_GC, 0x10, 64);
+	CHECK(boot(PAD_GC) == 0x10, "GC record not loaded");
+
+	CHECK(!boot(PAD_PS2), "GC record loaded for the PS2 pad");
+	save(PAD_PS2, 0x20, 64);
+	CHECK(boot(PAD_GC) == 0x10, "GC record lost to a PS2 save (0x%02X)", boot(PAD_GC));
+
+	// More saves than slots: the other pads' records stay
+	boot(PAD_N64);
+	save(PAD_N64, 0x30, 64);
+
+	boot(PAD_GC);
+	for(byte c = 0x40; c < 0x60; c++)
+		save(PAD_GC, c, 64);
+
+	CHECK(boot(PAD_GC) == 0x5F, "last GC save not loaded (0x%02X)", boot(PAD_GC));
+	CHECK(boot(PAD_PS2) == 0x20, "PS2 record pushed out by GC saves (0x%02X)", boot(PAD_PS2));
+	CHECK(boot(PAD_N64) == 0x30, "N64 record pushed out by GC saves (0x%02X)", boot(PAD_N64));
+
+	// Power lost before the CRC went in: the previous save
+	boot(PAD_GC);
+	save(PAD_GC, 0x60, 5);
+	CHECK(boot(PAD_GC) == 0x5F, "cut save not dropped (0x%02X)", boot(PAD_GC));
+	CHECK(boot(PAD_PS2) == 0x20, "PS2 record lost to a cut save (0x%02X)", boot(PAD_PS2));
+
+	printf(failures ? "FAILED (%d)\n" : "ok\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * PROFILER = 1 build of Profiler.c and Timebase.cpp (see the Makefile):
+ * slots count CPU cycles, the PROF_TWI / PROF_TIMER0 time inside a main
+ * loop slot is taken out of it and the run counted as interrupted, and
+ * now() still counts microseconds with Timer1 at clk/1.
+ */
+
+#include <stdio.h>
+
+#include <WProgram.h>
+#include "Profiler.h"
+#include "Timebase.h"
+#include "Host.h"
+
+// Cycles of the bookkeeping and SREG accesses a slot may show on top, the
+// ISR slots' own enter / exit included
+#define SLACK	(16 * HOST_ACCESS_CYCLES)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+	if(!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while(0)
+
+static void twi(void) {
+	PROFILER_ENTER(PROF_TWI);
+	Host::run(300);
+	PROFILER_EXIT(PROF_TWI);
+}
+
+static void timer0(void) {
+	PROFILER_ENTER(PROF_TIMER0);
+	Host::run(50);
+	PROFILER_EXIT(PROF_TIMER0);
+}
+
+static bool near(uint16_t d, uint16_t cycles) {
+	return d >= cycles && d <= cycles + SLACK;
+}
+
+int main() {
+	profiler_slot_t *s = &profiler_slots[PROF_DECODE];
+	unsigned long t;
+	unsigned long long us;
+
+	Host::reset();
+	Timebase::init();
+	profiler_init();
+	sei();
+
+	CHECK(TCCR1B == _BV(CS10), "Timer1 not at clk/1 (TCCR1B 0x%02X)", TCCR1B);
+
+	// Not interrupted
+	PROFILER_ENTER(PROF_DECODE);
+	Host::run(1500);
+	PROFILER_EXIT(PROF_DECODE);
+	CHECK(s->count == 1 && near(s->max, 1500) && !s->interrupted,
+			"plain run: %u cycles, %lu interrupted", s->max, (unsigned long) s->interrupted);
+
+	// Two ISRs in the middle, 350 cycles taken out
+	profiler_reset();
+	PROFILER_ENTER(PROF_DECODE);
+	Host::run(1000);
+	Host::isr(twi);
+	Host::run(500);
+	Host::isr(timer0);
+	PROFILER_EXIT(PROF_DECODE);
+	CHECK(s->count == 1 && near(s->max, 1500) && s->interrupted == 1,
+			"interrupted run: %u cycles, %lu interrupted", s->max, (unsigned long) s->interrupted);
+	CHECK(near(profiler_slots[PROF_TWI].max, 300) && near(profiler_slots[PROF_TIMER0].max, 50),
+			"ISR slots: %u / %u cycles", profiler_slots[PROF_TWI].max, profiler_slots[PROF_TIMER0].max);
+
+	// fast() / slow() leave the timer alone
+	cli();
+	Timebase::fast();
+	CHECK(TCCR1B == _BV(CS10), "fast() changed the prescaler (TCCR1B 0x%02X)", TCCR1B);
+	Timebase::slow();
+	sei();
+	CHECK(TCCR1B == _BV(CS10), "slow() changed the prescaler (TCCR1B 0x%02X)", TCCR1B);
+
+	// Microseconds across Timer1 wraps (every 8.2ms)
+	t = Timebase::now();
+	us = Host::us();
+	for(int i = 0; i < 10; i++) {
+		Host::run(40000);
+		Timebase::now();
+	}
+	t = Timebase::now() - t;
+	us = Host::us() - us;
+	CHECK(t + 1 >= us && t <= us + 1, "now() moved %lu us in %llu", t, us);
+
+	printf(failures ? "FAILED (%d)\n" : "ok\n", failures);
+
+	return failures ? 1 : 0;
+}
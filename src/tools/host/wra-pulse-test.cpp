@@ -0,0 +1,262 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Pulse widths of the bit-banged pad drivers.
+
+Runs the whole firmware, each pad in a fresh process, with its pad model
+(HostPads), a Wiimote fetching every 5ms and a meter on the lines the
+driver strobes. It takes the shortest time each line was driven low and
+high (pulses: NES LATCH / CLOCK, PS2 CLK, Genesis SELECT), and from an
+edge on the line to a read of the pad (settling: Genesis SELECT, Saturn
+S0 / S1, TG16 SELECT and /OE). Neither may be below the minimum the driver's header asserts
+for its delays (Delay.h). This checks that each protocol step really has
+its delay, not the delay values themselves, which the build already
+checks.
+
+Widths are on the virtual clock (see Host.h): the delays are exact there,
+the code between them takes only the SREG / PINx access cycles.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <WProgram.h>
+#include "NESPad.h"
+#include "genesis.h"
+#include "saturn.h"
+#include "tg16.h"
+#include "PS2Pad.h"
+#include "Host.h"
+#include "HostPads.h"
+#include "HostWiimote.h"
+
+// Fetches the pad loop runs for
+#define FETCHES	20
+
+// What to check on a line
+#define LOW_LEVEL	1		// pulse width low
+#define HIGH_LEVEL	2		// pulse width high
+#define SETTLE		4		// edge to read
+
+#define LINES	3
+
+extern void setup();
+extern void loop();
+
+struct Line {
+	const char *name;
+	uint8_t pin;
+	uint8_t check;
+	unsigned long min_ns;
+};
+
+struct Pad {
+	const char *name;
+	Line lines[LINES];
+};
+
+static const Pad pads[] = {
+	{ "nes", {
+		{ "LATCH", LATCH_PIN, HIGH_LEVEL, NES_PULSE_MIN_NS },
+		{ "CLOCK", CLOCK_PIN, HIGH_LEVEL, NES_PULSE_MIN_NS },
+	} },
+	// A 3 button pad ends the read with SELECT low, a 6 button one high
+	{ "genesis", {
+		{ "SELECT", 7, LOW_LEVEL | HIGH_LEVEL | SETTLE, GENESIS_SETTLE_MIN_NS },
+	} },
+	{ "genesis6", {
+		{ "SELECT", 7, LOW_LEVEL | HIGH_LEVEL | SETTLE, GENESIS_SETTLE_MIN_NS },
+	} },
+	{ "saturn", {
+		{ "S0", 4, SETTLE, SATURN_SETTLE_MIN_NS },
+		{ "S1", 6, SETTLE, SATURN_SETTLE_MIN_NS },
+	} },
+	{ "tg16", {
+		{ "SELECT", 7, SETTLE, TG16_SETTLE_MIN_NS },
+		{ "/OE", 8, SETTLE, TG16_SETTLE_MIN_NS },
+	} },
+	{ "ps2", {
+		{ "CLK", CLK_PIN, LOW_LEVEL | HIGH_LEVEL, CTRL_CLK_MIN_NS },
+	} },
+};
+
+static const char *checks[3] = { "low", "high", "edge to read" };
+
+#define PADS	(sizeof(pads) / sizeof(pads[0]))
+
+/* Shortest time each line was driven low, high and from an edge to a read, in cycles */
+class PulseMeter : public HostDevice {
+
+private:
+	const Pad *pad;
+	bool timing[LINES], level[LINES], read[LINES];
+	unsigned long long since[LINES];
+
+	void take(int line, int what, unsigned long long width) {
+		if(width < this->shortest[line][what])
+			this->shortest[line][what] = width;
+	}
+
+public:
+	unsigned long long shortest[LINES][3];
+
+	PulseMeter(const Pad *pad) {
+		this->pad = pad;
+
+		for(int i = 0; i < LINES; i++) {
+			this->timing[i] = false;
+			this->shortest[i][0] = this->shortest[i][1] = this->shortest[i][2] = ~0ULL;
+		}
+	}
+
+	/* A PINx read, the only thing that asks the devices */
+	virtual uint8_t drive(uint8_t port) {
+		for(int i = 0; i < LINES && this->pad->lines[i].name; i++) {
+			if(this->timing[i] && !this->read[i])
+				this->take(i, 2, Host::cycles - this->since[i]);
+
+			this->read[i] = true;
+		}
+
+		return 0xFF;
+	}
+
+	virtual void pins() {
+		for(int i = 0; i < LINES && this->pad->lines[i].name; i++) {
+			uint8_t pin = this->pad->lines[i].pin;
+			uint8_t ddr = (HOST_PIN_PORT(pin) == HOST_PORT_D) ? DDRD : DDRB;
+			bool level = Host::output(pin);
+
+			// Pull-ups (detection) don't count, nor the first level driven
+			if(!(ddr & _BV(HOST_PIN_BIT(pin)))) {
+				this->timing[i] = false;
+				continue;
+			}
+
+			if(this->timing[i] && level == this->level[i])
+				continue;
+
+			if(this->timing[i])
+				this->take(i, this->level[i], Host::cycles - this->since[i]);
+
+			this->timing[i] = true;
+			this->level[i] = level;
+			this->read[i] = false;
+			this->since[i] = Host::cycles;
+		}
+	}
+};
+
+static HostWiimote wiimote;
+static unsigned long fetches = 0;
+
+static void on_read(uint8_t addr, const uint8_t *data, uint8_t n) {
+	if(++fetches == FETCHES)
+		throw HostStop();
+}
+
+static HostDevice *model(const char *name) {
+	if(!strcmp(name, "nes"))
+		return new HostNesPad(false);
+	if(!strncmp(name, "genesis", 7))
+		return new HostGenesisPad(!strcmp(name, "genesis6"));
+	if(!strcmp(name, "saturn"))
+		return new HostSaturnPad();
+	if(!strcmp(name, "tg16"))
+		return new HostTg16Pad();
+
+	return new HostPs2Pad();
+}
+
+/* One pad, on a fresh firmware (run in its own process) */
+static int run(const Pad *pad) {
+	static const uint8_t init1 = 0x55, init2 = 0x00;
+	PulseMeter meter(pad);
+	int failed = 0;
+
+	Host::reset();
+	Host::attach(model(pad->name));
+	Host::attach(&meter);
+	Host::attach(&wiimote);
+
+	wiimote.poll_us = 5000;
+	wiimote.on_read = on_read;
+	wiimote.write(0xF0, &init1, 1);
+	wiimote.write(0xFB, &init2, 1);
+
+	sei();
+
+	try {
+		setup();
+
+		for(;;)
+			loop();
+	} catch(HostStop &) {
+	}
+
+	for(int i = 0; i < LINES && pad->lines[i].name; i++) {
+		const Line *l = &pad->lines[i];
+
+		for(int what = 0; what < 3; what++) {
+			unsigned long long c = meter.shortest[i][what];
+			unsigned long ns = c * 1000000000ULL / F_CPU;
+
+			if(!(l->check & (1 << what)))
+				continue;
+
+			if(c == ~0ULL) {
+				printf("FAIL %s %s %s: never seen\n", pad->name, l->name, checks[what]);
+				failed = 1;
+				continue;
+			}
+
+			printf("  %s %s %s: shortest %.3fus, at least %.3fus\n", pad->name, l->name,
+					checks[what], ns / 1000.0, l->min_ns / 1000.0);
+
+			if(ns < l->min_ns) {
+				printf("FAIL %s %s %s\n", pad->name, l->name, checks[what]);
+				failed = 1;
+			}
+		}
+	}
+
+	return failed;
+}
+
+int main() {
+	int status, failed = 0;
+
+	fflush(stdout);
+
+	for(unsigned int i = 0; i < PADS; i++) {
+		if(!fork())
+			exit(run(&pads[i]));
+
+		wait(&status);
+		if(!WIFEXITED(status) || WEXITSTATUS(status))
+			failed++;
+	}
+
+	printf(failed ? "FAILED (%d)\n" : "ok\n", failed);
+
+	return failed ? 1 : 0;
+}
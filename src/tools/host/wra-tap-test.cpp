@@ -0,0 +1,337 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tap test for the report latch (WMExtension::latched_buttons).
+ *
+ * A button pressed and released between two Wiimote fetches must be in
+ * the next report once, and only once. Runs with the report read plain,
+ * encrypted and in data format 3. The Wiimote is HostTwi, the pad loop is
+ * this file calling set_button_data().
+ *
+ * Built with TAP_LATCH=0 (against WMExtension.cpp without the latch, see
+ * the Makefile) it is wra-tap-baseline: it counts the taps the adapter
+ * drops without the latch, and checks that the short tap cases do fail
+ * there, so they can't pass by accident.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <WProgram.h>
+#include "WMExtension.h"
+#include "WMCrypt.h"
+#include "Host.h"
+#include "HostTwi.h"
+
+#ifndef TAP_LATCH
+#define TAP_LATCH	1
+#endif
+
+// A button, report byte 5 (format 1) or 7 (format 3), bit 4, 0 when pressed
+#define A_BIT	0x10
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+	if(!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while(0)
+
+static unsigned char ft[8], sb[8];
+static bool crypt = false;
+static byte format = 1;
+
+/* Register write, encrypted as the Wiimote does once a key is set */
+static void write_reg(byte addr, byte data) {
+	if(crypt)
+		data = (data - ft[addr % 8]) ^ sb[addr % 8];
+
+	HostTwi::write_regs(addr, &data, 1);
+}
+
+/* Reports A from the pad, without the rest of the pad loop pass */
+static void report(bool a) {
+	WMExtension::set_button_data(0, 0, 0, 0, a, 0, 0, 0, 0, 0, 0, 0, 0,
+			CAL_STICK_CENTER, CAL_STICK_CENTER, CAL_STICK_CENTER, CAL_STICK_CENTER, 0, 0, 0, 0);
+}
+
+/*
+ * A Wii CC report forwarded as read (WIICC_FORWARD), with A pressed or not.
+ * Returns true if the registers have its sticks unchanged.
+ */
+static bool forward(bool a) {
+	byte r[8] = { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0 };
+	byte regs[8];
+	byte n = (format == 3) ? 8 : 6;
+
+	r[n - 2] = 0xFF;
+	r[n - 1] = a ? (byte) ~A_BIT : 0xFF;
+
+	WMExtension::forward_report(r, n);
+	WMExtension::service();
+	WMExtension::get_report(regs);
+
+	return !memcmp(regs, r, n - 2);
+}
+
+/* One pad loop pass, with A pressed or not */
+static void pad(bool a) {
+	report(a);
+	WMExtension::service();
+}
+
+/* Fetches the report as the Wiimote does, true if A is pressed in it */
+static bool fetch() {
+	byte r[8];
+	byte n = (format == 3) ? 8 : 6;
+
+	HostTwi::read_regs(0x00, r, n);
+
+	if(crypt) {
+		for(byte i = 0; i < n; i++)
+			r[i] = (r[i] ^ sb[i % 8]) + ft[i % 8];
+	}
+
+	return !(r[n - 1] & A_BIT);
+}
+
+/*
+ * Fetches once, at the first interrupt point where the plain report has A
+ * pressed: right after set_report() published it, when an encrypted fetch
+ * could still find the old mirror.
+ */
+class Fetcher : public HostDevice {
+
+public:
+	bool armed;
+	int presses;
+
+	void interrupt() {
+		byte r[8];
+
+		if(!this->armed)
+			return;
+
+		WMExtension::get_report(r);
+
+		if(r[(format == 3) ? 7 : 5] & A_BIT)
+			return;
+
+		this->armed = false;
+		this->presses += fetch();
+	}
+};
+
+static Fetcher fetcher;
+
+/*
+ * Taps shorter than the fetch interval: the pad loop does PASSES passes
+ * per fetch, the tap lasts 1 to PASSES - 1 of them and starts at each
+ * pass. Returns how many of them no fetch saw, out of *taps.
+ */
+#define PASSES	4
+
+static int dropped(int *taps) {
+	int lost = 0;
+
+	*taps = 0;
+
+	for(int len = 1; len < PASSES; len++) {
+		for(int start = 0; start < PASSES; start++) {
+			int presses = 0;
+
+			for(int p = 0; p < 3 * PASSES; p++) {
+				pad(p >= start && p < start + len);
+
+				if(p % PASSES == PASSES - 1)
+					presses += fetch();
+			}
+
+			(*taps)++;
+			lost += !presses;
+		}
+	}
+
+	return lost;
+}
+
+/*
+ * Tap seen by a single pad pass, released on the next one, both between
+ * two fetches. Returns how many fetches saw it, 1 with the latch.
+ */
+static int short_tap() {
+	int presses;
+
+	pad(true);
+	pad(false);
+
+	presses = fetch();
+	presses += fetch();
+
+	return presses;
+}
+
+/*
+ * Encrypted fetch right after set_report() published a tap (see Fetcher),
+ * then the release. Returns how many fetches saw it, 1 with the latch.
+ */
+static int tap_at_publish() {
+	fetcher.armed = true;
+	fetcher.presses = 0;
+	report(true);
+	fetcher.armed = false;
+
+	pad(false);
+
+	return fetcher.presses + fetch();
+}
+
+/* Writes a key the way the Wiimote does, in 6 + 6 + 4 byte chunks */
+static void set_key(const byte *key) {
+	HostTwi::write_regs(0x40, key, 6);
+	HostTwi::write_regs(0x46, key + 6, 6);
+	HostTwi::write_regs(0x4C, key + 12, 4);
+
+	WMCrypt::wiimote_gen_key(key, ft, sb);
+	crypt = true;
+}
+
+static void run(const char *name) {
+	int presses, lost, taps;
+
+	// Idle, nothing pressed
+	pad(false);
+	CHECK(!fetch(), "%s: A pressed at rest", name);
+
+	lost = dropped(&taps);
+	printf("  %s: %d of %d taps shorter than a fetch interval dropped\n", name, lost, taps);
+
+#if !TAP_LATCH
+	// Baseline: the adapter without the latch drops taps, and the short
+	// tap cases below can tell
+	CHECK(lost > 0, "%s: no tap dropped without the latch", name);
+	CHECK(short_tap() == 0, "%s: short tap seen without the latch", name);
+	if(crypt)
+		CHECK(tap_at_publish() == 0, "%s: tap at publish seen without the latch", name);
+	return;
+#endif
+
+	CHECK(!lost, "%s: %d of %d taps dropped", name, lost, taps);
+
+	// Tap between two fetches: in the next report, once
+	pad(true);
+	pad(false);
+	pad(false);
+
+	presses = fetch();
+	presses += fetch();
+	presses += fetch();
+	CHECK(presses == 1, "%s: tap seen %d times", name, presses);
+
+	// Tap seen by a single pad pass: the next pass already has it
+	// released, only the latch has it at the fetch
+	presses = short_tap();
+	CHECK(presses == 1, "%s: single pass tap seen %d times", name, presses);
+
+	// Same through a forwarded report
+	CHECK(forward(true) && forward(false), "%s: forwarded sticks changed", name);
+	presses = fetch();
+	presses += fetch();
+	CHECK(presses == 1, "%s: forwarded tap seen %d times", name, presses);
+
+	// Encrypted fetch between the report and its mirror being updated:
+	// it must send the tap, the fetch clears the latch
+	if(crypt) {
+		presses = tap_at_publish();
+		CHECK(presses == 1, "%s: tap fetched as it was published seen %d times", name, presses);
+	}
+
+	// Two taps between fetches are one report
+	pad(true);
+	pad(false);
+	pad(true);
+	pad(false);
+
+	presses = fetch();
+	presses += fetch();
+	CHECK(presses == 1, "%s: double tap seen %d times", name, presses);
+
+	// Held across fetches: in every report until released
+	pad(true);
+	CHECK(fetch(), "%s: held A missing", name);
+	pad(true);
+	CHECK(fetch(), "%s: held A missing after a pad pass", name);
+	CHECK(fetch(), "%s: held A missing on a fetch with no pad pass", name);
+	pad(false);
+	CHECK(!fetch(), "%s: A still pressed after release", name);
+
+	// Tap while a fetch is in progress: the press lands after the latch was
+	// cleared, so it belongs to the next report
+	HostTwi::write_regs(0x00, NULL, 0);
+	HostTwi::start(true);
+	HostTwi::read(true);
+	pad(true);
+	pad(false);
+
+	for(int i = 1; i < ((format == 3) ? 8 : 6); i++)
+		HostTwi::read(i < ((format == 3) ? 7 : 5));
+
+	HostTwi::stop();
+
+	presses = fetch();
+	presses += fetch();
+	CHECK(presses == 1, "%s: tap during a fetch seen %d times", name, presses);
+}
+
+int main() {
+	static const byte key[16] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+			0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x01 };
+
+	Host::reset();
+	Host::attach(&fetcher);
+	sei();
+
+	WMExtension::init();
+
+	// New style init, no encryption
+	write_reg(0xF0, 0x55);
+	write_reg(0xFB, 0x00);
+	run("format 1, plain");
+
+	format = 3;
+	write_reg(0xFE, 0x03);
+	run("format 3, plain");
+
+	format = 1;
+	write_reg(0xFE, 0x01);
+	set_key(key);
+	run("format 1, encrypted");
+
+	format = 3;
+	write_reg(0xFE, 0x03);
+	run("format 3, encrypted");
+
+	printf(failures ? "FAILED (%d)\n" : "ok\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,621 @@
+/*
+ * Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+ * Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Cycle exact bench of the real wra.elf on simavr, with a NES pad on the
+ * DB9 port and a Wiimote fetching the report over a 400kHz bus.
+ *
+ * Build (simavr 1.6 or later, the TWI unit must support slave mode):
+ *   gcc -O2 -std=gnu99 -I/usr/local/include/simavr -o wra-bench wra-bench.c -lsimavr -lelf
+ *
+ * Firmware: make SIMAVR=1 with Makefile.mk (328p) or Makefile.mk.168, so
+ * wra.elf carries its MCU and 8MHz clock (see simavr.c). -m / -f are for
+ * an ELF built without it.
+ *
+ * Usage: wra-bench [-p poll_us] [-r bus_hz] [-n presses] [-k] [-m mcu] [-f hz] wra.elf
+ *
+ * Measures, in CPU cycles (and us):
+ *  - pad edge to report on the wire: A is pressed at random points of the
+ *    fetch cycle and held until a report has it, from the contact closing
+ *    to the report byte with it read by the Wiimote
+ *  - clock stretching per read: how long the adapter held SCL low on one
+ *    report read, all bytes together (from SLA+R to the last byte)
+ *  - interrupts off: the longest run of instructions with the I flag
+ *    clear (cli sections and ISRs), and the PC it started at. Counted
+ *    from the first report read on, pad detection and init are left out
+ *  - NES LATCH and CLOCK pulse widths, checked against NES_PULSE_NS of
+ *    NESPad.h (see Delay.h): the shortest pulse must be that plus at most
+ *    NES_PULSE_SLACK cycles. Longer ones are ISRs landing in the pulse.
+ *    Exits with 1 if a check fails
+ *
+ * -k measures the encryption key setup instead: the Wiimote writes keys
+ * (one per ans_tbl index, then the idx = 7 fallback, as in wra-crypt-test)
+ * with no read in between, so the main loop generates each one. Needs a
+ * PROFILER = 1 build, the figures are the PROF_GEN_KEY (service()) and
+ * PROF_RECEIVE (TWI ISR) slots read from profiler_slots.
+ *
+ * The host harness (src/tools/host, wra-latency-test) models the same
+ * setup without a simulator, this is the reference for real figures.
+ *
+ * No figures from this bench are recorded yet: it has only been compiled
+ * against the simavr headers, never run on a wra.elf. Run it (both MCUs)
+ * and put the numbers in the commit before quoting any cycle count.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <gelf.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_cycle_timers.h"
+#include "avr_ioport.h"
+#include "avr_twi.h"
+
+#define WM_ADDRESS		0x52
+#define WM_TIMEOUT_US	20000 // the adapter didn't answer a bus event
+
+// NES pad (NESPad.h), port D bits
+#define NES_CLOCK	2
+#define NES_LATCH	3
+#define NES_DATA	4
+
+// NESPad.cpp pulses: NES_PULSE_NS (NESPad.h), then the cbi ending it (2 cycles)
+#define NES_PULSE_NS	1750
+#define NES_PULSE_SLACK	4
+
+// A: shifted out first, report byte 5 bit 4 (0 = pressed)
+#define A_BIT		0x10
+
+#define NEVER		(~(avr_cycle_count_t) 0)
+
+// Profiler.h
+#define PROF_RECEIVE	6
+#define PROF_GEN_KEY	7
+#define PROF_SLOT_SIZE	20 // start, min, max (16 bit), total, count (32 bit), isr (16), interrupted (32)
+#define PROF_TICK		1 // Timer1 at clk/1 in PROFILER builds
+
+// Key setup (-k): the first 6 bytes of each key are the random part, the
+// Wiimote side of wra-crypt-test's vectors. Last one matches no index.
+static const uint8_t keys[][16] = {
+	{ 0xC3, 0x7D, 0x1F, 0xB6, 0x48, 0xE2, 0x07, 0x5C, 0x91, 0x3A, 0x4B, 0x5B, 0xE1, 0x0D, 0x3B, 0xA3 },
+	{ 0x1E, 0x0F, 0xF0, 0xDE, 0xBC, 0x9A, 0x78, 0x56, 0x34, 0x12, 0x9E, 0xEA, 0xD3, 0x2A, 0x0E, 0x02 },
+	{ 0x18, 0x81, 0xF0, 0x0F, 0x69, 0x96, 0x3C, 0xC3, 0x5A, 0xA5, 0x5B, 0x65, 0x21, 0x36, 0x56, 0x33 },
+	{ 0x0A, 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x60, 0x44, 0x08, 0x6D, 0xDD, 0x35 },
+	{ 0xCD, 0xEF, 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0x05, 0x11, 0xA9, 0x8E, 0x10, 0xC6 },
+	{ 0x3D, 0xF6, 0x53, 0xA8, 0x77, 0x0C, 0xD1, 0x94, 0x2E, 0x6B, 0xAE, 0xE6, 0xE3, 0x64, 0x9E, 0x31 },
+	{ 0x99, 0x42, 0xFE, 0xCA, 0xD0, 0xBA, 0x15, 0xEE, 0xFF, 0xC0, 0x54, 0xF0, 0xED, 0x24, 0x4B, 0xC9 },
+	{ 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x01 },
+};
+
+#define KEYS		(sizeof(keys) / sizeof(keys[0]))
+
+typedef struct {
+	avr_cycle_count_t min, max, sum;
+	unsigned long n;
+} stat_t;
+
+static avr_t *avr;
+
+static void stat_add(stat_t *s, avr_cycle_count_t v) {
+	if(!s->n || v < s->min)
+		s->min = v;
+	if(v > s->max)
+		s->max = v;
+	s->sum += v;
+	s->n++;
+}
+
+static double us(avr_cycle_count_t c) {
+	return (double) c * 1000000.0 / avr->frequency;
+}
+
+static void stat_print(const char *name, stat_t *s) {
+	if(!s->n) {
+		printf("  %s: none\n", name);
+		return;
+	}
+
+	printf("  %s: min %llu avg %llu max %llu cycles (%.1f / %.1f / %.1fus), %lu samples\n",
+			name, (unsigned long long) s->min, (unsigned long long) (s->sum / s->n),
+			(unsigned long long) s->max, us(s->min), us(s->sum / s->n), us(s->max), s->n);
+}
+
+/*
+ * NES pad: a 4021 shift register. LATCH high loads the buttons, CLOCK
+ * rising edges shift them out on DATA, low = pressed. DB9 pin 9 (PB0) is
+ * grounded by the cable, that's how the adapter detects it.
+ */
+static struct {
+	avr_irq_t *data;
+	uint8_t port, ddr;
+	uint8_t shift;
+	int clock, latch;
+	avr_cycle_count_t press_at, release_at;
+	avr_cycle_count_t clock_at, latch_at;
+} nes;
+
+static stat_t latch_width, clock_width;
+
+static void nes_pins(void) {
+	uint8_t level = (nes.port & nes.ddr) | ~nes.ddr;
+	int clock = (level >> NES_CLOCK) & 1;
+	int latch = (level >> NES_LATCH) & 1;
+
+	// Only pulses driven by the adapter, not the pull-ups before init
+	if((nes.ddr >> NES_LATCH) & 1) {
+		if(latch && !nes.latch)
+			nes.latch_at = avr->cycle;
+		else if(!latch && nes.latch)
+			stat_add(&latch_width, avr->cycle - nes.latch_at);
+	}
+
+	if((nes.ddr >> NES_CLOCK) & 1) {
+		if(clock && !nes.clock)
+			nes.clock_at = avr->cycle;
+		else if(!clock && nes.clock)
+			stat_add(&clock_width, avr->cycle - nes.clock_at);
+	}
+
+	nes.latch = latch;
+
+	if(latch)
+		nes.shift = (avr->cycle >= nes.press_at && avr->cycle < nes.release_at) ? 0x01 : 0x00;
+	else if(clock && !nes.clock)
+		nes.shift >>= 1;
+
+	nes.clock = clock;
+
+	avr_raise_irq(nes.data, !(nes.shift & 1));
+}
+
+/* Shortest pulse within NES_PULSE_NS + NES_PULSE_SLACK cycles, returns 0 if not */
+static int pulse_check(const char *name, stat_t *s) {
+	avr_cycle_count_t want = ((unsigned long long) NES_PULSE_NS * avr->frequency + 500000000ULL) / 1000000000ULL;
+
+	stat_print(name, s);
+
+	if(s->n && s->min >= want && s->min <= want + NES_PULSE_SLACK)
+		return 1;
+
+	printf("  FAIL: %s should be %llu to %llu cycles at the shortest\n", name,
+			(unsigned long long) want, (unsigned long long) (want + NES_PULSE_SLACK));
+
+	return 0;
+}
+
+static void nes_port(struct avr_irq_t *irq, uint32_t value, void *param) {
+	nes.port = value;
+	nes_pins();
+}
+
+static void nes_ddr(struct avr_irq_t *irq, uint32_t value, void *param) {
+	nes.ddr = value;
+	nes_pins();
+}
+
+static void nes_init(void) {
+	static const int high[] = { 3, 5, 6, 7 }; // DB9 pins 2, 4, 6, 7
+
+	nes.data = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), NES_DATA);
+	nes.press_at = nes.release_at = NEVER;
+
+	for(int i = 0; i < 4; i++)
+		avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), high[i]), 1);
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), 0), 0);
+	avr_raise_irq(nes.data, 1);
+
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), IOPORT_IRQ_REG_PORT),
+			nes_port, NULL);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), IOPORT_IRQ_DIRECTION_ALL),
+			nes_ddr, NULL);
+}
+
+/*
+ * The Wiimote, bus master. A transaction is a list of bus events sent to
+ * the TWI unit one at a time. Each goes out once its bits have gone by on
+ * the bus; if it needs an answer (ACK, or the next byte when reading) the
+ * master waits for the adapter to give it: that is the clock stretching.
+ */
+#define W_START_W	0
+#define W_START_R	1
+#define W_WRITE		2
+#define W_READ		3	// data: ACK the byte, the adapter sends one more
+#define W_STOP		4
+
+static struct {
+	avr_irq_t *in;
+	uint32_t rate, poll_us;
+	avr_cycle_count_t bit;
+
+	struct {
+		uint8_t what, data;
+	} ev[64];
+	int n, i;
+
+	int busy, waiting, inited;
+	avr_cycle_count_t sent, stretch;
+	uint8_t report[6];
+	int count;
+	unsigned long presses, wanted;
+	int measuring;
+	unsigned int keys; // -k: keys written so far
+} wm;
+
+static int key_mode = 0;
+
+static stat_t latency, stretch, irq_off;
+static uint32_t irq_off_pc;
+
+static void wm_push(uint8_t what, uint8_t data) {
+	wm.ev[wm.n].what = what;
+	wm.ev[wm.n].data = data;
+	wm.n++;
+}
+
+static void wm_write(uint8_t addr, const uint8_t *data, int n) {
+	wm_push(W_START_W, 0);
+	wm_push(W_WRITE, addr);
+
+	for(int i = 0; i < n; i++)
+		wm_push(W_WRITE, data[i]);
+
+	wm_push(W_STOP, 0);
+}
+
+static void wm_read(uint8_t addr, int n) {
+	wm_push(W_START_W, 0);
+	wm_push(W_WRITE, addr);
+	wm_push(W_STOP, 0);
+	wm_push(W_START_R, 0);
+
+	for(int i = 0; i < n; i++)
+		wm_push(W_READ, i < n - 1);
+
+	wm_push(W_STOP, 0);
+}
+
+static int wm_bits(uint8_t what) {
+	return (what == W_STOP) ? 1 : ((what == W_START_W || what == W_START_R) ? 10 : 9);
+}
+
+static avr_cycle_count_t wm_event(struct avr_t *avr, avr_cycle_count_t when, void *param);
+
+/* Next event, once its bits are on the bus */
+static void wm_next(void) {
+	if(wm.i < wm.n)
+		avr_cycle_timer_register(avr, wm_bits(wm.ev[wm.i].what) * wm.bit, wm_event, NULL);
+	else
+		wm.busy = 0;
+}
+
+/* A full report is in */
+static void wm_report(void) {
+	int a = !(wm.report[5] & A_BIT);
+
+	if(nes.release_at == NEVER) {
+		if(a && avr->cycle >= nes.press_at) {
+			stat_add(&latency, avr->cycle - nes.press_at);
+			nes.release_at = avr->cycle + avr_usec_to_cycles(avr, random() % (3 * wm.poll_us));
+		}
+	} else if(avr->cycle >= nes.release_at && !a) {
+		wm.presses++;
+		nes.press_at = avr->cycle + avr_usec_to_cycles(avr, random() % (3 * wm.poll_us));
+		nes.release_at = NEVER;
+	}
+
+	wm.measuring = 1;
+}
+
+static avr_cycle_count_t wm_event(struct avr_t *avr, avr_cycle_count_t when, void *param) {
+	uint8_t what = wm.ev[wm.i].what, data = wm.ev[wm.i].data;
+	uint8_t sla = WM_ADDRESS << 1;
+
+	wm.i++;
+	wm.sent = avr->cycle;
+
+	switch(what) {
+	case W_START_W:
+		wm.waiting = 1;
+		avr_raise_irq(wm.in, avr_twi_irq_msg(TWI_COND_START | TWI_COND_ADDR, sla, 0));
+		break;
+	case W_START_R:
+		wm.waiting = 1;
+		wm.count = 0;
+		wm.stretch = 0;
+		avr_raise_irq(wm.in, avr_twi_irq_msg(TWI_COND_START | TWI_COND_ADDR, sla | 1, 0));
+		break;
+	case W_WRITE:
+		wm.waiting = 1;
+		avr_raise_irq(wm.in, avr_twi_irq_msg(TWI_COND_WRITE, sla, data));
+		break;
+	case W_READ:
+		// ACK asks the adapter for one more byte, NACK ends the read
+		wm.waiting = data;
+		avr_raise_irq(wm.in, avr_twi_irq_msg(TWI_COND_READ | (data ? TWI_COND_ACK : 0), sla | 1, data));
+		if(!data)
+			wm_next();
+		break;
+	default:
+		avr_raise_irq(wm.in, avr_twi_irq_msg(TWI_COND_STOP, sla, 0));
+		if(wm.count == 6) {
+			wm.count = 0;
+			stat_add(&stretch, wm.stretch);
+			wm_report();
+		}
+		wm_next();
+		break;
+	}
+
+	return 0;
+}
+
+/* The adapter let go of SCL: an ACK, or the next byte it sends */
+static void wm_answer(struct avr_irq_t *irq, uint32_t value, void *param) {
+	avr_twi_msg_irq_t msg;
+	uint8_t what;
+
+	if(!wm.waiting)
+		return;
+
+	msg.u.v = value;
+	what = wm.ev[wm.i - 1].what;
+
+	wm.waiting = 0;
+	wm.stretch += avr->cycle - wm.sent;
+
+	if((what == W_START_R || what == W_READ) && wm.count < 6)
+		wm.report[wm.count++] = msg.u.twi.data;
+
+	wm_next();
+}
+
+/* Fetch timer: the init writes first, then a report read every poll_us */
+static avr_cycle_count_t wm_poll(struct avr_t *avr, avr_cycle_count_t when, void *param) {
+	if(wm.waiting && avr->cycle - wm.sent > avr_usec_to_cycles(avr, WM_TIMEOUT_US)) {
+		fprintf(stderr, "wra-bench: the adapter doesn't answer on the bus (TWI slave mode in this simavr?)\n");
+		exit(1);
+	}
+
+	if(!wm.busy) {
+		wm.n = wm.i = 0;
+
+		if(!wm.inited) {
+			static const uint8_t init1 = 0x55, init2 = 0x00;
+
+			wm_write(0xF0, &init1, 1);
+			wm_write(0xFB, &init2, 1);
+			wm.inited = 1;
+		}
+
+		if(key_mode) {
+			static const uint8_t enable = 0xAA;
+
+			// One key per fetch interval, written as the Wiimote does
+			if(wm.keys < KEYS) {
+				wm_write(0xF0, &enable, 1);
+				wm_write(0x40, keys[wm.keys], 6);
+				wm_write(0x46, keys[wm.keys] + 6, 6);
+				wm_write(0x4C, keys[wm.keys] + 12, 4);
+			}
+
+			wm.keys++;
+		} else {
+			wm_read(0x00, 6);
+		}
+
+		wm.busy = 1;
+		wm_next();
+	}
+
+	return when + avr_usec_to_cycles(avr, wm.poll_us);
+}
+
+/* Address of a symbol in the ELF, 0 if it isn't there */
+static uint32_t elf_symbol(const char *file, const char *name) {
+	Elf_Scn *scn = NULL;
+	uint32_t value = 0;
+	Elf *elf;
+	FILE *f;
+
+	if(elf_version(EV_CURRENT) == EV_NONE || !(f = fopen(file, "rb")))
+		return 0;
+
+	elf = elf_begin(fileno(f), ELF_C_READ, NULL);
+
+	while(elf && !value && (scn = elf_nextscn(elf, scn))) {
+		GElf_Shdr shdr;
+		Elf_Data *data;
+
+		if(!gelf_getshdr(scn, &shdr) || shdr.sh_type != SHT_SYMTAB || !(data = elf_getdata(scn, NULL)))
+			continue;
+
+		for(size_t i = 0; i < shdr.sh_size / shdr.sh_entsize; i++) {
+			GElf_Sym sym;
+
+			if(gelf_getsym(data, i, &sym) && !strcmp(elf_strptr(elf, shdr.sh_link, sym.st_name), name)) {
+				value = sym.st_value;
+				break;
+			}
+		}
+	}
+
+	if(elf)
+		elf_end(elf);
+	fclose(f);
+
+	return value;
+}
+
+/* min / max of a profiler slot, in cycles. SRAM symbols are at 0x800000 + address */
+static void profiler_print(const char *name, uint32_t slots, int slot) {
+	uint8_t *s = avr->data + (slots & 0xFFFF) + slot * PROF_SLOT_SIZE;
+	uint32_t count = s[10] | (s[11] << 8) | ((uint32_t) s[12] << 16) | ((uint32_t) s[13] << 24);
+	uint32_t interrupted = s[16] | (s[17] << 8) | ((uint32_t) s[18] << 16) | ((uint32_t) s[19] << 24);
+	uint16_t min = s[2] | (s[3] << 8), max = s[4] | (s[5] << 8);
+
+	if(!count) {
+		printf("  %s: not run\n", name);
+		return;
+	}
+
+	printf("  %s: min %u max %u cycles (%.1f / %.1fus), %lu runs, %lu interrupted\n", name,
+			min * PROF_TICK, max * PROF_TICK, min * PROF_TICK * 1e6 / avr->frequency,
+			max * PROF_TICK * 1e6 / avr->frequency, (unsigned long) count, (unsigned long) interrupted);
+}
+
+static void wm_init(void) {
+	wm.in = avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT);
+	wm.bit = avr->frequency / wm.rate;
+
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT),
+			wm_answer, NULL);
+
+	// First fetch once the adapter is up and the pad detected
+	avr_cycle_timer_register_usec(avr, 100000, wm_poll, NULL);
+	nes.press_at = avr_usec_to_cycles(avr, 150000);
+}
+
+int main(int argc, char **argv) {
+	elf_firmware_t f;
+	const char *mmcu = NULL;
+	uint32_t frequency = 0;
+	avr_cycle_count_t off_start = 0;
+	uint32_t off_pc = 0;
+	int opt, irq_on = 1, state, ok;
+	uint32_t slots = 0;
+
+	wm.rate = 400000;
+	wm.poll_us = 5000;
+	wm.wanted = 200;
+
+	while((opt = getopt(argc, argv, "p:r:n:km:f:")) != -1) {
+		switch(opt) {
+		case 'p':
+			wm.poll_us = atol(optarg);
+			break;
+		case 'r':
+			wm.rate = atol(optarg);
+			break;
+		case 'n':
+			wm.wanted = atol(optarg);
+			break;
+		case 'k':
+			key_mode = 1;
+			break;
+		case 'm':
+			mmcu = optarg;
+			break;
+		case 'f':
+			frequency = atol(optarg);
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+
+	if(optind != argc - 1) {
+		fprintf(stderr, "usage: %s [-p poll_us] [-r bus_hz] [-n presses] [-k] [-m mcu] [-f hz] wra.elf\n", argv[0]);
+		return 2;
+	}
+
+	memset(&f, 0, sizeof(f));
+	if(elf_read_firmware(argv[optind], &f) != 0) {
+		fprintf(stderr, "wra-bench: can't load %s\n", argv[optind]);
+		return 1;
+	}
+
+	if(mmcu)
+		strncpy(f.mmcu, mmcu, sizeof(f.mmcu) - 1);
+	if(frequency)
+		f.frequency = frequency;
+
+	if(!f.mmcu[0] || !f.frequency) {
+		fprintf(stderr, "wra-bench: no MCU / clock in %s, build with SIMAVR = 1 or give -m and -f\n", argv[optind]);
+		return 1;
+	}
+
+	if(key_mode && !(slots = elf_symbol(argv[optind], "profiler_slots"))) {
+		fprintf(stderr, "wra-bench: no profiler_slots in %s, -k needs PROFILER = 1\n", argv[optind]);
+		return 1;
+	}
+
+	avr = avr_make_mcu_by_name(f.mmcu);
+	if(!avr) {
+		fprintf(stderr, "wra-bench: unknown MCU %s\n", f.mmcu);
+		return 1;
+	}
+
+	avr_init(avr);
+	avr_load_firmware(avr, &f);
+
+	srandom(1);
+	nes_init();
+	wm_init();
+
+	// One instruction per avr_run(), the I flag is checked after each. -k
+	// runs two more fetch intervals after the last key, for service()
+	while(key_mode ? wm.keys < KEYS + 2 : wm.presses < wm.wanted) {
+		state = avr_run(avr);
+
+		if(state == cpu_Done || state == cpu_Crashed) {
+			fprintf(stderr, "wra-bench: the firmware stopped (state %d) at PC 0x%04x\n", state, avr->pc);
+			return 1;
+		}
+
+		if(!wm.measuring)
+			continue;
+
+		if(irq_on && !avr->sreg[S_I]) {
+			off_start = avr->cycle;
+			off_pc = avr->pc;
+		} else if(!irq_on && avr->sreg[S_I]) {
+			if(avr->cycle - off_start > irq_off.max)
+				irq_off_pc = off_pc;
+			stat_add(&irq_off, avr->cycle - off_start);
+		}
+
+		irq_on = avr->sreg[S_I];
+	}
+
+	if(key_mode) {
+		printf("%s at %luHz, %u key setups, one every %luus\n", f.mmcu,
+				(unsigned long) avr->frequency, (unsigned) KEYS, (unsigned long) wm.poll_us);
+		profiler_print("key generation in service() (PROF_GEN_KEY)", slots, PROF_GEN_KEY);
+		profiler_print("receive_bytes() in the TWI ISR (PROF_RECEIVE)", slots, PROF_RECEIVE);
+		return 0;
+	}
+
+	printf("%s at %luHz, NES pad, Wiimote at %luHz fetching every %luus, %lu presses\n",
+			f.mmcu, (unsigned long) avr->frequency, (unsigned long) wm.rate,
+			(unsigned long) wm.poll_us, wm.presses);
+	stat_print("pad edge to report on the wire", &latency);
+	stat_print("clock stretching per report read", &stretch);
+	stat_print("interrupts off", &irq_off);
+	printf("  longest interrupts off from PC 0x%04x (avr-objdump -d wra.elf)\n", (unsigned) irq_off_pc);
+
+	ok = pulse_check("NES LATCH pulse", &latch_width);
+	ok &= pulse_check("NES CLOCK pulse", &clock_width);
+
+	return !ok;
+}
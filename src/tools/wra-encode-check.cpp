@@ -0,0 +1,421 @@
+/*
+ * Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+ * Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host side equivalence checker for the report encoding (see WMReport.h).
+ *
+ * The firmware encoder (WMReport::pack() + WMReport::encode(), built from
+ * the firmware sources as is) is diffed against an independent reference
+ * written from the Classic Controller report layout. The reference works
+ * on batches of inputs laid out as arrays, so the compiler vectorizes it,
+ * and batches are spread over all cores.
+ *
+ * The whole input space (15 buttons x 6 analog bytes x format, 2^64) is
+ * out of reach, but the encoding only mixes bits within report bytes, so
+ * these strata cover it:
+ *   buttons  every button combination, with a few random sticks
+ *   rx-ry-lt every rx, ry, lt value together (they share byte 2)
+ *   lx-rx    every lx, rx pair (byte 0)
+ *   ly-rx    every ly, rx pair (byte 1)
+ *   lt-rt    every lt, rt pair (byte 3)
+ *   random   -n random inputs over everything, any format byte
+ * Each one runs in format 1 and format 3. Pressed buttons are passed as
+ * random non zero ints, as the pad loops do.
+ *
+ * Build: g++ -O3 -march=native -pthread -o wra-encode-check wra-encode-check.cpp
+ *
+ * Usage: wra-encode-check [-j threads] [-n random] [-s seed] [-b sticks]
+ *   -j  worker threads, all cores by default
+ *   -n  random inputs, 2^26 by default
+ *   -s  seed of the random inputs
+ *   -b  random stick sets per button combination, 64 by default
+ *
+ * Exits with 1 and lists the first mismatches if the encoders differ.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../wii-retropad-adapter/WMReport.h"
+
+#define BATCH			4096
+#define MAX_MISMATCHES	10
+
+// Button bits of an input, in set_button_data() argument order
+enum {
+	BDL, BDR, BDU, BDD, BA, BB, BX, BY, BLT, BRT, BMINUS, BPLUS, BHOME, BZL,
+	BZR, BUTTONS
+};
+
+static const char *button_names[BUTTONS] = { "dl", "dr", "du", "dd", "a", "b",
+		"x", "y", "lt", "rt", "-", "+", "home", "zl", "zr" };
+
+enum { LX, LY, RX, RY, LT, RT, AXES };
+
+/* One batch of inputs, one array per field */
+struct Batch {
+	size_t n;
+	uint16_t buttons[BATCH];
+	int32_t pressed[BATCH]; // Value passed for a pressed button
+	uint8_t axes[AXES][BATCH];
+	uint8_t format[BATCH];
+};
+
+struct Stratum {
+	const char *name;
+	uint64_t size;
+	void (*fill)(Batch &batch, uint64_t first, uint64_t count, uint64_t seed);
+};
+
+static uint64_t splitmix64(uint64_t x) {
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+/* Random fields for input i, the strata overwrite the ones they enumerate */
+static void fill_random(Batch &b, size_t k, uint64_t i, uint64_t seed, int stratum) {
+	uint64_t r = splitmix64(seed ^ ((uint64_t)stratum << 56) ^ i);
+	uint64_t s = splitmix64(r);
+	int32_t pressed = (int32_t)(s >> 32);
+
+	b.buttons[k] = r & 0x7FFF;
+	b.pressed[k] = pressed ? pressed : 1;
+
+	for(int a = 0; a < AXES; a++)
+		b.axes[a][k] = r >> (16 + a * 8);
+
+	b.format[k] = (s & 1) ? 0x03 : 0x01;
+}
+
+static void fill_buttons(Batch &b, uint64_t first, uint64_t count, uint64_t seed) {
+	for(size_t k = 0; k < count; k++) {
+		uint64_t i = first + k;
+
+		fill_random(b, k, i, seed, 0);
+		b.buttons[k] = i & 0x7FFF;
+		b.format[k] = (i & 0x8000) ? 0x03 : 0x01;
+	}
+}
+
+static void fill_rx_ry_lt(Batch &b, uint64_t first, uint64_t count, uint64_t seed) {
+	for(size_t k = 0; k < count; k++) {
+		uint64_t i = first + k;
+
+		fill_random(b, k, i, seed, 1);
+		b.axes[RX][k] = i;
+		b.axes[RY][k] = i >> 8;
+		b.axes[LT][k] = i >> 16;
+		b.format[k] = (i >> 24) ? 0x03 : 0x01;
+	}
+}
+
+static void fill_pair(Batch &b, uint64_t first, uint64_t count, uint64_t seed,
+		int stratum, int a1, int a2) {
+	for(size_t k = 0; k < count; k++) {
+		uint64_t i = first + k;
+
+		fill_random(b, k, i, seed, stratum);
+		b.axes[a1][k] = i;
+		b.axes[a2][k] = i >> 8;
+		b.format[k] = (i >> 16) ? 0x03 : 0x01;
+	}
+}
+
+static void fill_lx_rx(Batch &b, uint64_t first, uint64_t count, uint64_t seed) {
+	fill_pair(b, first, count, seed, 2, LX, RX);
+}
+
+static void fill_ly_rx(Batch &b, uint64_t first, uint64_t count, uint64_t seed) {
+	fill_pair(b, first, count, seed, 3, LY, RX);
+}
+
+static void fill_lt_rt(Batch &b, uint64_t first, uint64_t count, uint64_t seed) {
+	fill_pair(b, first, count, seed, 4, LT, RT);
+}
+
+/* Any format byte, the firmware treats everything but 0x03 as format 1 */
+static void fill_any(Batch &b, uint64_t first, uint64_t count, uint64_t seed) {
+	for(size_t k = 0; k < count; k++) {
+		uint64_t i = first + k;
+
+		fill_random(b, k, i, seed, 5);
+		b.format[k] = splitmix64(~i ^ seed);
+	}
+}
+
+#define BIT(m, n)	(((m) >> (n)) & 1)
+
+/*
+ * Reference encoder, straight from the report layout. Every loop goes over
+ * the whole batch with no branches on the data so it vectorizes.
+ */
+static void reference(const Batch &in, uint8_t out[8][BATCH]) {
+	uint8_t b1[BATCH], b2[BATCH];
+	uint8_t f3[BATCH];
+	size_t n = in.n;
+
+	for(size_t k = 0; k < n; k++) {
+		uint16_t m = in.buttons[k];
+
+		b1[k] = ~((BIT(m, BDR) << 7) | (BIT(m, BDD) << 6) | (BIT(m, BLT) << 5)
+				| (BIT(m, BMINUS) << 4) | (BIT(m, BHOME) << 3)
+				| (BIT(m, BPLUS) << 2) | (BIT(m, BRT) << 1));
+
+		b2[k] = ~((BIT(m, BZL) << 7) | (BIT(m, BB) << 6) | (BIT(m, BY) << 5)
+				| (BIT(m, BA) << 4) | (BIT(m, BX) << 3) | (BIT(m, BZR) << 2)
+				| (BIT(m, BDL) << 1) | BIT(m, BDU));
+
+		f3[k] = -(uint8_t)(in.format[k] == 0x03);
+	}
+
+	for(size_t k = 0; k < n; k++) {
+		// Format 1: 6 bit left stick, 5 bit right stick and triggers
+		uint8_t lx = in.axes[LX][k] >> 2, ly = in.axes[LY][k] >> 2;
+		uint8_t rx = in.axes[RX][k] >> 3, ry = in.axes[RY][k] >> 3;
+		uint8_t lt = in.axes[LT][k] >> 3, rt = in.axes[RT][k] >> 3;
+		uint8_t r1[8], r3[8];
+
+		r1[0] = (BIT(rx, 4) << 7) | (BIT(rx, 3) << 6) | lx;
+		r1[1] = (BIT(rx, 2) << 7) | (BIT(rx, 1) << 6) | ly;
+		r1[2] = (BIT(rx, 0) << 7) | (BIT(lt, 4) << 6) | (BIT(lt, 3) << 5) | ry;
+		r1[3] = ((lt & 7) << 5) | rt;
+		r1[4] = b1[k];
+		r1[5] = b2[k];
+		r1[6] = 0;
+		r1[7] = 0;
+
+		// Format 3: full bytes
+		r3[0] = in.axes[LX][k];
+		r3[1] = in.axes[RX][k];
+		r3[2] = in.axes[LY][k];
+		r3[3] = in.axes[RY][k];
+		r3[4] = in.axes[LT][k];
+		r3[5] = in.axes[RT][k];
+		r3[6] = b1[k];
+		r3[7] = b2[k];
+
+		for(int j = 0; j < 8; j++)
+			out[j][k] = (r3[j] & f3[k]) | (r1[j] & ~f3[k]);
+	}
+}
+
+/* The firmware encoder, one input at a time as set_button_data() runs it */
+static void candidate(const Batch &in, size_t k, uint8_t *report) {
+	uint16_t m = in.buttons[k];
+	int32_t p = in.pressed[k];
+	uint8_t b[2];
+
+#define ARG(n)	(BIT(m, n) ? p : 0)
+
+	WMReport::pack(b, ARG(BDL), ARG(BDR), ARG(BDU), ARG(BDD), ARG(BA), ARG(BB),
+			ARG(BX), ARG(BY), ARG(BLT), ARG(BRT), ARG(BMINUS), ARG(BPLUS),
+			ARG(BHOME), ARG(BZL), ARG(BZR));
+
+#undef ARG
+
+	WMReport::encode(report, in.format[k], b[0], b[1], in.axes[LX][k],
+			in.axes[LY][k], in.axes[RX][k], in.axes[RY][k], in.axes[LT][k],
+			in.axes[RT][k]);
+}
+
+static std::mutex report_lock;
+static std::atomic<unsigned long> mismatches(0);
+
+static void print_mismatch(const char *stratum, const Batch &in, size_t k,
+		const uint8_t *expected, const uint8_t *got) {
+	std::lock_guard<std::mutex> lock(report_lock);
+
+	if(mismatches++ >= MAX_MISMATCHES)
+		return;
+
+	printf("MISMATCH (%s): format 0x%02X, buttons", stratum, in.format[k]);
+
+	for(int i = 0; i < BUTTONS; i++)
+		if(BIT(in.buttons[k], i))
+			printf(" %s", button_names[i]);
+
+	printf(" (pressed = %d), lx %d ly %d rx %d ry %d lt %d rt %d\n", in.pressed[k],
+			in.axes[LX][k], in.axes[LY][k], in.axes[RX][k], in.axes[RY][k],
+			in.axes[LT][k], in.axes[RT][k]);
+
+	printf("  expected");
+
+	for(int j = 0; j < 8; j++)
+		printf(" %02X", expected[j]);
+
+	printf("\n  got     ");
+
+	for(int j = 0; j < 8; j++)
+		printf(" %02X", got[j]);
+
+	putchar('\n');
+}
+
+/* Hands out batches of all strata, in order, to the workers */
+class Work {
+public:
+	Work(const std::vector<Stratum> &strata) : strata(strata), next(0) {
+		uint64_t total = 0;
+
+		for(size_t s = 0; s < strata.size(); s++) {
+			offsets.push_back(total);
+			total += (strata[s].size + BATCH - 1) / BATCH;
+		}
+
+		batches = total;
+	}
+
+	bool get(size_t *stratum, uint64_t *first, uint64_t *count) {
+		uint64_t b = next++;
+
+		if(b >= batches)
+			return false;
+
+		size_t s = strata.size() - 1;
+
+		while(offsets[s] > b)
+			s--;
+
+		*stratum = s;
+		*first = (b - offsets[s]) * BATCH;
+		*count = strata[s].size - *first < BATCH ? strata[s].size - *first : BATCH;
+		return true;
+	}
+
+private:
+	const std::vector<Stratum> &strata;
+	std::vector<uint64_t> offsets;
+	uint64_t batches;
+	std::atomic<uint64_t> next;
+};
+
+static void worker(Work *work, const std::vector<Stratum> *strata, uint64_t seed,
+		uint64_t *checked) {
+	Batch *in = new Batch;
+	uint8_t (*expected)[BATCH] = new uint8_t[8][BATCH];
+	size_t s;
+	uint64_t first, count;
+
+	while(work->get(&s, &first, &count)) {
+		in->n = count;
+		(*strata)[s].fill(*in, first, count, seed);
+
+		reference(*in, expected);
+
+		for(size_t k = 0; k < count; k++) {
+			uint8_t got[8], want[8];
+
+			candidate(*in, k, got);
+
+			for(int j = 0; j < 8; j++)
+				want[j] = expected[j][k];
+
+			if(memcmp(got, want, 8))
+				print_mismatch((*strata)[s].name, *in, k, want, got);
+		}
+
+		*checked += count;
+	}
+
+	delete[] expected;
+	delete in;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned threads = std::thread::hardware_concurrency();
+	uint64_t random = 1ULL << 26, seed = 0x5752415245504F52ULL, sticks = 64;
+
+	for(int i = 1; i < argc; i++) {
+		if(!strcmp(argv[i], "-j") && i + 1 < argc) {
+			threads = strtoul(argv[++i], NULL, 0);
+		} else if(!strcmp(argv[i], "-n") && i + 1 < argc) {
+			random = strtoull(argv[++i], NULL, 0);
+		} else if(!strcmp(argv[i], "-s") && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 0);
+		} else if(!strcmp(argv[i], "-b") && i + 1 < argc) {
+			sticks = strtoull(argv[++i], NULL, 0);
+		} else {
+			fprintf(stderr, "Usage: %s [-j threads] [-n random] [-s seed] [-b sticks]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if(!threads)
+		threads = 1;
+
+	std::vector<Stratum> strata;
+	Stratum all[] = {
+		{ "buttons", (1ULL << 16) * sticks, fill_buttons },
+		{ "rx-ry-lt", 1ULL << 25, fill_rx_ry_lt },
+		{ "lx-rx", 1ULL << 17, fill_lx_rx },
+		{ "ly-rx", 1ULL << 17, fill_ly_rx },
+		{ "lt-rt", 1ULL << 17, fill_lt_rt },
+		{ "random", random, fill_any },
+	};
+
+	uint64_t total = 0;
+
+	for(size_t s = 0; s < sizeof(all) / sizeof(all[0]); s++) {
+		if(!all[s].size)
+			continue;
+
+		strata.push_back(all[s]);
+		total += all[s].size;
+		printf("  %-9s %12llu inputs\n", all[s].name, (unsigned long long)all[s].size);
+	}
+
+	printf("Checking %llu inputs on %u threads\n", (unsigned long long)total, threads);
+
+	Work work(strata);
+	std::vector<std::thread> pool;
+	std::vector<uint64_t> checked(threads, 0);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for(unsigned t = 0; t < threads; t++)
+		pool.push_back(std::thread(worker, &work, &strata, seed, &checked[t]));
+
+	for(unsigned t = 0; t < threads; t++)
+		pool[t].join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	uint64_t done = 0;
+
+	for(unsigned t = 0; t < threads; t++)
+		done += checked[t];
+
+	printf("%llu inputs in %.2f s: %.1f M inputs/s, %.1f M inputs/s per thread\n",
+			(unsigned long long)done, seconds, done / seconds / 1e6,
+			done / seconds / 1e6 / threads);
+
+	if(mismatches) {
+		printf("%lu mismatches\n", (unsigned long)mismatches);
+		return 1;
+	}
+
+	printf("No mismatches\n");
+	return 0;
+}
@@ -0,0 +1,350 @@
+/*
+ * Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+ * Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host side summary of a sniffer capture (see Sniffer.h): how a game or
+ * emulator polls the extension.
+ *
+ * Build: g++ -O2 -o wra-sniff wra-sniff.cpp
+ *
+ * Capture (Linux, USB serial adapter on the adapter's TX / RX pins),
+ * requesting a dump every 50ms:
+ *   stty -F /dev/ttyUSB0 250000 raw
+ *   cat /dev/ttyUSB0 > sniff.bin &
+ *   while sleep 0.05; do printf d > /dev/ttyUSB0; done
+ *
+ * Usage: wra-sniff [-v] [-g ms] [sniff.bin]   (reads stdin when no file is given)
+ *   -v  also print every transaction
+ *   -g  idle time that ends a session, 1000ms by default. A session also
+ *       ends when the Wiimote writes 0xF0 (extension init) again after it
+ *       has read reports.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+// Must match Sniffer.h
+#define SNIFFER_TICK_US		32
+
+#define SNIFFER_WRITE		0x80
+#define SNIFFER_CRYPT		0x40
+#define SNIFFER_GAP			0x20
+#define SNIFFER_LENGTH		0x1F
+
+struct Transaction {
+	uint64_t time; // microseconds
+	bool write;
+	bool crypt;
+	bool gap; // Transactions were lost right before this one
+	bool saturated; // Time since the previous one is a lower bound
+	int address;
+	int length;
+};
+
+/* Power of two microsecond buckets: [0, 1), [1, 2), [2, 4), ... */
+class Histogram {
+public:
+	Histogram() : count(0), total(0), min(~0ULL), max(0) {
+		memset(buckets, 0, sizeof(buckets));
+	}
+
+	void add(uint64_t us) {
+		int b = 0;
+
+		while((1ULL << b) <= us && b < 31)
+			b++;
+
+		buckets[b]++;
+		count++;
+		total += us;
+
+		if(us < min) min = us;
+		if(us > max) max = us;
+	}
+
+	void print(const char *title) const {
+		unsigned long peak = 0;
+
+		printf("\n%s: %lu samples", title, count);
+
+		if(!count) {
+			printf("\n");
+			return;
+		}
+
+		printf(", min %llu us, avg %llu us, max %llu us\n",
+				(unsigned long long)min, (unsigned long long)(total / count),
+				(unsigned long long)max);
+
+		for(int b = 0; b < 32; b++)
+			if(buckets[b] > peak)
+				peak = buckets[b];
+
+		for(int b = 0; b < 32; b++) {
+			if(!buckets[b])
+				continue;
+
+			int width = (int)(buckets[b] * 50 / peak);
+
+			printf("  %8llu - %-8llu us %8lu |", b ? (1ULL << (b - 1)) : 0ULL,
+					(1ULL << b) - 1, buckets[b]);
+
+			for(int i = 0; i < width; i++)
+				putchar('#');
+
+			putchar('\n');
+		}
+	}
+
+private:
+	unsigned long buckets[32];
+	unsigned long count;
+	uint64_t total;
+	uint64_t min, max;
+};
+
+/* Splits the byte stream into dumps, resyncing on the 'W' 'S' header */
+static std::vector<Transaction> decode(FILE *in, unsigned long *dropped,
+		unsigned long *dumps, unsigned long *skipped) {
+	std::vector<Transaction> transactions;
+	std::vector<unsigned char> data;
+	unsigned char chunk[4096];
+	size_t n;
+	uint64_t ticks = 0;
+
+	while((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+		data.insert(data.end(), chunk, chunk + n);
+
+	for(size_t i = 0; i + 4 <= data.size();) {
+		if(data[i] != 'W' || data[i + 1] != 'S') {
+			(*skipped)++;
+			i++;
+			continue;
+		}
+
+		size_t count = data[i + 2];
+
+		// Capture stopped in the middle of a dump
+		if(i + 4 + count * 4 > data.size())
+			break;
+
+		*dropped += data[i + 3];
+		(*dumps)++;
+		i += 4;
+
+		for(size_t r = 0; r < count; r++, i += 4) {
+			unsigned int delta = data[i] | (data[i + 1] << 8);
+			int flags = data[i + 3];
+
+			ticks += delta;
+
+			Transaction t = { ticks * SNIFFER_TICK_US, (flags & SNIFFER_WRITE) != 0,
+					(flags & SNIFFER_CRYPT) != 0, (flags & SNIFFER_GAP) != 0,
+					delta == 0xFFFF, data[i + 2], flags & SNIFFER_LENGTH };
+
+			transactions.push_back(t);
+		}
+	}
+
+	return transactions;
+}
+
+/* Transactions with the same direction, start address, length and encryption */
+struct Pattern {
+	bool write;
+	int address;
+	int length;
+	bool crypt;
+
+	bool operator<(const Pattern &o) const {
+		if(write != o.write) return write < o.write;
+		if(address != o.address) return address < o.address;
+		if(length != o.length) return length < o.length;
+		return crypt < o.crypt;
+	}
+};
+
+class Session {
+public:
+	Session(int number, uint64_t start) : number(number), start(start), end(start),
+			transactions(0), gaps(0), report_reads(0), crypt_reads(0),
+			key_writes(0), rekeys(0), last_report(0), last_address(0),
+			report_pending(false), address_pending(false) { }
+
+	bool has_reports() const {
+		return report_reads > 0;
+	}
+
+	void add(const Transaction &t) {
+		Pattern p = { t.write, t.address, t.length, t.crypt };
+
+		patterns[p]++;
+		transactions++;
+		end = t.time;
+
+		// Intervals across lost transactions are unknown
+		if(t.gap) {
+			gaps++;
+			report_pending = false;
+			address_pending = false;
+		}
+
+		if(t.write) {
+			if(t.length == 0) {
+				address_pending = true;
+				last_address = t.time;
+			} else if(t.address <= 0x4F && t.address + t.length > 0x40) {
+				key_writes++;
+
+				if(report_reads)
+					rekeys++;
+			}
+
+			return;
+		}
+
+		if(address_pending)
+			address_to_read.add(t.time - last_address);
+
+		address_pending = false;
+
+		if(t.address != 0x00)
+			return;
+
+		report_reads++;
+
+		if(t.crypt)
+			crypt_reads++;
+
+		if(report_pending)
+			poll_interval.add(t.time - last_report);
+
+		report_pending = true;
+		last_report = t.time;
+	}
+
+	void print() const {
+		double seconds = (end - start) / 1e6;
+
+		printf("\nSession %d: %.3f s - %.3f s, %lu transactions, %lu after lost ones\n",
+				number, start / 1e6, end / 1e6, transactions, gaps);
+
+		printf("  Report reads (0x00): %lu, %lu encrypted", report_reads, crypt_reads);
+
+		if(seconds > 0)
+			printf(", %.1f /s", report_reads / seconds);
+
+		printf("\n  Key writes (0x40-0x4F): %lu, %lu after the first report read (re-key)\n",
+				key_writes, rekeys);
+
+		printf("\n  Access patterns:\n");
+
+		for(std::map<Pattern, unsigned long>::const_iterator it = patterns.begin();
+				it != patterns.end(); ++it) {
+			const Pattern &p = it->first;
+
+			if(p.write && !p.length)
+				printf("    set address 0x%02X     %-5s %8lu\n", p.address,
+						p.crypt ? "crypt" : "plain", it->second);
+			else
+				printf("    %-5s 0x%02X, %2d bytes %-5s %8lu\n", p.write ? "write" : "read",
+						p.address, p.length, p.crypt ? "crypt" : "plain", it->second);
+		}
+
+		poll_interval.print("  Report poll interval (read 0x00 -> read 0x00)");
+		address_to_read.print("  Address write to read");
+	}
+
+private:
+	int number;
+	uint64_t start, end;
+	unsigned long transactions, gaps;
+	unsigned long report_reads, crypt_reads;
+	unsigned long key_writes, rekeys;
+	uint64_t last_report, last_address;
+	bool report_pending, address_pending;
+	std::map<Pattern, unsigned long> patterns;
+	Histogram poll_interval, address_to_read;
+};
+
+int main(int argc, char *argv[]) {
+	FILE *in = stdin;
+	bool verbose = false;
+	uint64_t session_gap = 1000000;
+	unsigned long dropped = 0, dumps = 0, skipped = 0;
+
+	for(int i = 1; i < argc; i++) {
+		if(!strcmp(argv[i], "-v")) {
+			verbose = true;
+		} else if(!strcmp(argv[i], "-g") && i + 1 < argc) {
+			session_gap = strtoul(argv[++i], NULL, 10) * 1000ULL;
+		} else if(!(in = fopen(argv[i], "rb"))) {
+			perror(argv[i]);
+			return 1;
+		}
+	}
+
+	std::vector<Transaction> transactions = decode(in, &dropped, &dumps, &skipped);
+
+	if(transactions.empty()) {
+		fprintf(stderr, "No transactions found\n");
+		return 1;
+	}
+
+	printf("%lu transactions in %lu dumps over %.3f s, %lu dropped by the firmware",
+			(unsigned long)transactions.size(), dumps, transactions.back().time / 1e6,
+			dropped);
+
+	if(skipped)
+		printf(", %lu bytes skipped", skipped);
+
+	putchar('\n');
+
+	std::vector<Session> sessions;
+	uint64_t last = 0;
+
+	for(size_t i = 0; i < transactions.size(); i++) {
+		const Transaction &t = transactions[i];
+
+		if(verbose) {
+			printf("%12llu us  %-5s 0x%02X %2d %s%s%s\n", (unsigned long long)t.time,
+					t.write ? (t.length ? "write" : "addr") : "read", t.address, t.length,
+					t.crypt ? "crypt" : "plain", t.gap ? " (after lost)" : "",
+					t.saturated ? " (long idle)" : "");
+		}
+
+		bool idle = t.saturated || t.time - last >= session_gap;
+		bool init = t.write && t.length && t.address == 0xF0 && !sessions.empty()
+				&& sessions.back().has_reports();
+
+		if(sessions.empty() || idle || init)
+			sessions.push_back(Session(sessions.size() + 1, t.time));
+
+		sessions.back().add(t);
+		last = t.time;
+	}
+
+	for(size_t i = 0; i < sessions.size(); i++)
+		sessions[i].print();
+
+	return 0;
+}
@@ -0,0 +1,490 @@
+/*
+ * Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+ * Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host side decoder for the firmware binary trace (see Trace.h).
+ *
+ * Build: g++ -O2 -o wra-trace wra-trace.cpp
+ *
+ * Capture (Linux, USB serial adapter on the adapter's TX pin):
+ *   stty -F /dev/ttyUSB0 250000 raw
+ *   cat /dev/ttyUSB0 > capture.bin
+ *
+ * Usage: wra-trace [-v | -r] [capture.bin]   (reads stdin when no file is given)
+ *   -v  also print every event
+ *   -r  only list the reports produced by a replay (REPLAY = 2, see
+ *       Replay.h), one line per sample. Keep the output of a known good
+ *       build and diff it against new builds:
+ *         wra-trace -r new.bin | diff golden.txt -
+ *       A recording holds up to REPLAY_SIZE bytes of delta coded samples,
+ *       about 250 changes on a 328p and 100 on a 168. The sample numbers
+ *       wrap at 256.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// Must match Trace.h
+#define TRACE_TICK_US		8
+
+#define TRACE_PAD_SAMPLE	0x01
+#define TRACE_READ			0x02
+#define TRACE_READ_CRYPT	0x03
+#define TRACE_WRITE			0x04
+#define TRACE_KEY_SETUP		0x05
+#define TRACE_TIMEOUT		0x06
+#define TRACE_DRIVER		0x07
+#define TRACE_DROPPED		0x08
+#define TRACE_STACK			0x09
+#define TRACE_BOOT			0x0A
+#define TRACE_REPLAY		0x0B
+#define TRACE_REPORT		0x0C
+#define TRACE_JOYBUS		0x0D
+#define TRACE_LAST			TRACE_JOYBUS
+
+#define TRACE_BOOT_I2C		0x00
+#define TRACE_BOOT_PAD		0x01
+
+static const char *event_names[] = { "?", "pad-sample", "read", "read-crypt",
+		"write", "key-setup", "timeout", "driver", "dropped", "stack", "boot",
+		"replay", "report", "joybus" };
+
+// Must match JoybusTiming::report()
+enum { JB_CAPTURES, JB_BAD, JB_LOW1_MIN, JB_LOW1_MAX, JB_LOW0_MIN, JB_LOW0_MAX,
+	JB_HIGH_MIN, JB_PERIOD_MIN, JB_PERIOD_MAX, JB_MARGIN, JB_SAMPLE, JB_EVENTS };
+
+#define CPU_CYCLE_NS		125
+
+static const char *pad_name(int pad) {
+	switch(pad) {
+	case 0x07: return "Genesis";
+	case 0x06: return "NES";
+	case 0x05: return "SNES";
+	case 0x04: return "PS2";
+	case 0x03: return "GameCube";
+	case 0x02: return "N64";
+	case 0x01: return "NeoGeo";
+	case 0x00: return "Wii Classic";
+	case 0x0F: return "Saturn";
+	case 0x17: return "TG16";
+	case -1: return "Arcade";
+	}
+
+	return "unknown";
+}
+
+struct Event {
+	int type;
+	int arg;
+	uint64_t time; // microseconds
+};
+
+/* Power of two microsecond buckets: [0, 1), [1, 2), [2, 4), ... */
+class Histogram {
+public:
+	Histogram() : count(0), total(0), min(~0ULL), max(0) {
+		memset(buckets, 0, sizeof(buckets));
+	}
+
+	void add(uint64_t us) {
+		int b = 0;
+
+		while((1ULL << b) <= us && b < 31)
+			b++;
+
+		buckets[b]++;
+		count++;
+		total += us;
+
+		if(us < min) min = us;
+		if(us > max) max = us;
+	}
+
+	void print(const char *title) const {
+		unsigned long peak = 0;
+
+		printf("\n%s: %lu samples", title, count);
+
+		if(!count) {
+			printf("\n");
+			return;
+		}
+
+		printf(", min %llu us, avg %llu us, max %llu us\n",
+				(unsigned long long)min, (unsigned long long)(total / count),
+				(unsigned long long)max);
+
+		for(int b = 0; b < 32; b++)
+			if(buckets[b] > peak)
+				peak = buckets[b];
+
+		for(int b = 0; b < 32; b++) {
+			if(!buckets[b])
+				continue;
+
+			int width = (int)(buckets[b] * 50 / peak);
+
+			printf("  %8llu - %-8llu us %8lu |", b ? (1ULL << (b - 1)) : 0ULL,
+					(1ULL << b) - 1, buckets[b]);
+
+			for(int i = 0; i < width; i++)
+				putchar('#');
+
+			putchar('\n');
+		}
+	}
+
+private:
+	unsigned long buckets[32];
+	unsigned long count;
+	uint64_t total;
+	uint64_t min, max;
+};
+
+/* Splits the byte stream into 4 byte records, resyncing on bad types */
+static std::vector<Event> decode(FILE *in) {
+	std::vector<Event> events;
+	std::vector<unsigned char> data;
+	unsigned char chunk[4096];
+	size_t n;
+	uint64_t ticks = 0;
+	unsigned int last = 0;
+	bool first = true;
+
+	while((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+		data.insert(data.end(), chunk, chunk + n);
+
+	for(size_t i = 0; i + 4 <= data.size();) {
+		int type = data[i];
+
+		if(type < TRACE_PAD_SAMPLE || type > TRACE_LAST) {
+			i++;
+			continue;
+		}
+
+		unsigned int stamp = data[i + 2] | (data[i + 3] << 8);
+
+		// Timestamps are 16 bit, assume less than one wrap between events.
+		// The first one is kept as is, so a capture started at power up
+		// has setup() as time 0.
+		if(first)
+			ticks = stamp;
+		else
+			ticks += (stamp - last) & 0xFFFF;
+
+		first = false;
+		last = stamp;
+
+		Event e = { type, data[i + 1], ticks * TRACE_TICK_US };
+		events.push_back(e);
+
+		i += 4;
+	}
+
+	return events;
+}
+
+/*
+ * Prints the GameCube bit timing summaries (JOYBUS_TIMING = 1, see
+ * JoybusTiming.h), one line each, then the range over all of them and
+ * the sample point in the middle of it.
+ */
+static void print_joybus(const std::vector<std::vector<int> > &summaries) {
+	int low1_max = 0, low0_min = 0xFF, margin = 127, sample = 0;
+	unsigned long captures = 0, bad = 0;
+
+	printf("\nJoybus bit timing, in CPU cycles (%d ns):\n", CPU_CYCLE_NS);
+	printf("  captures  bad   '1' low   '0' low  high min   period  margin\n");
+
+	for(size_t i = 0; i < summaries.size(); i++) {
+		const std::vector<int> &s = summaries[i];
+
+		printf("  %8d %4d   %3d-%-3d   %3d-%-3d   %7d  %3d-%-3d  %6d\n", s[JB_CAPTURES],
+				s[JB_BAD], s[JB_LOW1_MIN], s[JB_LOW1_MAX], s[JB_LOW0_MIN], s[JB_LOW0_MAX],
+				s[JB_HIGH_MIN], s[JB_PERIOD_MIN], s[JB_PERIOD_MAX], (signed char)s[JB_MARGIN]);
+
+		captures += s[JB_CAPTURES];
+		bad += s[JB_BAD];
+		sample = s[JB_SAMPLE];
+
+		if(s[JB_LOW1_MAX] > low1_max) low1_max = s[JB_LOW1_MAX];
+		if(s[JB_LOW0_MIN] < low0_min) low0_min = s[JB_LOW0_MIN];
+		if((signed char)s[JB_MARGIN] < margin) margin = (signed char)s[JB_MARGIN];
+	}
+
+	printf("\n  %lu captures, %lu bad\n", captures, bad);
+	printf("  Longest '1' low %d ns, shortest '0' low %d ns\n", low1_max * CPU_CYCLE_NS,
+			low0_min * CPU_CYCLE_NS);
+	printf("  Sample point %d cycles, worst margin %d cycles (%d ns)%s\n", sample, margin,
+			margin * CPU_CYCLE_NS, margin <= 0 ? ", MISREADS" : "");
+
+	if(low0_min != 0xFF) {
+		int best = (low1_max + low0_min) / 2;
+
+		printf("  Most margin at %d cycles (%+d nops in GCPad_recv())\n", best, best - sample);
+	}
+}
+
+/*
+ * Prints "sample N: format F, report B0 .. B7" for each replayed sample.
+ * Times are left out so runs of different builds compare equal.
+ */
+static int list_reports(const std::vector<Event> &events) {
+	std::vector<int> report;
+	int sample = -1;
+	unsigned long listed = 0;
+
+	for(size_t i = 0; i < events.size(); i++) {
+		const Event &e = events[i];
+
+		switch(e.type) {
+		case TRACE_REPLAY:
+			if(sample >= 0)
+				printf("sample %3d: incomplete\n", sample);
+
+			sample = e.arg;
+			report.clear();
+			break;
+		case TRACE_DROPPED:
+			if(sample >= 0)
+				printf("sample %3d: incomplete\n", sample);
+
+			sample = -1;
+			break;
+		case TRACE_REPORT:
+			if(sample < 0)
+				break;
+
+			report.push_back(e.arg);
+
+			if(report.size() < 9)
+				break;
+
+			printf("sample %3d: format 0x%02X, report", sample, report[0]);
+
+			for(int b = 1; b < 9; b++)
+				printf(" %02X", report[b]);
+
+			putchar('\n');
+			sample = -1;
+			listed++;
+			break;
+		}
+	}
+
+	if(!listed) {
+		fprintf(stderr, "No replayed reports found\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	FILE *in = stdin;
+	bool verbose = false, reports = false;
+
+	for(int i = 1; i < argc; i++) {
+		if(!strcmp(argv[i], "-v")) {
+			verbose = true;
+		} else if(!strcmp(argv[i], "-r")) {
+			reports = true;
+		} else if(!(in = fopen(argv[i], "rb"))) {
+			perror(argv[i]);
+			return 1;
+		}
+	}
+
+	std::vector<Event> events = decode(in);
+
+	if(events.empty()) {
+		fprintf(stderr, "No events found\n");
+		return 1;
+	}
+
+	if(reports)
+		return list_reports(events);
+
+	unsigned long counts[TRACE_LAST + 1] = { 0 };
+	unsigned long dropped = 0;
+	int stack_unused = -1;
+	long long boot_i2c = -1, boot_access = -1, boot_pad = -1, boot_report = -1;
+	Histogram per_type[TRACE_LAST + 1];
+	uint64_t last_of_type[TRACE_LAST + 1];
+	bool seen_type[TRACE_LAST + 1] = { false };
+	Histogram poll_interval, fetch_to_sample, sample_to_fetch, key_setup, replay_to_fetch;
+	std::map<int, unsigned long> read_addresses;
+	std::map<uint64_t, unsigned long> timeline; // polls per second
+	std::vector<std::vector<int> > joybus;
+	std::vector<int> joybus_group;
+	bool fetch_pending = false, sample_pending = false, key_pending = false, replay_pending = false;
+	uint64_t last_fetch = 0, last_sample = 0, last_key_write = 0, last_replay = 0;
+
+	for(size_t i = 0; i < events.size(); i++) {
+		const Event &e = events[i];
+
+		if(verbose)
+			printf("%12llu us  %-10s 0x%02X\n", (unsigned long long)e.time,
+					event_names[e.type], e.arg);
+
+		counts[e.type]++;
+
+		if(seen_type[e.type])
+			per_type[e.type].add(e.time - last_of_type[e.type]);
+
+		seen_type[e.type] = true;
+		last_of_type[e.type] = e.time;
+
+		if((e.type == TRACE_READ || e.type == TRACE_READ_CRYPT || e.type == TRACE_WRITE) && boot_access < 0)
+			boot_access = e.time;
+
+		switch(e.type) {
+		case TRACE_READ:
+		case TRACE_READ_CRYPT:
+			read_addresses[e.arg]++;
+
+			if(e.arg == 0x00 && boot_pad >= 0 && boot_report < 0)
+				boot_report = e.time;
+
+			if(e.arg != 0x00)
+				break;
+
+			if(fetch_pending)
+				poll_interval.add(e.time - last_fetch);
+
+			if(sample_pending)
+				sample_to_fetch.add(e.time - last_sample);
+
+			if(replay_pending)
+				replay_to_fetch.add(e.time - last_replay);
+
+			timeline[e.time / 1000000]++;
+			fetch_pending = true;
+			sample_pending = false;
+			replay_pending = false;
+			last_fetch = e.time;
+			break;
+		case TRACE_PAD_SAMPLE:
+			if(fetch_pending)
+				fetch_to_sample.add(e.time - last_fetch);
+
+			sample_pending = true;
+			last_sample = e.time;
+			break;
+		case TRACE_WRITE:
+			if(e.arg >= 0x40 && e.arg <= 0x4F) {
+				key_pending = true;
+				last_key_write = e.time;
+			}
+			break;
+		case TRACE_KEY_SETUP:
+			if(key_pending)
+				key_setup.add(e.time - last_key_write);
+
+			key_pending = false;
+			break;
+		case TRACE_DRIVER:
+			printf("%llu us: pad loop %s (0x%02X)\n", (unsigned long long)e.time,
+					pad_name((signed char)e.arg), e.arg);
+			break;
+		case TRACE_DROPPED:
+			dropped += e.arg;
+			joybus_group.clear();
+			break;
+		case TRACE_JOYBUS:
+			joybus_group.push_back(e.arg);
+
+			if(joybus_group.size() == JB_EVENTS) {
+				joybus.push_back(joybus_group);
+				joybus_group.clear();
+			}
+			break;
+		case TRACE_STACK:
+			stack_unused = e.arg * 8;
+			break;
+		case TRACE_REPLAY:
+			replay_pending = true;
+			last_replay = e.time;
+			break;
+		case TRACE_BOOT:
+			if(e.arg == TRACE_BOOT_I2C && boot_i2c < 0)
+				boot_i2c = e.time;
+			else if(e.arg == TRACE_BOOT_PAD && boot_pad < 0)
+				boot_pad = e.time;
+			break;
+		}
+	}
+
+	printf("\n%lu events over %.3f s, %lu dropped by the firmware\n",
+			(unsigned long)events.size(), events.back().time / 1e6, dropped);
+
+	for(int t = TRACE_PAD_SAMPLE; t <= TRACE_LAST; t++)
+		printf("  %-10s %8lu\n", event_names[t], counts[t]);
+
+	if(boot_i2c >= 0) {
+		printf("\nBoot (from setup(), capture must start at power up):\n");
+		printf("  I2C slave up            %8lld us\n", boot_i2c);
+
+		if(boot_access >= 0)
+			printf("  First Wiimote access    %8lld us\n", boot_access);
+
+		if(boot_pad >= 0)
+			printf("  First pad driver report %8lld us\n", boot_pad);
+
+		if(boot_report >= 0)
+			printf("  First valid report read %8lld us\n", boot_report);
+	}
+
+	if(stack_unused >= 0)
+		printf("\nStack never used (high-water mark headroom): %d%s bytes\n",
+				stack_unused, stack_unused >= 0xFF * 8 ? "+" : "");
+
+	printf("\nReads per start address:\n");
+
+	for(std::map<int, unsigned long>::const_iterator it = read_addresses.begin();
+			it != read_addresses.end(); ++it)
+		printf("  0x%02X %8lu\n", it->first, it->second);
+
+	poll_interval.print("Report poll interval (read 0x00 -> read 0x00)");
+	fetch_to_sample.print("Fetch to next pad sample");
+	sample_to_fetch.print("Pad sample to next fetch");
+	key_setup.print("Key write to key setup done");
+
+	if(counts[TRACE_REPLAY])
+		replay_to_fetch.print("Replayed sample to next fetch (input to report latency)");
+
+	if(!joybus.empty())
+		print_joybus(joybus);
+
+	for(int t = TRACE_PAD_SAMPLE; t <= TRACE_LAST; t++) {
+		std::string title = std::string("Interval between '") + event_names[t] + "' events";
+		per_type[t].print(title.c_str());
+	}
+
+	printf("\nPoll rate timeline (reports/s):\n");
+
+	for(std::map<uint64_t, unsigned long>::const_iterator it = timeline.begin();
+			it != timeline.end(); ++it)
+		printf("  %6llu s %6lu\n", (unsigned long long)it->first, it->second);
+
+	return 0;
+}
@@ -0,0 +1,222 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "Arcade.h"
+#include "Timebase.h"
+#include "Delay.h"
+
+#if ARCADE
+
+// Switch pins on each port
+#define ARCADE_PORTB	0x3F // PB0-PB5, PCINT0-5
+#define ARCADE_PORTC	0x07 // PC0-PC2, PCINT8-10
+#define ARCADE_PORTD	0xFC // PD2-PD7, PCINT18-23
+
+#define ARCADE_SOCD_UD	(ARCADE_UP | ARCADE_DOWN)
+#define ARCADE_SOCD_LR	(ARCADE_LEFT | ARCADE_RIGHT)
+
+/* Snapshots from the pin change ISRs, ring[tail] is the oldest */
+Arcade::Snapshot Arcade::ring[ARCADE_RING_SIZE];
+volatile byte Arcade::head = 0;
+volatile byte Arcade::tail = 0;
+volatile byte Arcade::edges = 0;
+
+/* Last snapshot processed, and the debounced state */
+word Arcade::raw = 0;
+word Arcade::stable = 0;
+
+/* Switches in their debounce lockout, and when it started */
+word Arcade::locked = 0;
+unsigned int Arcade::locked_at[ARCADE_SWITCHES];
+
+/* The last pressed of Up / Down and of Left / Right */
+word Arcade::last_pressed = 0;
+
+/* Pull-ups on, pin change interrupts on, first snapshot */
+void Arcade::init() {
+	uint8_t oldSREG;
+
+	DDRB &= ~ARCADE_PORTB;
+	DDRC &= ~ARCADE_PORTC;
+	DDRD &= ~ARCADE_PORTD;
+
+	PORTB |= ARCADE_PORTB;
+	PORTC |= ARCADE_PORTC;
+	PORTD |= ARCADE_PORTD;
+
+	// Let the pull-ups charge the wiring
+	DELAY_US(10);
+
+	oldSREG = SREG;
+	cli();
+
+	PCMSK0 = ARCADE_PORTB;
+	PCMSK1 = ARCADE_PORTC;
+	PCMSK2 = ARCADE_PORTD;
+	PCIFR = _BV(PCIF0) | _BV(PCIF1) | _BV(PCIF2);
+	PCICR |= _BV(PCIE0) | _BV(PCIE1) | _BV(PCIE2);
+
+	Arcade::capture();
+
+	SREG = oldSREG;
+}
+
+/* Queues a snapshot of all switches. Interrupts must be disabled */
+void Arcade::capture() {
+	// Back to back, so an edge shows on all ports or none
+	byte d = PIND;
+	byte b = PINB;
+	byte c = PINC;
+	byte h = Arcade::head;
+	byte next = (h + 1) & (ARCADE_RING_SIZE - 1);
+
+	// Ring full, replace the newest one so the latest state still gets in
+	if(next == Arcade::tail) {
+		next = h;
+		h = (h - 1) & (ARCADE_RING_SIZE - 1);
+	}
+
+	Arcade::ring[h].state = ~(((d & ARCADE_PORTD) >> 2) | ((word)(b & ARCADE_PORTB) << 6)
+			| ((word)(c & ARCADE_PORTC) << 12)) & ((1 << ARCADE_SWITCHES) - 1);
+	Arcade::ring[h].time = Timebase::now();
+
+	Arcade::head = next;
+	Arcade::edges++;
+}
+
+/* Takes the changes of state that are not in a debounce lockout */
+void Arcade::apply(word state, unsigned int time) {
+	word changed = state ^ Arcade::stable;
+	word bit = 1;
+
+	Arcade::raw = state;
+
+	for(byte i = 0; changed; i++, bit <<= 1) {
+		if(!(changed & bit))
+			continue;
+
+		changed &= ~bit;
+
+		if((Arcade::locked & bit) && (unsigned int)(time - Arcade::locked_at[i]) < ARCADE_DEBOUNCE_US)
+			continue;
+
+		Arcade::stable ^= bit;
+		Arcade::locked |= bit;
+		Arcade::locked_at[i] = time;
+
+		if(!(state & bit))
+			continue;
+
+		if(bit & ARCADE_SOCD_UD)
+			Arcade::last_pressed = (Arcade::last_pressed & ~ARCADE_SOCD_UD) | bit;
+		else if(bit & ARCADE_SOCD_LR)
+			Arcade::last_pressed = (Arcade::last_pressed & ~ARCADE_SOCD_LR) | bit;
+	}
+}
+
+/* Resolves opposite directions held together, see Arcade.h */
+word Arcade::socd(word state) {
+	if((state & ARCADE_SOCD_UD) == ARCADE_SOCD_UD) {
+#if ARCADE_SOCD == ARCADE_SOCD_NEUTRAL
+		state &= ~ARCADE_SOCD_UD;
+#elif ARCADE_SOCD == ARCADE_SOCD_LAST
+		state &= ~ARCADE_SOCD_UD | Arcade::last_pressed;
+#elif ARCADE_SOCD == ARCADE_SOCD_UP
+		state &= ~ARCADE_DOWN;
+#endif
+	}
+
+	if((state & ARCADE_SOCD_LR) == ARCADE_SOCD_LR) {
+#if ARCADE_SOCD == ARCADE_SOCD_NEUTRAL || ARCADE_SOCD == ARCADE_SOCD_UP
+		state &= ~ARCADE_SOCD_LR;
+#elif ARCADE_SOCD == ARCADE_SOCD_LAST
+		state &= ~ARCADE_SOCD_LR | Arcade::last_pressed;
+#endif
+	}
+
+	return state;
+}
+
+/* Processes the snapshots taken so far, returns the switches to report */
+word Arcade::read() {
+	unsigned int now;
+	word bit = 1;
+	byte t;
+
+	while((t = Arcade::tail) != Arcade::head) {
+		Arcade::apply(Arcade::ring[t].state, Arcade::ring[t].time);
+		Arcade::tail = (t + 1) & (ARCADE_RING_SIZE - 1);
+	}
+
+	// A switch may have settled in the other state during its lockout
+	now = Timebase::now();
+	Arcade::apply(Arcade::raw, now);
+
+	// Ended lockouts are cleared before their 16 bit time wraps around
+	for(byte i = 0; i < ARCADE_SWITCHES; i++, bit <<= 1)
+		if((Arcade::locked & bit) && (unsigned int)(now - Arcade::locked_at[i]) >= ARCADE_DEBOUNCE_US)
+			Arcade::locked &= ~bit;
+
+	return Arcade::socd(Arcade::stable);
+}
+
+/* Snapshots taken so far (wraps around) */
+byte Arcade::edge_count() {
+	return Arcade::edges;
+}
+
+/* Microseconds until a pending change can be taken, for Power::wait_change() */
+unsigned long Arcade::settle_time() {
+	word pending = Arcade::raw ^ Arcade::stable;
+	unsigned int now = Timebase::now();
+	unsigned int elapsed, left = 0xFFFF;
+	word bit = 1;
+
+	if(!pending)
+		return 0xFFFFFFFFUL;
+
+	for(byte i = 0; i < ARCADE_SWITCHES; i++, bit <<= 1) {
+		if(!(pending & bit))
+			continue;
+
+		elapsed = now - Arcade::locked_at[i];
+
+		if(elapsed >= ARCADE_DEBOUNCE_US)
+			return 0;
+
+		if(ARCADE_DEBOUNCE_US - elapsed < left)
+			left = ARCADE_DEBOUNCE_US - elapsed;
+	}
+
+	return left;
+}
+
+ISR(PCINT0_vect) {
+	Arcade::capture();
+}
+
+ISR(PCINT1_vect) {
+	Arcade::capture();
+}
+
+ISR(PCINT2_vect) {
+	Arcade::capture();
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Direct wired arcade controls (enabled with ARCADE = 1 in the Makefile)
+-----------------------------------------------------------------------
+
+For cabinets / sticks whose switches are wired straight to the adapter,
+each one between the pin and GND (internal pull-ups). An ARCADE build
+always runs the arcade loop, switches can't be told from a pad by
+detectPad().
+
+      pin         DB9 / board    switch       pin         board    switch
+      PD2         DB9 pin 1      Up           PB2         D10      L
+      PD3         DB9 pin 2      Down         PB3         D11      R
+      PD4         DB9 pin 3      Left         PB4         D12      ZL
+      PD5         DB9 pin 4      Right        PB5         D13      ZR
+      PD6         DB9 pin 6      B            PC0         A0       +
+      PD7         DB9 pin 7      A            PC1         A1       -
+      PB0         DB9 pin 9      Y            PC2         A2       Home
+      PB1         D9             X
+
+There is no polling: every edge fires a pin change interrupt, which takes
+a snapshot of all three ports at once, with a Timebase timestamp, into a
+small ring. The loop turns the snapshots into reports right away and only
+sends a new report when the state changes.
+
+Debounce (ARCADE_DEBOUNCE_US, 0 = off) is eager: an edge is taken at once,
+then the switch is ignored for ARCADE_DEBOUNCE_US. If it settled in the
+other state meanwhile, that state is taken when the lockout ends. No
+latency is added, a switch can change at most once per lockout.
+
+SOCD (Up + Down, Left + Right both held), ARCADE_SOCD:
+  ARCADE_SOCD_NONE      both are reported
+  ARCADE_SOCD_NEUTRAL   neither is reported
+  ARCADE_SOCD_LAST      the last one pressed wins
+  ARCADE_SOCD_UP        Up wins over Down, Left + Right is neutral
+
+A0-A2 are the PROFILER = 2 probe pins, the two can't be used together.
+*/
+
+#ifndef ARCADE_H_
+#define ARCADE_H_
+
+#include <WProgram.h>
+#include "Profiler.h"
+
+#ifndef ARCADE
+#define ARCADE 0
+#endif
+
+#if ARCADE && PROFILER >= 2
+#error "ARCADE uses A0-A2, the PROFILER = 2 probe pins"
+#endif
+
+#define ARCADE_RING_SIZE	8 // Power of two, snapshots not processed yet
+#ifndef ARCADE_DEBOUNCE_US
+#define ARCADE_DEBOUNCE_US	5000 // Up to 65535
+#endif
+
+#define ARCADE_SOCD_NONE	0
+#define ARCADE_SOCD_NEUTRAL	1
+#define ARCADE_SOCD_LAST	2
+#define ARCADE_SOCD_UP		3
+
+#ifndef ARCADE_SOCD
+#define ARCADE_SOCD			ARCADE_SOCD_NEUTRAL
+#endif
+
+// Switch bits, PD2-PD7, PB0-PB5 and PC0-PC2 in that order
+#define ARCADE_UP			0x0001
+#define ARCADE_DOWN			0x0002
+#define ARCADE_LEFT			0x0004
+#define ARCADE_RIGHT		0x0008
+#define ARCADE_B			0x0010
+#define ARCADE_A			0x0020
+#define ARCADE_Y			0x0040
+#define ARCADE_X			0x0080
+#define ARCADE_L			0x0100
+#define ARCADE_R			0x0200
+#define ARCADE_ZL			0x0400
+#define ARCADE_ZR			0x0800
+#define ARCADE_PLUS			0x1000
+#define ARCADE_MINUS		0x2000
+#define ARCADE_HOME			0x4000
+#define ARCADE_SWITCHES		15
+
+class Arcade {
+
+#if ARCADE
+private:
+	struct Snapshot {
+		word state; // Pressed switches
+		unsigned int time; // Timebase::now(), low 16 bits
+	};
+
+	static Snapshot ring[ARCADE_RING_SIZE];
+	static volatile byte head;
+	static volatile byte tail;
+	static volatile byte edges;
+
+	static word raw;
+	static word stable;
+	static word locked;
+	static unsigned int locked_at[ARCADE_SWITCHES];
+	static word last_pressed;
+
+	static void apply(word state, unsigned int time);
+	static word socd(word state);
+
+public:
+	static void init();
+	static void capture();
+	static word read();
+	static byte edge_count();
+	static unsigned long settle_time();
+#endif
+};
+
+#endif /* ARCADE_H_ */
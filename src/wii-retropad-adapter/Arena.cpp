@@ -0,0 +1,51 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "Arena.h"
+#include "Trace.h"
+
+DriverArena Arena::data;
+
+/* DriverArena member in use (ARENA_xxx), ARENA_NONE until a pad loop claims it */
+byte Arena::owner = ARENA_NONE;
+
+/*
+ * Hands the arena, zeroed, over to the driver about to start. Also puts the
+ * size of each member in the ELF as absolute symbols for "make sramreport",
+ * no code or RAM.
+ */
+void Arena::claim(byte owner) {
+	asm volatile(
+		".global arena_size_joybus\n\t.set arena_size_joybus, %c0\n\t"
+		".global arena_size_ps2\n\t.set arena_size_ps2, %c1\n\t"
+		".global arena_size_wiicc\n\t.set arena_size_wiicc, %c2"
+		:: "n" (sizeof(Arena::data.joybus)), "n" (sizeof(Arena::data.ps2)),
+		"n" (sizeof(Arena::data.wiicc)));
+
+	memset(&Arena::data, 0x00, sizeof(Arena::data));
+	Arena::owner = owner;
+}
+
+#if ARENA_CHECK
+/* Called by the drivers before using their member */
+void Arena::check(byte member) {
+	if(Arena::owner != member)
+		Trace::event(TRACE_ARENA, (Arena::owner << 4) | member);
+}
+#endif
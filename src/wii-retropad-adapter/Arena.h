@@ -0,0 +1,86 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Driver scratch arena
+--------------------
+
+loop() only ever runs one pad driver, so the drivers' work buffers share the
+same SRAM. Each driver gets a member of DriverArena, the arena is as big as
+the largest one. Each pad loop claims it (zeroed) for its member before
+reading the pad, Arena::owner tells which member is live. With
+ARENA_CHECK = 1 the drivers check the owner on every read and send a
+TRACE_ARENA event (owner << 4 | member) when they use the wrong member,
+which would overwrite another driver's state.
+
+Buffers used by the Wiimote side (WMExtension, Wire, Trace) are live with
+every driver and must NOT go here.
+
+"make sramreport" prints the static RAM of every module and the size of each
+arena member (arena_size_xxx, from Arena::claim()).
+*/
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <WProgram.h>
+
+#ifndef ARENA_CHECK
+#define ARENA_CHECK 0
+#endif
+
+// Arena owners, the DriverArena member in use
+#define ARENA_NONE		0
+#define ARENA_JOYBUS	1
+#define ARENA_PS2		2
+#define ARENA_WIICC		3
+
+union DriverArena {
+	// GameCube and N64 (GCPad.cpp)
+	struct {
+		byte raw[64]; // One byte per received bit
+		byte gc[8];
+		byte n64[4];
+	} joybus;
+
+	// PS2 (PS2Pad.cpp)
+	struct {
+		byte pad_data[21];
+	} ps2;
+
+	// Wii Classic Controller (WiiCCPad.cpp)
+	struct {
+		byte report[8];
+	} wiicc;
+};
+
+class Arena {
+
+public:
+	static DriverArena data;
+	static byte owner;
+
+	static void claim(byte owner);
+#if ARENA_CHECK
+	static void check(byte member);
+#else
+	static inline void check(byte member) { }
+#endif
+};
+
+#endif /* ARENA_H_ */
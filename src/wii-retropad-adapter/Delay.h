@@ -0,0 +1,122 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Compile time delays for the bit-banged drivers
+----------------------------------------------
+
+DELAY_US(us) and DELAY_NS(ns) burn t * F_CPU cycles, rounded to the
+nearest, inline, with no call overhead and no runtime math. The argument
+must be an integer constant expression. The build fails if it rounds to
+less than DELAY_MIN_CYCLES (a delay shorter than half a cycle) or more
+than DELAY_MAX_CYCLES (~32ms at 8MHz).
+
+DELAY_US_MIN(us, min_ns) and DELAY_NS_MIN(ns, min_ns) also fail the build
+if the rounded delay is shorter than min_ns, the least the protocol takes.
+The drivers keep their minimums next to their delays (NESPad.h, genesis.h,
+saturn.h, tg16.h, PS2Pad.h), so a changed delay or F_CPU can't cut a pulse
+below it unnoticed.
+
+gcc >= 4.5 uses __builtin_avr_delay_cycles (cycle exact). Older compilers
+(WinAVR 20100110 / gcc 4.3, as shipped with Arduino 0022) get a 3 cycle
+dec/brne or 4 cycle sbiw/brne loop plus 0 - 3 cycles of padding, exact to
+a cycle or two depending on how the loop counter gets loaded.
+
+delayMicroseconds() at 8MHz, for comparison: 1 and 2 take ~14 and ~17
+cycles (call overhead only), n >= 3 takes about 8n - 1 cycles.
+*/
+
+#ifndef DELAY_H_
+#define DELAY_H_
+
+#include <inttypes.h>
+
+#define DELAY_MIN_CYCLES	1UL
+#define DELAY_MAX_CYCLES	262143UL
+
+// Cycles for a delay, rounded to the nearest
+#define DELAY_NS_TO_CYCLES(ns)	((unsigned long)(((unsigned long long)(ns) * F_CPU + 500000000ULL) / 1000000000ULL))
+#define DELAY_US_TO_CYCLES(us)	DELAY_NS_TO_CYCLES((unsigned long long)(us) * 1000ULL)
+
+// Length of a cycle count, rounded down
+#define DELAY_CYCLES_TO_NS(c)	((unsigned long)((unsigned long long)(c) * 1000000000ULL / F_CPU))
+
+// Compile time check, gnu++98 has no static_assert
+#define DELAY_ASSERT(cond, name) typedef char name[(cond) ? 1 : -1] __attribute__((unused))
+
+#define DELAY_CYCLES(c) do { \
+	DELAY_ASSERT((c) >= DELAY_MIN_CYCLES, delay_shorter_than_one_cycle); \
+	DELAY_ASSERT((c) <= DELAY_MAX_CYCLES, delay_too_long); \
+	delay_cycles(c); \
+} while(0)
+
+#define DELAY_US(us)	DELAY_CYCLES(DELAY_US_TO_CYCLES(us))
+#define DELAY_NS(ns)	DELAY_CYCLES(DELAY_NS_TO_CYCLES(ns))
+
+#define DELAY_CYCLES_MIN(c, min_ns) do { \
+	DELAY_ASSERT(DELAY_CYCLES_TO_NS(c) >= (min_ns), delay_below_protocol_minimum); \
+	DELAY_CYCLES(c); \
+} while(0)
+
+#define DELAY_US_MIN(us, min_ns)	DELAY_CYCLES_MIN(DELAY_US_TO_CYCLES(us), min_ns)
+#define DELAY_NS_MIN(ns, min_ns)	DELAY_CYCLES_MIN(DELAY_NS_TO_CYCLES(ns), min_ns)
+
+static inline void delay_cycles(const unsigned long cycles) __attribute__((always_inline));
+
+/* Use through DELAY_CYCLES(), it must be inlined with a constant argument */
+static inline void delay_cycles(const unsigned long cycles) {
+#if (__GNUC__ * 100 + __GNUC_MINOR__) >= 405
+	__builtin_avr_delay_cycles(cycles);
+#else
+	unsigned long pad;
+
+	if(cycles >= 3 * 256) {
+		// 2 (ldi) + 4n - 1
+		uint16_t n = (cycles - 1) / 4;
+
+		pad = (cycles - 1) % 4;
+
+		__asm__ __volatile__ (
+			"1: sbiw %0, 1\n\t"
+			"brne 1b"
+			: "=w" (n)
+			: "0" (n));
+	} else if(cycles >= 3) {
+		// 1 (ldi) + 3n - 1
+		uint8_t n = cycles / 3;
+
+		pad = cycles % 3;
+
+		__asm__ __volatile__ (
+			"1: dec %0\n\t"
+			"brne 1b"
+			: "=r" (n)
+			: "0" (n));
+	} else {
+		pad = cycles;
+	}
+
+	if(pad & 2)
+		__asm__ __volatile__ ("rjmp .+0");
+
+	if(pad & 1)
+		__asm__ __volatile__ ("nop");
+#endif
+}
+
+#endif /* DELAY_H_ */
@@ -19,16 +19,16 @@
 #include <WProgram.h>
 #include "digitalWriteFast.h"
 #include "GCPad.h"
+#include "Trace.h"
+#include "Arena.h"
+#include "Profiler.h"
+#include "JoybusTiming.h"
 
 // DO NOT CHANGE PIN DEFINITION BELOW!!!
 // GCPad_recv doesn't use digitalReadFast(), it's hardcoded there!
 // To be fixed someday...
 #define JOY_DATA_PIN 2
 
-byte raw_joy_data[64];
-byte gc_joy_data[8];
-byte n64_joy_data[4];
-
 byte timeouted;
 
 /* DO NOT CHANGE ANYTHING IN THE FUNCTION BELOW!!!
@@ -142,26 +142,30 @@ bool GCPad_init(bool disable_ints, bool clear_regs) {
 
 	byte init = 0x00;
 
+	Arena::check(ARENA_JOYBUS);
+
 	if(disable_ints)
 		noInterrupts();
 
+	PROFILER_ENTER(PROF_JOYBUS);
 	GCPad_send(&init, 1);
-	GCPad_recv(raw_joy_data, 24);
+	GCPad_recv(Arena::data.joybus.raw, 24);
+	PROFILER_EXIT(PROF_JOYBUS);
 
 	if(disable_ints)
 		interrupts();
 
 	if(clear_regs) {
 		for(int x = 0; x < 64; x++) {
-			raw_joy_data[x] = 0x00;
+			Arena::data.joybus.raw[x] = 0x00;
 		}
 
 		for(int x = 0; x < 8; x++) {
-			gc_joy_data[x] = 0x00;
+			Arena::data.joybus.gc[x] = 0x00;
 		}
 
 		for(int x = 0; x < 4; x++) {
-			n64_joy_data[x] = 0x00;
+			Arena::data.joybus.n64[x] = 0x00;
 		}
 	}
 
@@ -172,17 +176,19 @@ byte *GCPad_data() {
 	int bit;
 
 	if(timeouted)
-		return gc_joy_data;
+		return Arena::data.joybus.gc;
+
+	PROFILER_ENTER(PROF_DECODE);
 
 	bit = 7;
 
 	for(int i = 0; i < 8; i++) {
 		for(int j = 0; j < 8; j++) {
 
-			if(raw_joy_data[8 * i + j] != 0 ) {
-				gc_joy_data[i] |= (1 << bit);
+			if(Arena::data.joybus.raw[8 * i + j] != 0 ) {
+				Arena::data.joybus.gc[i] |= (1 << bit);
 			} else {
-				gc_joy_data[i] &= ~(1 << bit);
+				Arena::data.joybus.gc[i] &= ~(1 << bit);
 			}
 
 			bit--;
@@ -192,21 +198,39 @@ byte *GCPad_data() {
 		}
 	}
 
-	return gc_joy_data;
+	PROFILER_EXIT(PROF_DECODE);
+
+	return Arena::data.joybus.gc;
 }
 
 bool GCPad_read(bool disable_ints) {
 	byte cmd[3] = {0x40, 0x03, 0x00};
+	bool timing = JoybusTiming::due();
+
+	Arena::check(ARENA_JOYBUS);
 
 	if(disable_ints)
 		noInterrupts();
 
-	GCPad_send(cmd, 3);
-	GCPad_recv(raw_joy_data, 64);
+	PROFILER_ENTER(PROF_JOYBUS);
+
+	if(timing) {
+		JoybusTiming::start();
+		GCPad_send(cmd, 3);
+		timeouted = !JoybusTiming::capture(Arena::data.joybus.raw, 64);
+	} else {
+		GCPad_send(cmd, 3);
+		GCPad_recv(Arena::data.joybus.raw, 64);
+	}
+
+	PROFILER_EXIT(PROF_JOYBUS);
 
 	if(disable_ints)
 		interrupts();
 
+	if(timeouted)
+		Trace::event(TRACE_TIMEOUT, cmd[0]);
+
 	return (!timeouted);
 }
 
@@ -214,17 +238,19 @@ byte *N64Pad_data() {
 	int bit;
 
 	if(timeouted)
-		return n64_joy_data;
+		return Arena::data.joybus.n64;
+
+	PROFILER_ENTER(PROF_DECODE);
 
 	bit = 7;
 
 	for(int i = 0; i < 4; i++) {
 		for(int j = 0; j < 8; j++) {
 
-			if(raw_joy_data[8 * i + j] != 0 ) {
-				n64_joy_data[i] |= (1 << bit);
+			if(Arena::data.joybus.raw[8 * i + j] != 0 ) {
+				Arena::data.joybus.n64[i] |= (1 << bit);
 			} else {
-				n64_joy_data[i] &= ~(1 << bit);
+				Arena::data.joybus.n64[i] &= ~(1 << bit);
 			}
 
 			bit--;
@@ -234,21 +260,31 @@ byte *N64Pad_data() {
 		}
 	}
 
-	return n64_joy_data;
+	PROFILER_EXIT(PROF_DECODE);
+
+	return Arena::data.joybus.n64;
 }
 
 bool N64Pad_read(bool disable_ints) {
 	byte cmd[1] = {0x01};
 
+	Arena::check(ARENA_JOYBUS);
+
 	if(disable_ints)
 		noInterrupts();
 
+	// No JoybusTiming capture: the N64 cable grounds D8 (see JoybusTiming.h)
+	PROFILER_ENTER(PROF_JOYBUS);
 	GCPad_send(cmd, 1);
-	GCPad_recv(raw_joy_data, 32);
+	GCPad_recv(Arena::data.joybus.raw, 32);
+	PROFILER_EXIT(PROF_JOYBUS);
 
 	if(disable_ints)
 		interrupts();
 
+	if(timeouted)
+		Trace::event(TRACE_TIMEOUT, cmd[0]);
+
 	return (!timeouted);
 }
 
@@ -19,8 +19,6 @@
 #ifndef GCPAD_H_
 #define GCPAD_H_
 
-static inline void GCPad_send(byte *cmd, byte length);
-static inline void GCPad_recv(byte *buffer, byte bits);
 bool GCPad_init(bool disable_ints, bool clear_regs);
 bool GCPad_read(bool disable_ints);
 bool GCPad_timeouted();
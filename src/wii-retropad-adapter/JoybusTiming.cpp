@@ -0,0 +1,241 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "JoybusTiming.h"
+#include "Timebase.h"
+#include "Trace.h"
+
+#if JOYBUS_TIMING
+
+/* Low bytes of ICR1 (falling edge) and TCNT1 (rising edge) for each bit */
+byte JoybusTiming::edges[2 * (JOYBUS_MAX_BITS + 1)];
+
+/* Data bits in edges[], the stop bit follows */
+byte JoybusTiming::bits;
+
+/* Reads since the last capture */
+byte JoybusTiming::reads = 0;
+
+/* edges[] holds a good capture service() hasn't looked at yet */
+bool JoybusTiming::pending = false;
+
+/* DDRB / PORTB before start(), PB0 is put back after the capture */
+byte JoybusTiming::ddrb;
+byte JoybusTiming::portb;
+
+/* Stats since the last report / since boot, min fields start high */
+JoybusStats JoybusTiming::window = { 0, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0xFF, 0, 127 };
+JoybusStats JoybusTiming::total = { 0, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0xFF, 0, 127 };
+unsigned int JoybusTiming::histogram[JOYBUS_HISTOGRAM];
+
+/* True if this read should be captured. Then start() before sending */
+bool JoybusTiming::due() {
+	if(JoybusTiming::pending || ++JoybusTiming::reads < JOYBUS_TIMING_EVERY)
+		return false;
+
+	JoybusTiming::reads = 0;
+
+	return true;
+}
+
+/* Timer1 to clk/1, ICP1 (PB0) as a plain input. Interrupts must be disabled */
+void JoybusTiming::start() {
+	JoybusTiming::ddrb = DDRB;
+	JoybusTiming::portb = PORTB;
+
+	DDRB &= ~_BV(PB0);
+	PORTB &= ~_BV(PB0);
+
+	Timebase::fast();
+
+	// Falling edges, no noise canceler (it would add 4 cycles)
+	TCCR1B &= ~(_BV(ICES1) | _BV(ICNC1));
+}
+
+/*
+ * Receives bits (plus the stop bit) like GCPad_recv(), timing each one.
+ * Returns false if the pad didn't answer or an edge was missed.
+ */
+bool JoybusTiming::capture(byte *buffer, byte bits) {
+	byte *p = JoybusTiming::edges;
+	byte n = bits + 1;
+	byte t, r, d;
+
+	// JOY_DATA_PIN (PD2) input with pull-up, as in GCPad_recv()
+	DDRD &= ~_BV(PD2);
+	PORTD |= _BV(PD2);
+
+	// Each bit: wait for the line to go low (ICP1 takes the time), then
+	// high. ICR1L must be read before the next falling edge, 8 cycles
+	// after the rising edge for a '0' bit. TCNT1L is read
+	// JOYBUS_RISE_CYCLES after the rising edge. The rise is polled by
+	// JOYBUS_MAX_LOW / 2 sbic in a row, so the count (3 cycles) only comes
+	// in after any good low time, and the wait ends after JOYBUS_TIMEOUT
+	asm volatile (
+		"1:\n"
+		"	ldi %[t], %[timeout]\n"
+		"	ldi %[r], %[timeout]\n"
+		"2:\n"
+		"	sbis %[pin], 2\n"
+		"	rjmp 3f\n"
+		"	dec %[t]\n"
+		"	brne 2b\n"
+		"	rjmp 4f\n"
+		"3:\n"
+		"	.rept %[polls]\n"
+		"	sbic %[pin], 2\n"
+		"	rjmp 5f\n"
+		"	.endr\n"
+		"	dec %[r]\n"
+		"	brne 3b\n"
+		"	rjmp 4f\n"
+		"5:\n"
+		"	lds __tmp_reg__, %[icr]\n"
+		"	st %a[p]+, __tmp_reg__\n"
+		"	lds __tmp_reg__, %[tcnt]\n"
+		"	st %a[p]+, __tmp_reg__\n"
+		"	dec %[n]\n"
+		"	brne 1b\n"
+		"4:\n"
+		: [p] "+e" (p), [n] "+r" (n), [t] "=&d" (t), [r] "=&d" (r)
+		: [pin] "I" (_SFR_IO_ADDR(PIND)), [timeout] "M" (JOYBUS_TIMEOUT),
+		  [polls] "M" (JOYBUS_MAX_LOW / 2),
+		  [icr] "i" (_SFR_MEM_ADDR(ICR1L)), [tcnt] "i" (_SFR_MEM_ADDR(TCNT1L))
+	);
+
+	Timebase::slow();
+
+	// Back to what detectPad() / the pad loop set up on D8
+	DDRB = (DDRB & ~_BV(PB0)) | (JoybusTiming::ddrb & _BV(PB0));
+	PORTB = (PORTB & ~_BV(PB0)) | (JoybusTiming::portb & _BV(PB0));
+
+	if(n)
+		goto bad;
+
+	for(byte i = 0; i < bits; i++) {
+		d = JoybusTiming::edges[2 * i + 1] - JoybusTiming::edges[2 * i];
+
+		// Below JOYBUS_RISE_CYCLES ICR1 already held the next falling edge
+		if(d < JOYBUS_RISE_CYCLES || d >= JOYBUS_MAX_LOW + JOYBUS_RISE_CYCLES)
+			goto bad;
+
+		buffer[i] = (d < JOYBUS_THRESHOLD + JOYBUS_RISE_CYCLES) ? 0x04 : 0x00;
+	}
+
+	JoybusTiming::bits = bits;
+	JoybusTiming::pending = true;
+
+	return true;
+
+	bad:
+
+	JoybusTiming::window.bad++;
+	JoybusTiming::total.bad++;
+
+	return false;
+}
+
+void JoybusTiming::reset(JoybusStats *stats) {
+	memset(stats, 0, sizeof(JoybusStats));
+
+	stats->low1_min = 0xFF;
+	stats->low0_min = 0xFF;
+	stats->high_min = 0xFF;
+	stats->period_min = 0xFF;
+	stats->margin = 127;
+}
+
+/* Folds the pending capture into stats */
+void JoybusTiming::add(JoybusStats *stats) {
+	const byte *e = JoybusTiming::edges;
+	int early, late;
+
+	for(byte i = 0; i < JoybusTiming::bits; i++, e += 2) {
+		byte low = e[1] - e[0] - JOYBUS_RISE_CYCLES;
+		byte high = e[2] - e[1] + JOYBUS_RISE_CYCLES;
+		byte period = e[2] - e[0];
+
+		if(low < JOYBUS_THRESHOLD) {
+			if(low < stats->low1_min) stats->low1_min = low;
+			if(low > stats->low1_max) stats->low1_max = low;
+		} else {
+			if(low < stats->low0_min) stats->low0_min = low;
+			if(low > stats->low0_max) stats->low0_max = low;
+		}
+
+		if(high < stats->high_min) stats->high_min = high;
+		if(period < stats->period_min) stats->period_min = period;
+		if(period > stats->period_max) stats->period_max = period;
+	}
+
+	stats->captures++;
+
+	// A '1' must be high at the earliest sample, a '0' low at the latest
+	early = (JOYBUS_SAMPLE_CYCLES - JOYBUS_SAMPLE_JITTER) - stats->low1_max;
+	late = stats->low0_min - (JOYBUS_SAMPLE_CYCLES + JOYBUS_SAMPLE_JITTER);
+
+	if(stats->low0_min == 0xFF)
+		late = early;
+
+	stats->margin = (early < late) ? early : late;
+}
+
+/* Sends the window stats as TRACE_JOYBUS events (see Trace.h) */
+void JoybusTiming::report() {
+	JoybusStats *w = &JoybusTiming::window;
+
+	Trace::event(TRACE_JOYBUS, w->captures > 0xFF ? 0xFF : w->captures);
+	Trace::event(TRACE_JOYBUS, w->bad > 0xFF ? 0xFF : w->bad);
+	Trace::event(TRACE_JOYBUS, w->low1_min);
+	Trace::event(TRACE_JOYBUS, w->low1_max);
+	Trace::event(TRACE_JOYBUS, w->low0_min);
+	Trace::event(TRACE_JOYBUS, w->low0_max);
+	Trace::event(TRACE_JOYBUS, w->high_min);
+	Trace::event(TRACE_JOYBUS, w->period_min);
+	Trace::event(TRACE_JOYBUS, w->period_max);
+	Trace::event(TRACE_JOYBUS, w->margin);
+	Trace::event(TRACE_JOYBUS, JOYBUS_SAMPLE_CYCLES);
+}
+
+/* Takes in the last capture, reports every JOYBUS_TIMING_REPORT. Call from the pad loop */
+void JoybusTiming::service() {
+	const byte *e = JoybusTiming::edges;
+
+	if(!JoybusTiming::pending)
+		return;
+
+	for(byte i = 0; i < JoybusTiming::bits; i++, e += 2) {
+		byte low = e[1] - e[0] - JOYBUS_RISE_CYCLES;
+
+		if(JoybusTiming::histogram[low] < 0xFFFF)
+			JoybusTiming::histogram[low]++;
+	}
+
+	JoybusTiming::add(&JoybusTiming::window);
+	JoybusTiming::add(&JoybusTiming::total);
+
+	JoybusTiming::pending = false;
+
+	if(JoybusTiming::window.captures >= JOYBUS_TIMING_REPORT) {
+		JoybusTiming::report();
+		JoybusTiming::reset(&JoybusTiming::window);
+	}
+}
+
+#endif
@@ -0,0 +1,129 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+GameCube bit timing analyzer (JOYBUS_TIMING = 1 in the Makefile)
+-----------------------------------------------------------------
+
+Measures how long each bit of the pad's answer stays low and high, to see
+how much room GCPad_recv() has. It samples the line JOYBUS_SAMPLE_CYCLES
+after each falling edge: a '1' must be back high by then, a '0' still
+low.
+
+Every JOYBUS_TIMING_EVERY reads, GCPad_read() receives with capture()
+instead of GCPad_recv():
+ - Timer1 runs at clk/1 (125ns) for the transfer (Timebase::fast()).
+ - Falling edges are taken by the Timer1 input capture unit, on ICP1 (PB0,
+   board pin D8). Wire it to the pad data line, DB9 pin 1 (PD2), with a
+   jumper. PB0 is the only ICP1 pin, and it is also DETPIN4 (DB9 pin 9):
+   only use the jumper with a cable that leaves pin 9 floating, i.e. the
+   GameCube one. The N64 cable grounds pin 9 for detection, the jumper
+   would tie the data line to GND. N64 pads can't be measured this way, so
+   N64Pad_read() never captures. Remove the jumper for other pads, TG16
+   drives D8. PB0's direction and pull-up are put back after each capture.
+ - Rising edges are polled every 2 cycles, with a fixed delay
+   (JOYBUS_RISE_CYCLES, +0/+1 cycle of poll jitter). A line still low
+   after JOYBUS_TIMEOUT rounds of that poll (43 cycles each, 344us in
+   all) ends the capture, interrupts are off meanwhile.
+ - The bits are decoded from the low times, so the pad keeps working.
+   A transfer that can't be measured counts as a timeout.
+
+service() (from the pad loop) folds each capture into the stats below,
+in CPU cycles:
+ - low time of '1' and '0' bits (min / max, all time histogram)
+ - shortest high time
+ - bit period (falling edge to falling edge)
+ - margin: how far the sample window (JOYBUS_SAMPLE_CYCLES +/-
+   JOYBUS_SAMPLE_JITTER) is from the longest '1' and the shortest '0'.
+
+Every JOYBUS_TIMING_REPORT captures the stats of the window so far go out
+as TRACE_JOYBUS events (TRACE = 1) and start again. src/tools/wra-trace
+prints them, with the sample point that would give the most margin.
+Without TRACE, read JoybusTiming::total with gdb or simavr (all time).
+
+JOYBUS_RISE_CYCLES and JOYBUS_SAMPLE_CYCLES were counted by hand from the
+AVR instruction timings of capture() and of GCPad_recv() as avr-gcc built
+it, without the pin synchronizer delay. They were not measured: check
+them against a scope or a simavr trace, and keep JOYBUS_SAMPLE_CYCLES in
+sync if the nops in GCPad_recv() change.
+*/
+
+#ifndef JOYBUSTIMING_H_
+#define JOYBUSTIMING_H_
+
+#include <WProgram.h>
+
+#ifndef JOYBUS_TIMING
+#define JOYBUS_TIMING 0
+#endif
+
+#define JOYBUS_TIMING_EVERY		8 // Reads between captures
+#define JOYBUS_TIMING_REPORT	64 // Captures per TRACE_JOYBUS summary
+
+#define JOYBUS_MAX_BITS			64 // Longest answer (GC read)
+#define JOYBUS_TIMEOUT			64 // Wait loops for an edge (5 cycles falling, ~43 rising)
+#define JOYBUS_RISE_CYCLES		9 // Rising edge to its TCNT1L read in capture() (counted)
+#define JOYBUS_SAMPLE_CYCLES	17 // Falling edge to the PIND read in GCPad_recv() (counted)
+#define JOYBUS_SAMPLE_JITTER	3 // Wait loop jitter in GCPad_recv()
+#define JOYBUS_THRESHOLD		16 // Low times below this (2us) are '1' bits
+#define JOYBUS_MAX_LOW			40 // Longer low times are bad captures (5us)
+#define JOYBUS_HISTOGRAM		JOYBUS_MAX_LOW
+
+struct JoybusStats {
+	unsigned int captures;
+	unsigned int bad; // Captures that failed (timeout, edge missed)
+	byte low1_min, low1_max; // '1' bits
+	byte low0_min, low0_max; // '0' bits
+	byte high_min;
+	byte period_min, period_max;
+	signed char margin; // Sample window to the closest bit, negative = misreads
+};
+
+class JoybusTiming {
+
+#if JOYBUS_TIMING
+private:
+	static byte edges[2 * (JOYBUS_MAX_BITS + 1)];
+	static byte bits;
+	static byte reads;
+	static bool pending;
+	static byte ddrb, portb;
+
+	static void reset(JoybusStats *stats);
+	static void add(JoybusStats *stats);
+	static void report();
+
+public:
+	static JoybusStats window;
+	static JoybusStats total;
+	static unsigned int histogram[JOYBUS_HISTOGRAM]; // Low times seen, per cycle
+
+	static bool due();
+	static void start();
+	static bool capture(byte *buffer, byte bits);
+	static void service();
+#else
+public:
+	static inline bool due() { return false; }
+	static inline void start() { }
+	static inline bool capture(byte *buffer, byte bits) { return false; }
+	static inline void service() { }
+#endif
+};
+
+#endif /* JOYBUSTIMING_H_ */
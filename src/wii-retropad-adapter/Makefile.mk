@@ -40,6 +40,74 @@
 #----------------------------------------------------------------------------
 
 
+# PAD_FILTER = 1 - Oversample pads (majority vote buttons, smooth analog sticks)
+# PAD_FILTER = 0 - One pad read per report, no filtering
+PAD_FILTER = 0
+
+# TURBO = 1 - Turbo/autofire, toggled per button with DOWN + START + button
+# TURBO = 0 - No turbo
+TURBO = 0
+
+# TRACE = 1 - Binary event trace on the serial TX pin (see Trace.h)
+# TRACE = 0 - No trace
+TRACE = 0
+
+# SIMAVR = 1 - Tag the ELF with MCU/F_CPU and pin traces for simavr (see simavr.c)
+# SIMAVR = 0 - Plain build
+SIMAVR = 0
+SIMAVR_INC = /usr/local/include/simavr/avr
+
+# STACK_MONITOR = 1 - Paint the stack and trace its high-water mark (see StackMonitor.h)
+# STACK_MONITOR = 0 - No stack monitor
+STACK_MONITOR = 0
+
+# PROFILER = 2 - As 1, plus probe pins A0-A3 high during each slot
+# PROFILER = 1 - ISR / critical section durations in profiler_slots (see Profiler.h)
+# PROFILER = 0 - No profiler
+# arduinocore/Makefile(.168) reads it from here, "make PROFILER=1" sets both
+PROFILER = 0
+
+# TIMER0_OFF = 1 - Disable the Arduino timer0 interrupt, millis()/micros() stop (see Timebase.h)
+# TIMER0_OFF = 0 - Keep it
+TIMER0_OFF = 0
+
+# PAD_CACHE = 1 - Remember stick centers and PS2 timing per pad type in EEPROM (see PadCache.h)
+# PAD_CACHE = 0 - Nothing stored
+PAD_CACHE = 0
+
+# PAD_CACHE_SWAP = 1 - Also remember the N64 L/Z swap across power ups, needs PAD_CACHE = 1
+# PAD_CACHE_SWAP = 0 - The swap lasts until power off
+PAD_CACHE_SWAP = 0
+
+# REPLAY = 2 - Replay the recording instead of reading the pad (see Replay.h)
+# REPLAY = 1 - Record the pad state changes into EEPROM while playing
+# REPLAY = 0 - No record / replay
+REPLAY = 0
+
+# LOW_POWER = 1 - Sleep between pad reads / Wiimote fetches, unused peripherals off (see Power.h)
+# LOW_POWER = 0 - Always run
+LOW_POWER = 0
+
+# ARCADE = 1 - Switches wired straight to the adapter pins, no pad detection (see Arcade.h)
+# ARCADE = 0 - Pads, auto detected
+ARCADE = 0
+
+# SNIFFER = 1 - Log every Wiimote I2C transaction, dumped over serial on request (see Sniffer.h)
+# SNIFFER = 0 - No sniffer, needs TRACE = 0
+SNIFFER = 0
+
+# JOYBUS_TIMING = 1 - Measure GameCube pad bit timing, needs a jumper D8 - DB9 pin 1 (see JoybusTiming.h)
+# JOYBUS_TIMING = 0 - No timing analyzer
+JOYBUS_TIMING = 0
+
+# ARENA_CHECK = 1 - Trace drivers using a driver arena member they don't own (see Arena.h)
+# ARENA_CHECK = 0 - No check
+ARENA_CHECK = 0
+
+# WIICC_FORWARD = 1 - Wii Classic Controller reports go to the Wiimote as read, no neutral radius (see WiiCCPad.h)
+# WIICC_FORWARD = 0 - Decoded and encoded again like other pads
+WIICC_FORWARD = 0
+
 # MCU name
 MCU = atmega328p
 
@@ -80,12 +148,24 @@ OBJDIR = .
 
 
 # List C source files here. (C dependencies are automatically generated.)
-SRC = Wire/utility/twi.c
+SRC = Wire/utility/twi.c simavr.c Profiler.c
 
 
 # List C++ source files here. (C dependencies are automatically generated.)
 CPPSRC = genesis.cpp main.cpp NESPad.cpp PS2Pad.cpp wra.cpp Wire/Wire.cpp \
-WMCrypt.cpp WMExtension.cpp GCPad.cpp saturn.cpp tg16.cpp
+WMCrypt.cpp WMExtension.cpp GCPad.cpp saturn.cpp tg16.cpp Arena.cpp \
+PadFilter.cpp \
+Turbo.cpp \
+Trace.cpp \
+StackMonitor.cpp \
+Timebase.cpp \
+PadCache.cpp \
+Replay.cpp \
+Power.cpp \
+Arcade.cpp \
+WiiCCPad.cpp \
+Sniffer.cpp \
+JoybusTiming.cpp
 
 
 # List Assembler source files here.
@@ -115,7 +195,7 @@ DEBUG = dwarf-2
 #     Each directory must be seperated by a space.
 #     Use forward slashes for directory separators.
 #     For a directory that has spaces, enclose it in quotes.
-EXTRAINCDIRS = ./arduinocore ./Wire ./Wire/utility
+EXTRAINCDIRS = ./arduinocore ./Wire ./Wire/utility $(if $(filter 1,$(SIMAVR)),$(SIMAVR_INC))
 
 
 # Compiler flag to set the C Standard level.
@@ -127,7 +207,7 @@ CSTANDARD = -std=gnu99
 
 
 # Place -D or -U options here for C sources
-CDEFS = -DF_CPU=$(F_CPU)UL -DARDUINO=22
+CDEFS = -DF_CPU=$(F_CPU)UL -DARDUINO=22 -DPAD_FILTER=$(PAD_FILTER) -DTURBO=$(TURBO) -DTRACE=$(TRACE) -DSIMAVR=$(SIMAVR) -DSIMAVR_MCU=\"$(MCU)\" -DSTACK_MONITOR=$(STACK_MONITOR) -DPROFILER=$(PROFILER) -DTIMER0_OFF=$(TIMER0_OFF) -DPAD_CACHE=$(PAD_CACHE) -DPAD_CACHE_SWAP=$(PAD_CACHE_SWAP) -DREPLAY=$(REPLAY) -DLOW_POWER=$(LOW_POWER) -DARCADE=$(ARCADE) -DSNIFFER=$(SNIFFER) -DJOYBUS_TIMING=$(JOYBUS_TIMING) -DARENA_CHECK=$(ARENA_CHECK) -DWIICC_FORWARD=$(WIICC_FORWARD)
 
 
 # Place -D or -U options here for ASM sources
@@ -135,7 +215,7 @@ ADEFS = -DF_CPU=$(F_CPU) -DARDUINO=22
 
 
 # Place -D or -U options here for C++ sources
-CPPDEFS = -DF_CPU=$(F_CPU)UL -DARDUINO=22
+CPPDEFS = -DF_CPU=$(F_CPU)UL -DARDUINO=22 -DPAD_FILTER=$(PAD_FILTER) -DTURBO=$(TURBO) -DTRACE=$(TRACE) -DSTACK_MONITOR=$(STACK_MONITOR) -DPROFILER=$(PROFILER) -DTIMER0_OFF=$(TIMER0_OFF) -DPAD_CACHE=$(PAD_CACHE) -DPAD_CACHE_SWAP=$(PAD_CACHE_SWAP) -DREPLAY=$(REPLAY) -DLOW_POWER=$(LOW_POWER) -DARCADE=$(ARCADE) -DSNIFFER=$(SNIFFER) -DJOYBUS_TIMING=$(JOYBUS_TIMING) -DARENA_CHECK=$(ARENA_CHECK) -DWIICC_FORWARD=$(WIICC_FORWARD)
 #CPPDEFS += -D__STDC_LIMIT_MACROS
 #CPPDEFS += -D__STDC_CONSTANT_MACROS
 
@@ -293,8 +373,10 @@ AVRDUDE_PORT = /dev/tty.usbmodem12341    # programmer connected to serial device
 AVRDUDE_BAUD = 19200   # serial device baud rate
 
 # Fuses config
+# LFUSE: internal 8MHz RC, SUT = 00 (6CK + 14CK start-up, no 65ms delay,
+# valid because BOD is enabled), so the adapter answers the Wiimote sooner
 AVRDUDE_HFUSE = 0xde
-AVRDUDE_LFUSE = 0xe2
+AVRDUDE_LFUSE = 0xc2
 AVRDUDE_EFUSE = 0xfd
 
 AVRDUDE_WRITE_FLASH = -U flash:w:$(TARGET).hex
@@ -362,6 +444,7 @@ OBJDUMP = avr-objdump
 SIZE = avr-size
 AR = avr-ar rcs
 NM = avr-nm
+CPPFILT = avr-c++filt
 AVRDUDE = avrdude
 REMOVE = rm -f
 REMOVEDIR = rm -rf
@@ -376,6 +459,8 @@ MSG_BEGIN = -------- begin --------
 MSG_END = --------  end  --------
 MSG_SIZE_BEFORE = Size before: 
 MSG_SIZE_AFTER = Size after:
+MSG_SRAM_REPORT = Static RAM, linked sections then per object (bytes):
+MSG_SRAM_SYMBOLS = Static RAM symbols (size, object, name):
 MSG_COFF = Converting to AVR COFF:
 MSG_EXTENDED_COFF = Converting to AVR Extended COFF:
 MSG_FLASH = Creating load file for Flash:
@@ -414,7 +499,7 @@ ALL_ASFLAGS = -mmcu=$(MCU) -I. -x assembler-with-cpp $(ASFLAGS)
 
 
 # Default target.
-all: begin gccversion sizebefore build sizeafter end
+all: begin gccversion sizebefore build sizeafter sramreport end
 
 # Change the build target to build a HEX file or a library.
 build: elf hex eep lss sym
@@ -455,6 +540,24 @@ sizeafter:
 	@if test -f $(TARGET).elf; then echo; echo $(MSG_SIZE_AFTER); $(ELFSIZE); \
 	2>/dev/null; echo; fi
 
+# Display static RAM: the SRAM sections of the linked ELF, what each object
+# put there after --gc-sections (from the map, see sram.awk), then the size
+# of each member of the driver arena (Arena.o holds the largest one).
+sramreport:
+	@if test -f $(TARGET).elf; then echo; echo "$(MSG_SRAM_REPORT)"; \
+	$(SIZE) -A $(TARGET).elf | \
+	awk '$$1 ~ /^\.(data|bss|noinit)$$/ { printf "%6d  %s\n", $$2, $$1 }'; echo; \
+	awk -f sram.awk $(TARGET).map | sort -n; \
+	$(NM) -t d $(TARGET).elf | \
+	awk '$$3 ~ /^arena_size_/ { printf "%6d  arena: %s\n", $$1, substr($$3, 12) }'; \
+	echo; fi
+
+# Display every static RAM variable left after linking, smallest first, with
+# its object. Read from the map, works without debug info (-g).
+sramsymbols:
+	@if test -f $(TARGET).elf; then echo; echo "$(MSG_SRAM_SYMBOLS)"; \
+	awk -v sym=1 -f sram.awk $(TARGET).map | sort -n | $(CPPFILT); echo; fi
+
 
 
 # Display compiler version information.
@@ -640,6 +743,6 @@ $(shell mkdir $(OBJDIR) 2>/dev/null)
 
 
 # Listing of phony targets.
-.PHONY : all begin finish end sizebefore sizeafter gccversion \
+.PHONY : all begin finish end sizebefore sizeafter sramreport sramsymbols gccversion \
 build elf hex eep lss sym coff extcoff \
 clean clean_list program debug gdb-config
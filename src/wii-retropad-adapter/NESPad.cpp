@@ -19,6 +19,9 @@
 #include <WProgram.h>
 #include "NESPad.h"
 #include "digitalWriteFast.h"
+#include "Delay.h"
+
+#define PULSE()	DELAY_NS_MIN(NES_PULSE_NS, NES_PULSE_MIN_NS)
 
 void NESPad::init() {
 	pinModeFast(CLOCK_PIN, OUTPUT);
@@ -36,14 +39,14 @@ int NESPad::read(int bits) {
 	digitalWriteFast(CLOCK_PIN, LOW);
 
 	digitalWriteFast(LATCH_PIN, HIGH);
-	delayMicroseconds(1);
+	PULSE();
 	digitalWriteFast(LATCH_PIN, LOW);
 
 	state = digitalReadFast(DATA_PIN);
 
 	for (i = 1; i < bits; i++) {
 		digitalWriteFast(CLOCK_PIN, HIGH);
-		delayMicroseconds(1);
+		PULSE();
 		digitalWriteFast(CLOCK_PIN, LOW);
 
 		state = state | (digitalReadFast(DATA_PIN) << i);
@@ -53,7 +53,7 @@ SNES Clock pulse and corresponding button
     [no button, always high]
     [no button, always high]
     [no button, always high]
-16  [no button, always high]
+16  [no button, always high]
 */
 
 #ifndef NESPAD_H_
@@ -65,6 +65,11 @@ SNES Clock pulse and corresponding button
 #define LATCH_PIN 3
 #define DATA_PIN 4
 
+// LATCH and CLOCK high. The 4021 needs far less, but pads have only been
+// run at the ~1.75us delayMicroseconds(1) gave, so that is the minimum too
+#define NES_PULSE_NS		1750
+#define NES_PULSE_MIN_NS	1750
+
 class NESPad {
 
 public:
@@ -19,9 +19,12 @@
 #include <WProgram.h>
 #include "PS2Pad.h"
 #include "digitalWriteFast.h"
+#include "Arena.h"
+#include "Profiler.h"
+#include "Delay.h"
+#include "Timebase.h"
 
 byte PS2Pad::_type;
-byte PS2Pad::_pad_data[21];
 byte PS2Pad::_read_delay = 1;
 bool PS2Pad::_disableInt = false;
 bool PS2Pad::_analogMode = false;
@@ -38,7 +41,7 @@ byte PS2Pad::gamepad_spi(byte send_data) {
 			digitalWriteFast(CMD_PIN, LOW);
 		}
 
-		delayMicroseconds(CTRL_CLK);
+		DELAY_US_MIN(CTRL_CLK, CTRL_CLK_MIN_NS);
 
 		digitalWriteFast(CLK_PIN, HIGH);
 
@@ -46,27 +49,35 @@ byte PS2Pad::gamepad_spi(byte send_data) {
 			recv_data |= (1 << i);
 		}
 
-		delayMicroseconds(CTRL_CLK);
+		DELAY_US_MIN(CTRL_CLK, CTRL_CLK_MIN_NS);
 	}
 
 	digitalWriteFast(CLK_PIN, HIGH);
 
-	delayMicroseconds(CTRL_BYTE_DELAY);
+	DELAY_US_MIN(CTRL_BYTE_DELAY, CTRL_BYTE_DELAY_MIN_NS);
 
 	return recv_data;
 }
 
+/* Waits _read_delay milliseconds between packets */
+void PS2Pad::wait_read_delay() {
+	for(byte i = 0; i < PS2Pad::_read_delay; i++)
+		DELAY_US(1000);
+}
+
 void PS2Pad::send_command(byte data[], byte size) {
 
 	if(PS2Pad::_disableInt)
 		noInterrupts();
 
+	PROFILER_ENTER(PROF_PS2);
+
 	digitalWriteFast(ATT_PIN, LOW);
 	digitalWriteFast(CMD_PIN, HIGH);
 
 	digitalWriteFast(CLK_PIN, HIGH);
 
-	delayMicroseconds(CTRL_BYTE_DELAY*2);
+	DELAY_US_MIN(CTRL_BYTE_DELAY*2, 2 * CTRL_BYTE_DELAY_MIN_NS);
 
 	for(byte i = 0; i < size; i++) {
 		data[i] = PS2Pad::gamepad_spi(data[i]);
@@ -74,26 +85,31 @@ void PS2Pad::send_command(byte data[], byte size) {
 
 	digitalWriteFast(ATT_PIN, HIGH);
 
+	PROFILER_EXIT(PROF_PS2);
+
 	if(PS2Pad::_disableInt)
 		interrupts();
 
-	delayMicroseconds(PS2Pad::_read_delay * 1000);
+	PS2Pad::wait_read_delay();
 }
 
 void PS2Pad::read() {
-	PS2Pad::_pad_data[0] = 0x01;
-	PS2Pad::_pad_data[1] = 0x42;
+	Arena::check(ARENA_PS2);
 
-	delayMicroseconds(PS2Pad::_read_delay * 1000);
+	Arena::data.ps2.pad_data[0] = 0x01;
+	Arena::data.ps2.pad_data[1] = 0x42;
+
+	PS2Pad::wait_read_delay();
 
 	for (byte i = 2; i < 21; i++) {
-		PS2Pad::_pad_data[i] = 0x00;
+		Arena::data.ps2.pad_data[i] = 0x00;
 	}
 
-	PS2Pad::send_command(PS2Pad::_pad_data, 21);
+	PS2Pad::send_command(Arena::data.ps2.pad_data, 21);
 }
 
-int PS2Pad::init(bool disableInt) {
+/* Starts the read delay search (1ms steps, 3 tries) at read_delay */
+int PS2Pad::init(bool disableInt, byte read_delay) {
 
 	PS2Pad::_disableInt = disableInt;
 
@@ -111,14 +127,17 @@ int PS2Pad::init(bool disableInt) {
 
 	PS2Pad::read();
 
-	if(PS2Pad::_pad_data[1] != 0x41 && PS2Pad::_pad_data[1] != 0x73 && PS2Pad::_pad_data[1] != 0x79) {
+	if(Arena::data.ps2.pad_data[1] != 0x41 && Arena::data.ps2.pad_data[1] != 0x73 && Arena::data.ps2.pad_data[1] != 0x79) {
 		return 1;
 	}
 
-	PS2Pad::_read_delay = 1;
+	PS2Pad::_read_delay = read_delay;
 
 	for(byte i = 0; i <= 2; i++) {
 
+		// Up to 5 packets and read delays per try, don't miss a Timer1 wrap
+		Timebase::now();
+
 		// Enter Config Mode
 		byte enter_config_command[] = {0x01, 0x43, 0x00, 0x01, 0x00};
 		PS2Pad::send_command(enter_config_command, 5);
@@ -139,7 +158,7 @@ int PS2Pad::init(bool disableInt) {
 
 		PS2Pad::read();
 
-		if(PS2Pad::_pad_data[1] == 0x73) {
+		if(Arena::data.ps2.pad_data[1] == 0x73) {
 			_analogMode = true;
 			break;
 		}
@@ -151,7 +170,7 @@ int PS2Pad::init(bool disableInt) {
 }
 
 word PS2Pad::psx_buttons() {
-	word buttons = *(word*)(PS2Pad::_pad_data + 3);
+	word buttons = *(word*)(Arena::data.ps2.pad_data + 3);
 	return ~buttons;
 }
 
@@ -161,7 +180,7 @@ byte PS2Pad::button(word button) {
 }
 
 byte PS2Pad::stick(word stick) {
-	return PS2Pad::_pad_data[stick];
+	return Arena::data.ps2.pad_data[stick];
 }
 
 byte PS2Pad::type() {
@@ -173,7 +192,11 @@ byte PS2Pad::type() {
 	return 0;
 }
 
+byte PS2Pad::read_delay() {
+	return PS2Pad::_read_delay;
+}
+
 byte PS2Pad::PS2Pad_mode(void) {
-	return PS2Pad::_pad_data[1] >> 4;
+	return Arena::data.ps2.pad_data[1] >> 4;
 }
 
@@ -29,6 +29,11 @@
 #define CTRL_CLK 20
 #define CTRL_BYTE_DELAY 3
 
+// Least CLK half period and byte gap: what delayMicroseconds(20) and (3)
+// gave (8n - 1 cycles at 8MHz), the pads have not been run faster
+#define CTRL_CLK_MIN_NS 19875
+#define CTRL_BYTE_DELAY_MIN_NS 2875
+
 //These are our button constants
 #define PSB_SELECT      0x0001
 #define PSB_L3          0x0002
@@ -58,15 +63,16 @@ class PS2Pad {
 private:
 	static byte gamepad_spi(byte send_data);
 	static void send_command(byte data[], byte size);
+	static void wait_read_delay();
 	static word psx_buttons();
 	static byte _type;
-	static byte _pad_data[21];
 	static byte _read_delay;
 	static bool _disableInt;
 	static bool _analogMode;
 
 public:
-	static int init(bool disableInt);
+	static int init(bool disableInt, byte read_delay = 1);
+	static byte read_delay();
 	static void read();
 	static byte type();
 	static byte button(word button);
@@ -0,0 +1,173 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "PadCache.h"
+
+#if PAD_CACHE
+
+/* Record being written, and where */
+PadCache::Record PadCache::out;
+byte PadCache::slot = PADCACHE_SLOTS - 1;
+
+/* Slots store() skips, bit per slot: the newest record of another pad type */
+byte PadCache::keep = 0;
+
+/* Bytes of out still to be written, 0 when idle */
+byte PadCache::pending = 0;
+
+/* CRC-8 (Dallas / Maxim) of everything but the crc field */
+byte PadCache::crc(const Record *r) {
+	const byte *p = (const byte *) r;
+	byte c = 0;
+
+	for(byte i = 0; i < sizeof(Record) - 1; i++)
+		c = _crc_ibutton_update(c, p[i]);
+
+	return c;
+}
+
+// Sequence numbers wrap, newer means ahead by less than half the range
+#define NEWER(a, b)	((signed char)((a) - (b)) > 0)
+
+/*
+ * Finds the newest valid record saved for pad. Returns true (and fills
+ * data) if there is one. The next store() goes to the slot after the
+ * newest record of any pad, skipping the ones other pad types need.
+ */
+bool PadCache::load(int pad, PadCacheData *data) {
+	Record r;
+	byte pads[PADCACHE_SLOTS], seqs[PADCACHE_SLOTS];
+	byte newest = PADCACHE_SLOTS, own = PADCACHE_SLOTS;
+	byte i, j;
+
+	for(i = 0; i < PADCACHE_SLOTS; i++) {
+		eeprom_read_block(&r, (const void *)(uintptr_t)(PADCACHE_BASE + i * PADCACHE_SLOT_SIZE), sizeof(Record));
+
+		if(r.crc != PadCache::crc(&r)) {
+			pads[i] = PADCACHE_NO_PAD;
+			continue;
+		}
+
+		pads[i] = r.pad;
+		seqs[i] = r.seq;
+
+		if(newest == PADCACHE_SLOTS || NEWER(r.seq, seqs[newest]))
+			newest = i;
+
+		if(r.pad == (byte)pad && (own == PADCACHE_SLOTS || NEWER(r.seq, seqs[own]))) {
+			PadCache::out = r;
+			own = i;
+		}
+	}
+
+	PadCache::keep = 0;
+
+	for(i = 0; i < PADCACHE_SLOTS; i++) {
+		if(pads[i] == PADCACHE_NO_PAD || pads[i] == (byte)pad)
+			continue;
+
+		for(j = 0; j < PADCACHE_SLOTS; j++) {
+			if(pads[j] == pads[i] && NEWER(seqs[j], seqs[i]))
+				break;
+		}
+
+		if(j == PADCACHE_SLOTS)
+			PadCache::keep |= _BV(i);
+	}
+
+	if(newest < PADCACHE_SLOTS) {
+		PadCache::slot = newest;
+		PadCache::out.seq = seqs[newest];
+	}
+
+	if(own == PADCACHE_SLOTS) {
+		PadCache::out.pad = PADCACHE_NO_PAD;
+		return false;
+	}
+
+	*data = PadCache::out.data;
+
+	return true;
+}
+
+/* Queues data as the new record for pad, if it differs from the last one */
+void PadCache::store(int pad, const PadCacheData *data) {
+	if(PadCache::out.pad == (byte)pad && !memcmp(&PadCache::out.data, data, sizeof(PadCacheData)))
+		return;
+
+	// A write in progress is restarted in the same slot, the CRC goes last
+	if(!PadCache::pending) {
+		byte next = PadCache::slot;
+		byte i;
+
+		for(i = 0; i < PADCACHE_SLOTS; i++) {
+			next = (next + 1) % PADCACHE_SLOTS;
+
+			if(!(PadCache::keep & _BV(next)))
+				break;
+		}
+
+		// All taken by other pads: the next one goes anyway
+		if(i == PADCACHE_SLOTS)
+			next = (PadCache::slot + 1) % PADCACHE_SLOTS;
+
+		PadCache::keep &= ~_BV(next);
+		PadCache::slot = next;
+		PadCache::out.seq++;
+	}
+
+	PadCache::out.pad = pad;
+	PadCache::out.data = *data;
+	PadCache::out.crc = PadCache::crc(&PadCache::out);
+	PadCache::pending = sizeof(Record);
+}
+
+/* Writes the next queued byte if the EEPROM is ready. Call from the pad loops */
+void PadCache::service() {
+	uint8_t oldSREG;
+	byte i;
+	unsigned int addr;
+
+	if(!PadCache::pending || (EECR & _BV(EEPE)))
+		return;
+
+	i = sizeof(Record) - PadCache::pending;
+	addr = PADCACHE_BASE + PadCache::slot * PADCACHE_SLOT_SIZE + i;
+
+	PadCache::pending--;
+
+	oldSREG = SREG;
+	cli();
+
+	EEAR = addr;
+	EECR |= _BV(EERE);
+
+	// Same value already there, save a write cycle
+	if(EEDR != ((byte *) &PadCache::out)[i]) {
+		EEDR = ((byte *) &PadCache::out)[i];
+		EECR |= _BV(EEMPE);
+		EECR |= _BV(EEPE);
+	}
+
+	SREG = oldSREG;
+}
+
+#endif
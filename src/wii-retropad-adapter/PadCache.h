@@ -0,0 +1,108 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+EEPROM pad profile cache (enabled with PAD_CACHE = 1 in the Makefile)
+----------------------------------------------------------------------
+
+Keeps the last good stick centers, PS2 read delay and mapping choice of
+each pad type, so the next boot with that type can start from them:
+
+ - GC / N64 / PS2 / Wii Classic: the first read only replaces the cached
+   centers when it is within ANALOG_NEUTRAL_RADIUS of them (stick at rest).
+   A stick held at plug-in no longer shifts the center. Otherwise the
+   sticks are watched until they rest for a second: a rest position away
+   from the cache (another pad of the same type) replaces it, see
+   settle_centers() in wra.cpp.
+ - PS2: the config handshake starts from the cached read delay instead of
+   searching from 1ms.
+ - N64: holding L at plug-in toggles the L / Z swap for that session. It is
+   only remembered with PAD_CACHE_SWAP = 1, otherwise it starts off at
+   every power up, as without the cache.
+
+EEPROM holds PADCACHE_SLOTS records of PADCACHE_SLOT_SIZE bytes, written
+round robin with a sequence number, and a CRC-8 over the record. Each
+record is for one pad type (detectPad() value). The newest valid record
+of the type wins, so a write cut by a power loss just falls back to the
+previous one. Saves skip the slots holding the newest record of another
+pad type, so plugging a GC pad in doesn't lose the PS2 pad's centers.
+The other slots are rewritten in turn, and unchanged bytes are never
+rewritten.
+
+Writes are queued and done one byte per service() call (~3.4ms each, in
+the background of the pad loop), never blocking a pad read.
+*/
+
+#ifndef PADCACHE_H_
+#define PADCACHE_H_
+
+#include <WProgram.h>
+
+#ifndef PAD_CACHE
+#define PAD_CACHE 0
+#endif
+
+#ifndef PAD_CACHE_SWAP
+#define PAD_CACHE_SWAP 0
+#endif
+
+#define PADCACHE_SLOTS		8
+#define PADCACHE_SLOT_SIZE	16
+#define PADCACHE_BASE		0x000 // EEPROM address of slot 0
+#define PADCACHE_NO_PAD		0xFF // Record.pad of an empty or corrupt slot
+
+// PadCacheData.flags
+#define PADCACHE_SWAP_L_Z	0x01 // N64: L and Z swapped
+
+struct PadCacheData {
+	byte flags;
+	byte read_delay;
+	byte center[4]; // lx, ly, rx, ry
+};
+
+class PadCache {
+
+#if PAD_CACHE
+private:
+	struct Record {
+		byte seq;
+		byte pad;
+		PadCacheData data;
+		byte crc;
+	};
+
+	static Record out;
+	static byte slot;
+	static byte keep;
+	static byte pending;
+
+	static byte crc(const Record *r);
+
+public:
+	static bool load(int pad, PadCacheData *data);
+	static void store(int pad, const PadCacheData *data);
+	static void service();
+#else
+public:
+	static inline bool load(int pad, PadCacheData *data) { return false; }
+	static inline void store(int pad, const PadCacheData *data) { }
+	static inline void service() { }
+#endif
+};
+
+#endif /* PADCACHE_H_ */
@@ -0,0 +1,116 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "PadFilter.h"
+#include "WMExtension.h"
+
+#if PAD_FILTER
+
+/* Samples per digital report currently in use (always odd) */
+byte PadFilter::samples = 1;
+
+/* Filtered reports produced since the last Wiimote fetch */
+byte PadFilter::reports = 0;
+
+/* WMExtension fetch counter seen on the last report */
+byte PadFilter::last_fetch = 0;
+
+/* Bitmask of analog axes that already hold a filtered value */
+byte PadFilter::primed = 0;
+
+/* Analog filter state, value << PADFILTER_ANALOG_SHIFT */
+unsigned int PadFilter::analog[PADFILTER_AXES];
+
+/*
+ * Adapts the number of samples per report to the Wiimote poll interval.
+ * Goes up while at least two reports would still fit in a poll interval
+ * with two more samples each, goes down once fewer than two fit.
+ */
+void PadFilter::adapt() {
+	byte fetch = WMExtension::get_fetch_count();
+
+	if(PadFilter::reports < 0xFF)
+		PadFilter::reports++;
+
+	if(fetch == PadFilter::last_fetch)
+		return;
+
+	PadFilter::last_fetch = fetch;
+
+	if(PadFilter::reports < 2) {
+		if(PadFilter::samples > 1)
+			PadFilter::samples -= 2;
+	} else if(PadFilter::samples < PADFILTER_MAX_SAMPLES) {
+		if((unsigned int)PadFilter::reports * PadFilter::samples > 2u * (PadFilter::samples + 2))
+			PadFilter::samples += 2;
+	}
+
+	PadFilter::reports = 0;
+}
+
+/*
+ * Reads the pad N times and returns the bitwise majority of the samples.
+ *
+ * Bits are counted in parallel with a 3 bit ripple counter (s2 s1 s0) per
+ * button, which is enough for up to 7 samples.
+ */
+int PadFilter::vote(int (*read)(void)) {
+	unsigned int s0 = 0, s1 = 0, s2 = 0, x, c;
+	byte n = PadFilter::samples;
+
+	for(byte i = 0; i < n; i++) {
+		PROFILER_ENTER(PROF_PAD_READ);
+		x = read();
+		PROFILER_EXIT(PROF_PAD_READ);
+
+		c = s0 & x;
+		s0 ^= x;
+		s2 |= s1 & c;
+		s1 ^= c;
+	}
+
+	PadFilter::adapt();
+
+	switch(n) {
+	case 1: // count >= 1
+		return s0;
+	case 3: // count >= 2
+		return s1 | s2;
+	case 5: // count >= 3
+		return s2 | (s1 & s0);
+	default: // count >= 4
+		return s2;
+	}
+}
+
+/* Runs one step of the exponential filter of the given analog axis */
+byte PadFilter::smooth(byte axis, byte value) {
+	unsigned int *y = &PadFilter::analog[axis];
+
+	if(!(PadFilter::primed & (1 << axis))) {
+		PadFilter::primed |= (1 << axis);
+		*y = (unsigned int)value << PADFILTER_ANALOG_SHIFT;
+	}
+
+	*y += value - (*y >> PADFILTER_ANALOG_SHIFT);
+
+	return *y >> PADFILTER_ANALOG_SHIFT;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Pad acquisition filter (enabled with PAD_FILTER = 1 in the Makefile)
+--------------------------------------------------------------------
+
+Digital pads: every report is the bitwise majority of N consecutive reads,
+so a single glitched bit (worn shift register, bad contact) is dropped.
+N starts at 1 and is adapted (1, 3, 5, ... PADFILTER_MAX_SAMPLES) so that
+at least two filtered reports still fit in each Wiimote poll interval.
+
+A report is voted on N reads taken back to back, and a change needs
+(N + 1) / 2 of them to win. Without the filter a change is reported after
+at most 1 read. With it, a change that comes just too late for one report
+waits for the whole next one: at most (3N - 1) / 2 reads. The worst case
+added latency, in pad reads (t_read), is therefore 3 (N - 1) / 2:
+
+      +---+---------+   t_read: NES ~30us, SNES/Neo Geo ~60us,
+      | N | latency |           Saturn ~35us, TG16 ~10us,
+      +---+---------+           Genesis 3 button ~90us,
+      | 1 |    0    |           Genesis 6 button ~2.1ms (settle delay,
+      | 3 |    3    |           N will rarely go above 1)
+      | 5 |    6    |
+      | 7 |    9    |
+      +---+---------+
+
+Analog axes: fixed point exponential filter, y += (x - y) / 2^SHIFT, run
+once per new pad sample. Group delay is about 2^SHIFT - 1 samples
+(SHIFT 1: 1 sample, SHIFT 2: 3 samples, SHIFT 3: 7 samples). On GC/N64 a
+sample is taken per Wiimote fetch, on PS2 one per ps2_loop iteration (~2ms).
+*/
+
+#ifndef PADFILTER_H_
+#define PADFILTER_H_
+
+#include <WProgram.h>
+#include "Profiler.h"
+
+#ifndef PAD_FILTER
+#define PAD_FILTER 0
+#endif
+
+// Max samples per digital report (odd, up to 7)
+#define PADFILTER_MAX_SAMPLES 5
+
+// Analog exponential filter strength
+#define PADFILTER_ANALOG_SHIFT 2
+
+// Analog axes handled by the filter
+#define PADFILTER_LX 0
+#define PADFILTER_LY 1
+#define PADFILTER_RX 2
+#define PADFILTER_RY 3
+#define PADFILTER_LT 4
+#define PADFILTER_RT 5
+#define PADFILTER_AXES 6
+
+class PadFilter {
+
+#if PAD_FILTER
+private:
+	static byte samples;
+	static byte reports;
+	static byte last_fetch;
+	static byte primed;
+	static unsigned int analog[PADFILTER_AXES];
+
+	static void adapt();
+
+public:
+	static int vote(int (*read)(void));
+	static byte smooth(byte axis, byte value);
+#else
+public:
+	static inline int vote(int (*read)(void)) {
+		int x;
+
+		PROFILER_ENTER(PROF_PAD_READ);
+		x = read();
+		PROFILER_EXIT(PROF_PAD_READ);
+
+		return x;
+	}
+	static inline byte smooth(byte axis, byte value) { return value; }
+#endif
+};
+
+#endif /* PADFILTER_H_ */
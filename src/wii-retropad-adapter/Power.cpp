@@ -0,0 +1,185 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include <avr/sleep.h>
+#include <avr/power.h>
+#include "Power.h"
+#include "WMExtension.h"
+#include "Timebase.h"
+#include "Trace.h"
+#include "Sniffer.h"
+
+#if LOW_POWER
+
+/* Fetch counter and time of the last fetch seen */
+byte Power::last_fetch = 0;
+bool Power::fetched = false;
+unsigned long Power::fetch_time;
+
+/* Smoothed fetch interval in us, 0 until two fetches in a row were seen */
+unsigned long Power::interval = 0;
+
+/* When idle() last returned, the pad read starts there */
+unsigned long Power::wake_time;
+
+/* Only there to end the sleep */
+EMPTY_INTERRUPT(TIMER2_COMPA_vect);
+
+/* Turns off the unused peripherals, sets up Timer2. Call from setup() */
+void Power::init() {
+	// wiring.c init() enables the ADC, nothing reads it
+	ADCSRA &= ~_BV(ADEN);
+	ACSR |= _BV(ACD);
+
+	power_adc_disable();
+	power_spi_disable();
+
+#if !TRACE && !SNIFFER
+	power_usart0_disable();
+#endif
+
+#if TIMER0_OFF
+	power_timer0_disable();
+#endif
+
+	// Timer2 CTC, stopped until sleep() starts it
+	TCCR2B = 0;
+	TCCR2A = _BV(WGM21);
+	TIMSK2 = _BV(OCIE2A);
+
+	set_sleep_mode(SLEEP_MODE_IDLE);
+
+	Power::last_fetch = WMExtension::get_fetch_count();
+	Power::wake_time = Timebase::now();
+}
+
+/* Notes a new fetch, if any, and updates the interval */
+void Power::check_fetch(unsigned long now) {
+	byte fetch = WMExtension::get_fetch_count();
+	unsigned long d;
+
+	if(fetch == Power::last_fetch)
+		return;
+
+	d = now - Power::fetch_time;
+
+	// Only a single fetch since the last one tells the interval
+	if(!Power::fetched || (byte)(fetch - Power::last_fetch) != 1 || d > POWER_IDLE_US)
+		Power::interval = 0;
+	else if(!Power::interval)
+		Power::interval = d;
+	else
+		Power::interval += ((long) d - (long) Power::interval) / 4;
+
+	Power::last_fetch = fetch;
+	Power::fetch_time = now;
+	Power::fetched = true;
+}
+
+/* Sleeps up to ticks Timer2 ticks, or until counter() isn't seen anymore */
+void Power::sleep(byte ticks, byte (*counter)(), byte seen) {
+	TCNT2 = 0;
+	OCR2A = ticks - 1;
+	TIFR2 = _BV(OCF2A);
+	TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20);
+
+	// sei right before sleep, an interrupt can't slip in between
+	cli();
+
+	if(counter() == seen) {
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+	}
+
+	sei();
+
+	TCCR2B = 0;
+}
+
+/*
+ * Sleeps until the next pad read is due (see Power.h). Call at the top of
+ * the pad loop, right before reading the pad.
+ */
+void Power::idle() {
+	unsigned long now = Timebase::now();
+	unsigned long busy = now - Power::wake_time + POWER_GUARD_US;
+	unsigned long next, k;
+	bool polling;
+
+	Power::check_fetch(now);
+
+	polling = Power::fetched && now - Power::fetch_time <= POWER_IDLE_US;
+	next = now + POWER_MAX_SLEEP_US;
+
+	for(;;) {
+		if(polling) {
+			if(!Power::interval)
+				break;
+
+			// Start of the read for the first fetch it can still be ready for
+			k = (now + busy - Power::fetch_time) / Power::interval + 1;
+			next = Power::fetch_time + k * Power::interval - busy;
+
+			// Earlier if the pad is due for a read to feed the report latch
+			if((long) (next - Power::wake_time) > (long) POWER_POLL_US)
+				next = Power::wake_time + POWER_POLL_US;
+		}
+
+		if((long) (next - now) < (long) POWER_TICK_US)
+			break;
+
+		Power::sleep((next - now) > POWER_MAX_SLEEP_US ? 255 : (next - now) / POWER_TICK_US,
+				WMExtension::get_fetch_count, Power::last_fetch);
+
+		// A transfer held for a new key can't wait for the next pass
+		WMExtension::service();
+
+		now = Timebase::now();
+
+		// A fetch right after a pause is best served by a fresh read
+		if(!polling && Power::last_fetch != WMExtension::get_fetch_count())
+			break;
+
+		// Otherwise just note its time, it moves the next wake up
+		Power::check_fetch(now);
+	}
+
+	Power::check_fetch(now);
+	Power::wake_time = now;
+}
+
+/* Sleeps until any interrupt, unless the fetch counter isn't fetch anymore */
+void Power::wait_fetch(byte fetch) {
+	Power::sleep(255, WMExtension::get_fetch_count, fetch);
+}
+
+/*
+ * Sleeps up to us (POWER_MAX_SLEEP_US at most) or until any interrupt,
+ * unless counter() isn't seen anymore. For event driven pad loops.
+ */
+void Power::wait_change(byte (*counter)(), byte seen, unsigned long us) {
+	if(us < POWER_TICK_US)
+		return;
+
+	Power::sleep(us > POWER_MAX_SLEEP_US ? 255 : us / POWER_TICK_US, counter, seen);
+}
+
+#endif
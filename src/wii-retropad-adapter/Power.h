@@ -0,0 +1,131 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Low power idle (enabled with LOW_POWER = 1 in the Makefile)
+------------------------------------------------------------
+
+The adapter runs from the Wiimote battery, but every pad loop used to spin
+at full speed. With LOW_POWER the CPU sleeps in idle mode whenever there
+is nothing to do:
+
+ - Digital pads, PS2 and Wii CC (idle(), at the top of the pad loop): the
+   Wiimote fetch interval is learned from WMExtension::get_fetch_count(), and the
+   CPU sleeps until the next pad read has to start so its report is ready
+   POWER_GUARD_US before the predicted fetch. How long a read + report
+   takes is measured on every pass, so slow reads (Genesis 6 button) wake
+   up earlier. In between it still reads the pad every POWER_POLL_US, so
+   a tap that starts and ends between two fetches reaches the report
+   latch (WMExtension::latched_buttons) and goes out with the next fetch.
+   When the Wiimote hasn't fetched for POWER_IDLE_US it sleeps
+   POWER_MAX_SLEEP_US at a time (the pad is still read in between), and
+   its first fetch wakes it up for a fresh read.
+ - GC / N64 (wait_fetch()): sleep until the Wiimote fetches the next
+   report, the pad is sampled from that fetch.
+ - Arcade (wait_change()): sleep until a switch edge (pin change
+   interrupt) or the end of a debounce lockout.
+
+Any interrupt ends a sleep: TWI (a Wiimote access, which always ends the
+wait), the Timer2 compare used as wake up timer (128us ticks, at most
+~32ms so the Timer1 timebase never misses an overflow), and timer0 when
+TIMER0_OFF = 0.
+
+init() also turns off what the firmware doesn't use: ADC, analog
+comparator, SPI, the USART unless TRACE is on, and timer0 with TIMER0_OFF.
+
+Only idle mode is used. Power-save would stop Timer1 (Timebase) and the
+clock is not lowered: the TWI slave needs at least 16 CPU clocks per SCL
+period (6.4MHz at 400kHz) and all pad timings are built for F_CPU.
+
+Check the latency with TRACE = 1: the "Pad sample to next fetch"
+histogram of src/tools/wra-trace.cpp should not grow. Raise
+POWER_GUARD_US if the Wiimote fetch jitter is larger than it.
+
+Estimates for a NES pad and a 5ms fetch interval, worked out from the
+figures below, not measured on a board:
+
+ - Latency, contact to report on the wire: at most one fetch interval
+   plus POWER_GUARD_US (5.5ms), as without LOW_POWER and one read per
+   fetch. The aligned read before each fetch is kept, the POWER_POLL_US
+   reads only add to it.
+ - Shortest tap that still reaches a report: POWER_POLL_US (2ms). With
+   one read per fetch it was the fetch interval less the read, taps
+   between two reads were lost.
+ - Awake time: under 100us per pad pass (the NES read is about 25us,
+   the report and housekeeping the rest), so with 4 passes per fetch
+   about 400us of 5ms, 8%. One read per fetch was 2%.
+ - Current at 3.3V, 8MHz (ATmega328p datasheet typical curves): about
+   3.5mA awake and 1mA in idle mode, so about 1.2mA on average, against
+   1.05mA with one read per fetch and 3.5mA without LOW_POWER. The board
+   and pad draw on top of that.
+
+None of this has been measured: there are no current figures and no
+latency figures from a board. Wake latency (interrupt to first
+instruction, idle mode, 6 cycles plus the ISR) is from the datasheet. To
+measure the average current, put a shunt in the Wiimote 3.3V line and
+average it over 10s of 5ms fetches, once with LOW_POWER and once
+without. Compare the wra-trace histograms of the same two builds for
+the latency.
+
+PAD_FILTER adapts to about one report per fetch with it, so it stays at
+a single sample per report.
+*/
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <WProgram.h>
+
+#ifndef LOW_POWER
+#define LOW_POWER 0
+#endif
+
+#define POWER_GUARD_US		500 // Report ready this long before the predicted fetch
+#define POWER_POLL_US		2000 // Pad read at least this often while the Wiimote polls
+#define POWER_IDLE_US		100000UL // No fetch for this long, Wiimote isn't polling
+#define POWER_TICK_US		(1024 / (F_CPU / 1000000UL)) // Timer2 at clk/1024
+#define POWER_MAX_SLEEP_US	(255 * POWER_TICK_US)
+
+class Power {
+
+#if LOW_POWER
+private:
+	static byte last_fetch;
+	static bool fetched; // fetch_time is valid
+	static unsigned long fetch_time;
+	static unsigned long interval; // Between fetches, 0 if unknown
+	static unsigned long wake_time;
+
+	static void check_fetch(unsigned long now);
+	static void sleep(byte ticks, byte (*counter)(), byte seen);
+
+public:
+	static void init();
+	static void idle();
+	static void wait_fetch(byte fetch);
+	static void wait_change(byte (*counter)(), byte seen, unsigned long us);
+#else
+public:
+	static inline void init() { }
+	static inline void idle() { }
+	static inline void wait_fetch(byte fetch) { }
+	static inline void wait_change(byte (*counter)(), byte seen, unsigned long us) { }
+#endif
+};
+
+#endif /* POWER_H_ */
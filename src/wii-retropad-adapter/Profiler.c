@@ -0,0 +1,54 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "Profiler.h"
+
+#if PROFILER
+
+profiler_slot_t profiler_slots[PROF_SLOTS];
+volatile uint16_t profiler_isr_time;
+
+/* Clears all statistics */
+void profiler_reset(void) {
+	uint8_t oldSREG = SREG;
+	uint8_t i;
+
+	cli();
+
+	memset(profiler_slots, 0x00, sizeof(profiler_slots));
+
+	for(i = 0; i < PROF_SLOTS; i++)
+		profiler_slots[i].min = 0xFFFF;
+
+	SREG = oldSREG;
+}
+
+/* Probe pins as outputs, clears the statistics. Call from setup() */
+void profiler_init(void) {
+#if PROFILER >= 2
+	PORTC &= ~((1 << PROF_PINS) - 1);
+	DDRC |= (1 << PROF_PINS) - 1;
+#endif
+
+	profiler_reset();
+}
+
+#endif
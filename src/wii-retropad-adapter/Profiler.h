@@ -0,0 +1,186 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ISR / critical section profiler (PROFILER in the Makefiles)
+------------------------------------------------------------
+
+PROFILER = 1: min / max / total duration and count of every slot below, in
+              CPU cycles (Timer1 runs at clk/1 in these builds, see
+              Timebase.h). A slot must stay under 65536 cycles (8.2ms).
+PROFILER = 2: same, and the first PROF_PINS slots drive a probe pin high
+              while they run:
+
+      slot             pin              what
+      PROF_TWI         A0 (PC0)         TWI_vect body (Wire/utility/twi.c)
+      PROF_TIMER0      A1 (PC1)         TIMER0_OVF_vect body (arduinocore)
+      PROF_JOYBUS      A2 (PC2)         GC/N64 send + receive (GCPad.cpp)
+      PROF_PS2         A3 (PC3)         PS2 command packet (PS2Pad.cpp)
+      PROF_REPORT      -                set_button_data() report encoding
+      PROF_SEND        -                WMExtension::send_data() (in TWI)
+      PROF_RECEIVE     -                WMExtension::receive_bytes() (in TWI)
+      PROF_GEN_KEY     -                WMCrypt::wiimote_gen_key() from service()
+      PROF_DECODE      -                GCPad_data() / N64Pad_data()
+      PROF_PAD_READ    -                One NES/SNES/Genesis/Saturn/TG16/Neo Geo
+                                        read (PadFilter::vote())
+
+The function slots give per build cycle counts of the hot paths: run the
+same input (see Replay.h) on two builds and compare min / max.
+
+PROFILER is set in Makefile.mk(.168) only. arduinocore/Makefile(.168) reads
+it from there for the timer0 hook, which lives in the core library.
+
+Durations cover the code between PROFILER_ENTER and PROFILER_EXIT, the ISR
+prologue / epilogue (~20-40 cycles) and the bookkeeping itself are not
+included. Read the results from profiler_slots with gdb or simavr, or
+watch the pins on a scope / logic analyzer.
+
+Main loop slots can be interrupted. The PROF_TWI and PROF_TIMER0 bodies
+that ran in between are subtracted from the duration, and the run is
+counted in interrupted: their prologue / epilogue is still in it, so
+min / max of a slot with interrupted runs are high by that much per ISR.
+Other ISRs (INT0 / PCINT, Timer2, TIMER1_OVF) are neither subtracted nor
+counted, the slots they land in come out long.
+
+Timebase::init() must run before profiler_init().
+*/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <inttypes.h>
+
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#define PROF_TWI		0
+#define PROF_TIMER0		1
+#define PROF_JOYBUS		2
+#define PROF_PS2		3
+#define PROF_REPORT		4
+#define PROF_SEND		5
+#define PROF_RECEIVE	6
+#define PROF_GEN_KEY	7
+#define PROF_DECODE		8
+#define PROF_PAD_READ	9
+#define PROF_SLOTS		10
+
+#define PROF_PINS		4 // A0-A3, A4 / A5 are the TWI pins
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if PROFILER
+
+typedef struct {
+	uint16_t start;
+	uint16_t min;
+	uint16_t max;
+	uint32_t total;
+	uint32_t count;
+	uint16_t isr;			// profiler_isr_time at enter
+	uint32_t interrupted;	// runs with PROF_TWI / PROF_TIMER0 time taken out
+} profiler_slot_t;
+
+extern profiler_slot_t profiler_slots[PROF_SLOTS];
+
+// Cycles spent in the PROF_TWI and PROF_TIMER0 bodies so far (wraps)
+extern volatile uint16_t profiler_isr_time;
+
+void profiler_init(void);
+void profiler_reset(void);
+
+/*
+ * A slot must not nest with itself. slot must be a constant, so the pin
+ * writes compile to (atomic) sbi / cbi.
+ *
+ * TCNT1 is read through the shared TEMP register. An ISR reading it (PROF_TWI,
+ * Timebase::now()) between the two byte reads of a main loop slot would
+ * corrupt it, and the ISR time must be read at the same instant, so
+ * interrupts are off for both. In an ISR they already are, that only costs
+ * the SREG save.
+ */
+static inline void profiler_enter(uint8_t slot) {
+	profiler_slot_t *s = &profiler_slots[slot];
+	uint8_t oldSREG = SREG;
+
+#if PROFILER >= 2
+	if(slot < PROF_PINS)
+		PORTC |= _BV(slot);
+#endif
+	cli();
+	s->isr = profiler_isr_time;
+	s->start = TCNT1;
+	SREG = oldSREG;
+}
+
+static inline void profiler_exit(uint8_t slot) {
+	profiler_slot_t *s = &profiler_slots[slot];
+	uint8_t oldSREG = SREG;
+	uint16_t d, isr;
+
+	cli();
+	d = TCNT1 - s->start;
+	isr = profiler_isr_time - s->isr;
+	SREG = oldSREG;
+
+	if(isr) {
+		d -= isr;
+		s->interrupted++;
+	}
+
+	// What the main loop slots take out
+	if(slot == PROF_TWI || slot == PROF_TIMER0)
+		profiler_isr_time += d;
+
+	if(d < s->min)
+		s->min = d;
+
+	if(d > s->max)
+		s->max = d;
+
+	s->total += d;
+	s->count++;
+
+#if PROFILER >= 2
+	if(slot < PROF_PINS)
+		PORTC &= ~_BV(slot);
+#endif
+}
+
+#define PROFILER_ENTER(slot)	profiler_enter(slot)
+#define PROFILER_EXIT(slot)		profiler_exit(slot)
+
+#else
+
+static inline void profiler_init(void) { }
+
+#define PROFILER_ENTER(slot)
+#define PROFILER_EXIT(slot)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,255 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include <avr/eeprom.h>
+#include "Replay.h"
+#include "WMExtension.h"
+#include "Timebase.h"
+#include "Trace.h"
+
+#if REPLAY == 1
+
+/* Coded samples waiting for EEPROM, ring[tail] is written next */
+byte Replay::ring[REPLAY_RING_SIZE];
+byte Replay::head = 0;
+byte Replay::tail = 0;
+unsigned int Replay::stored = 0;
+
+ReplayHeader Replay::header;
+byte Replay::header_pending = 0;
+
+/* Bytes taken so far, the state they leave and the time of the last sample */
+unsigned int Replay::accepted = 0;
+byte Replay::last[REPLAY_FIELDS];
+unsigned long Replay::last_time;
+
+bool Replay::recording = false;
+
+/* Starts a new recording, replacing the previous one. Call when a pad loop starts */
+void Replay::start(int pad) {
+	Replay::header.length = 0;
+	Replay::header.pad = pad;
+	Replay::header_pending = sizeof(ReplayHeader);
+
+	Replay::head = Replay::tail = 0;
+	Replay::stored = Replay::accepted = 0;
+	Replay::last_time = Timebase::now();
+	Replay::recording = true;
+}
+
+/* Queues what changed since the last sample, coded (see Replay.h). b1 / b2 as in set_button_data */
+void Replay::record(byte b1, byte b2, byte lx, byte ly, byte rx, byte ry, byte lt, byte rt) {
+	byte state[REPLAY_FIELDS] = { b1, b2, lx, ly, rx, ry, lt, rt };
+	byte sample[REPLAY_SAMPLE_MAX];
+	unsigned long now, ticks;
+	byte mask = 0, n = 0, i;
+
+	if(!Replay::recording)
+		return;
+
+	for(i = 0; i < REPLAY_FIELDS; i++) {
+		if(!Replay::accepted || (i < 2 ? state[i] != Replay::last[i]
+				: abs((int) state[i] - Replay::last[i]) >= REPLAY_AXIS_STEP))
+			mask |= _BV(i);
+	}
+
+	if(!mask)
+		return;
+
+	now = Timebase::now();
+	ticks = (now - Replay::last_time) / REPLAY_TICK_US;
+
+	if(ticks > REPLAY_DELAY_MAX)
+		ticks = REPLAY_DELAY_MAX;
+
+	sample[n++] = mask;
+
+	if(ticks < 0x80) {
+		sample[n++] = ticks;
+	} else {
+		sample[n++] = 0x80 | (ticks >> 8);
+		sample[n++] = ticks;
+	}
+
+	for(i = 0; i < REPLAY_FIELDS; i++) {
+		if(mask & _BV(i))
+			sample[n++] = state[i];
+	}
+
+	// EEPROM full, the recording ends here
+	if(Replay::accepted + n > REPLAY_SIZE) {
+		Replay::recording = false;
+		return;
+	}
+
+	// Ring full, drop it. The next change gets the time since the last kept one
+	if(((Replay::tail - Replay::head - 1) & (REPLAY_RING_SIZE - 1)) < n)
+		return;
+
+	if(ticks == REPLAY_DELAY_MAX)
+		Replay::last_time = now;
+	else // Keep the remainder, so rounding doesn't add up over the recording
+		Replay::last_time += ticks * REPLAY_TICK_US;
+
+	for(i = 0; i < n; i++) {
+		Replay::ring[Replay::head] = sample[i];
+		Replay::head = (Replay::head + 1) & (REPLAY_RING_SIZE - 1);
+	}
+
+	for(i = 0; i < REPLAY_FIELDS; i++) {
+		if(mask & _BV(i))
+			Replay::last[i] = state[i];
+	}
+
+	Replay::accepted += n;
+}
+
+/* Writes value at addr, skipping the write if it is already there */
+void Replay::write(unsigned int addr, byte value) {
+	uint8_t oldSREG = SREG;
+	cli();
+
+	EEAR = addr;
+	EECR |= _BV(EERE);
+
+	if(EEDR != value) {
+		EEDR = value;
+		EECR |= _BV(EEMPE);
+		EECR |= _BV(EEPE);
+	}
+
+	SREG = oldSREG;
+}
+
+/* Writes the next queued byte if the EEPROM is ready. Call from the pad loops */
+void Replay::service() {
+	if(EECR & _BV(EEPE))
+		return;
+
+	// Header first (pad, then length), length again once the ring is empty
+	if(Replay::header_pending) {
+		Replay::header_pending--;
+		Replay::write(REPLAY_BASE + Replay::header_pending,
+				((byte *) &Replay::header)[Replay::header_pending]);
+		return;
+	}
+
+	if(Replay::tail == Replay::head)
+		return;
+
+	Replay::write(REPLAY_DATA + Replay::stored++, Replay::ring[Replay::tail]);
+	Replay::tail = (Replay::tail + 1) & (REPLAY_RING_SIZE - 1);
+
+	// Only whole samples are queued, so they all are in now
+	if(Replay::tail == Replay::head) {
+		Replay::header.length = Replay::stored;
+		Replay::header_pending = sizeof(Replay::header.length);
+	}
+}
+
+#elif REPLAY == 2
+
+/* Reads the sample at addr into s, over the previous one. Returns the next sample's address */
+unsigned int Replay::decode(unsigned int addr, ReplaySample *s) {
+	byte mask = eeprom_read_byte((const uint8_t *) addr++);
+
+	s->delay = eeprom_read_byte((const uint8_t *) addr++);
+
+	if(s->delay & 0x80)
+		s->delay = ((s->delay & 0x7F) << 8) | eeprom_read_byte((const uint8_t *) addr++);
+
+	for(byte i = 0; i < REPLAY_FIELDS; i++) {
+		if(mask & _BV(i))
+			s->state[i] = eeprom_read_byte((const uint8_t *) addr++);
+	}
+
+	return addr;
+}
+
+/* Keeps answering the Wiimote until Timebase::now() reaches time */
+void Replay::wait_until(unsigned long time) {
+	while((long) (Timebase::now() - time) < 0)
+		WMExtension::service();
+}
+
+/* Sends s to the report path, as the pad loops would */
+void Replay::inject(const ReplaySample *s) {
+	byte b1 = s->state[0];
+	byte b2 = s->state[1];
+
+	WMExtension::set_button_data(b2 & 0x02, b1 & 0x80, b2 & 0x01, b1 & 0x40,
+			b2 & 0x10, b2 & 0x40, b2 & 0x08, b2 & 0x20, b1 & 0x20, b1 & 0x02,
+			b1 & 0x10, b1 & 0x04, b1 & 0x08, s->state[2], s->state[3], s->state[4],
+			s->state[5], b2 & 0x80, b2 & 0x04, s->state[6], s->state[7]);
+}
+
+/* Logs the report the last sample produced, see Replay.h */
+void Replay::trace_report() {
+	byte report[8];
+
+	Trace::event(TRACE_REPORT, WMExtension::get_report(report));
+
+	for(byte i = 0; i < 8; i++)
+		Trace::event(TRACE_REPORT, report[i]);
+}
+
+/* Replays the recording forever. Returns at once if there is none */
+void Replay::play() {
+	ReplayHeader h;
+	ReplaySample s;
+	unsigned long time;
+	unsigned int addr;
+	byte i;
+
+	eeprom_read_block(&h, (const void *) REPLAY_BASE, sizeof(ReplayHeader));
+
+	// Erased EEPROM reads 0xFF
+	if(!h.length || h.length > REPLAY_SIZE)
+		return;
+
+	for(;;) {
+		time = Timebase::now();
+
+		// The first sample sets every field, see Replay.h. i wraps, it only
+		// tells the samples apart in the trace
+		for(addr = REPLAY_DATA, i = 0; addr < REPLAY_DATA + h.length; i++) {
+			addr = Replay::decode(addr, &s);
+
+			time += (unsigned long) s.delay * REPLAY_TICK_US;
+			Replay::wait_until(time);
+
+			Trace::event(TRACE_REPLAY, i);
+			Replay::inject(&s);
+
+			if(TRACE)
+				Replay::trace_report();
+		}
+
+		Replay::wait_until(time + REPLAY_GAP_MS * 1000UL);
+
+		// Neutral state until the first sample of the next run
+		s.state[0] = s.state[1] = 0;
+		s.state[2] = s.state[3] = s.state[4] = s.state[5] = CAL_STICK_CENTER;
+		s.state[6] = s.state[7] = 0;
+
+		Replay::inject(&s);
+	}
+}
+
+#endif
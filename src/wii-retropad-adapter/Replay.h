@@ -0,0 +1,155 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Input record / replay (REPLAY = 1 or 2 in the Makefile)
+--------------------------------------------------------
+
+REPLAY = 1 records every change of the Classic Controller state (buttons,
+sticks, triggers, as given to WMExtension::set_button_data()) with the
+time since the previous change, from the moment the pad loop starts.
+Samples are delta coded (only what changed, see below) into a small RAM
+ring and written to EEPROM in the background, one byte per pad loop pass,
+like PadCache. Recording stops when the EEPROM area is full (REPLAY_SIZE,
+893 bytes on a 328p, 381 on a 168). A button press or release takes 3
+bytes, a stick move 3 or 4, the first sample 11: about 250 changes on a
+328p and 100 on a 168, for typical input. If the ring is full a change is
+dropped, and the next one is recorded with the time since the last sample
+kept.
+
+REPLAY = 2 skips pad detection and feeds the recording back through
+set_button_data() at the original times, forever. After each run the last
+state is held for REPLAY_GAP_MS, then the sticks and buttons go back to
+neutral and the next run starts. Without a recording the pad is used as
+usual.
+
+With TRACE = 1 each injected sample logs a TRACE_REPLAY event, so
+src/tools/wra-trace.cpp can measure sample to fetch latency on the same
+input across builds and pad types (record once per pad type, replay on
+each build).
+
+The resulting report (data format and registers 0x00-0x07) follows as
+TRACE_REPORT events. "wra-trace -r" lists them one line per sample, so
+the output of a known good build can be kept as a golden file and diffed
+against a new build replaying the same recording, with the Wiimote in
+either data format.
+
+Notes:
+ - Stick and trigger changes smaller than REPLAY_AXIS_STEP (below the
+   Classic Controller's 6 bit left stick) since the value last stored
+   aren't stored, and alone don't start a new sample, so stick noise
+   doesn't fill the ring.
+ - Gaps longer than REPLAY_DELAY_MAX * REPLAY_TICK_US (~2.1s) are
+   shortened to that.
+
+EEPROM layout, after the PadCache slots:
+
+      +--------+-----+-----------------------------------+
+      | length | pad | samples, length bytes             |
+      +--------+-----+-----------------------------------+
+
+Each sample is
+
+      +------+-------+--------------------------------+
+      | mask | delay | the fields set in mask, in order |
+      +------+-------+--------------------------------+
+
+mask bit i is set when ReplaySample::state[i] is stored, the others are
+as in the previous sample. The first sample has them all. delay is one
+byte below 0x80, else two, high byte first with bit 7 set. length is only
+updated when every queued sample is in EEPROM, so it always ends on a
+whole one.
+*/
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <WProgram.h>
+#include "PadCache.h"
+
+#ifndef REPLAY
+#define REPLAY 0
+#endif
+
+#define REPLAY_TICK_US		64
+#define REPLAY_RING_SIZE	64 // Bytes buffered in RAM, a power of two
+#define REPLAY_AXIS_STEP	4 // Smallest stick / trigger change recorded
+#define REPLAY_GAP_MS		1000
+
+#define REPLAY_FIELDS		8
+#define REPLAY_SAMPLE_MAX	(1 + 2 + REPLAY_FIELDS) // Longest coded sample
+#define REPLAY_DELAY_MAX	0x7FFF
+
+#define REPLAY_BASE			(PADCACHE_BASE + PADCACHE_SLOTS * PADCACHE_SLOT_SIZE)
+#define REPLAY_DATA			(REPLAY_BASE + sizeof(ReplayHeader))
+#define REPLAY_SIZE			(E2END + 1 - REPLAY_DATA)
+
+struct ReplayHeader {
+	unsigned int length; // Bytes of samples
+	byte pad; // detectPad() value of the recorded pad
+};
+
+struct ReplaySample {
+	unsigned int delay; // Since the previous sample, REPLAY_TICK_US units
+	byte state[REPLAY_FIELDS]; // Report bytes 4 and 5, not inverted (see set_button_data), lx, ly, rx, ry, lt, rt
+};
+
+class Replay {
+
+#if REPLAY == 1
+private:
+	static byte ring[REPLAY_RING_SIZE];
+	static byte head;
+	static byte tail;
+	static unsigned int stored; // Sample bytes already in EEPROM
+	static ReplayHeader header;
+	static byte header_pending; // Header bytes still to be written
+	static unsigned int accepted; // Sample bytes queued so far
+	static byte last[REPLAY_FIELDS];
+	static unsigned long last_time;
+	static bool recording;
+
+	static void write(unsigned int addr, byte value);
+
+public:
+	static void start(int pad);
+	static void record(byte b1, byte b2, byte lx, byte ly, byte rx, byte ry, byte lt, byte rt);
+	static void service();
+	static inline void play() { }
+#elif REPLAY == 2
+private:
+	static unsigned int decode(unsigned int addr, ReplaySample *s);
+	static void wait_until(unsigned long time);
+	static void inject(const ReplaySample *s);
+	static void trace_report();
+
+public:
+	static inline void start(int pad) { }
+	static inline void record(byte b1, byte b2, byte lx, byte ly, byte rx, byte ry, byte lt, byte rt) { }
+	static inline void service() { }
+	static void play();
+#else
+public:
+	static inline void start(int pad) { }
+	static inline void record(byte b1, byte b2, byte lx, byte ly, byte rx, byte ry, byte lt, byte rt) { }
+	static inline void service() { }
+	static inline void play() { }
+#endif
+};
+
+#endif /* REPLAY_H_ */
@@ -0,0 +1,184 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "Sniffer.h"
+#include "Timebase.h"
+
+#if SNIFFER
+
+SnifferRecord Sniffer::ring[SNIFFER_RING_SIZE];
+
+/* Next record to be written / sent. Ring is empty when both are equal */
+volatile byte Sniffer::head = 0;
+volatile byte Sniffer::tail = 0;
+
+/* Transactions lost since the last dump */
+byte Sniffer::dropped = 0;
+
+/* Transactions were lost since the last record */
+bool Sniffer::gap = false;
+
+/* The last record is a read still waiting for its length */
+bool Sniffer::open = false;
+
+/* Time the last record's delta counts up to */
+unsigned long Sniffer::last_time;
+
+/* Dump in progress: records in it, bytes sent so far (header included) */
+bool Sniffer::dumping = false;
+byte Sniffer::dump_count;
+unsigned int Sniffer::dump_pos;
+
+/* USART at SNIFFER_BAUD, RX interrupt requests a dump */
+void Sniffer::init() {
+	UBRR0 = (F_CPU / 8 / SNIFFER_BAUD) - 1;
+	UCSR0A = _BV(U2X0);
+	UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+	UCSR0B = _BV(TXEN0) | _BV(RXEN0) | _BV(RXCIE0);
+
+	Sniffer::last_time = Timebase::now();
+}
+
+/* Adds a record. Only called from the TWI ISR */
+void Sniffer::log(byte address, byte flags) {
+	unsigned long now = Timebase::now();
+	unsigned long ticks = (now - Sniffer::last_time) / SNIFFER_TICK_US;
+	byte h = Sniffer::head;
+	SnifferRecord *r;
+
+	Sniffer::open = false;
+
+	if(((h + 1) & (SNIFFER_RING_SIZE - 1)) == Sniffer::tail) {
+		if(Sniffer::dropped < 0xFF)
+			Sniffer::dropped++;
+
+		Sniffer::gap = true;
+		return;
+	}
+
+	// Keep the remainder, so deltas add up to the real time
+	if(ticks >= 0xFFFF) {
+		ticks = 0xFFFF;
+		Sniffer::last_time = now;
+	} else {
+		Sniffer::last_time += ticks * SNIFFER_TICK_US;
+	}
+
+	r = &Sniffer::ring[h];
+	r->delta = ticks;
+	r->address = address;
+	r->flags = flags | (Sniffer::gap ? SNIFFER_GAP : 0);
+
+	Sniffer::gap = false;
+	Sniffer::head = (h + 1) & (SNIFFER_RING_SIZE - 1);
+}
+
+/* Logs a write from the Wiimote, length 0 only sets the address */
+void Sniffer::write(byte address, byte length, bool crypt) {
+	if(length > SNIFFER_LENGTH)
+		length = SNIFFER_LENGTH;
+
+	Sniffer::log(address, SNIFFER_WRITE | (crypt ? SNIFFER_CRYPT : 0) | length);
+}
+
+/* Logs the start of a read, its length is filled in by read_done() */
+void Sniffer::read(byte address, bool crypt) {
+	byte h = Sniffer::head;
+
+	Sniffer::log(address, crypt ? SNIFFER_CRYPT : 0);
+
+	Sniffer::open = (Sniffer::head != h);
+}
+
+/* End of the slave transmission, sent bytes were clocked out */
+void Sniffer::read_done(byte sent) {
+	if(!Sniffer::open)
+		return;
+
+	if(sent > SNIFFER_LENGTH)
+		sent = SNIFFER_LENGTH;
+
+	Sniffer::ring[(Sniffer::head - 1) & (SNIFFER_RING_SIZE - 1)].flags |= sent;
+	Sniffer::open = false;
+}
+
+/* Starts a dump of the records logged so far, unless one is running */
+void Sniffer::request() {
+	if(Sniffer::dumping)
+		return;
+
+	Sniffer::dump_count = ((Sniffer::head - Sniffer::tail) & (SNIFFER_RING_SIZE - 1)) - (Sniffer::open ? 1 : 0);
+	Sniffer::dump_pos = 0;
+	Sniffer::dumping = true;
+
+	UCSR0B |= _BV(UDRIE0);
+}
+
+/* Sends the next byte of the dump, freeing each record once it is out */
+void Sniffer::drain() {
+	unsigned int pos = Sniffer::dump_pos;
+	byte t = Sniffer::tail;
+
+	if(pos >= 4 + (unsigned int) Sniffer::dump_count * 4) {
+		UCSR0B &= ~_BV(UDRIE0);
+		Sniffer::dumping = false;
+		return;
+	}
+
+	switch(pos) {
+	case 0:
+		UDR0 = 'W';
+		break;
+	case 1:
+		UDR0 = 'S';
+		break;
+	case 2:
+		UDR0 = Sniffer::dump_count;
+		break;
+	case 3:
+		UDR0 = Sniffer::dropped;
+		Sniffer::dropped = 0;
+		break;
+	default:
+		UDR0 = ((byte *)&Sniffer::ring[t])[pos & 3];
+
+		if((pos & 3) == 3)
+			Sniffer::tail = (t + 1) & (SNIFFER_RING_SIZE - 1);
+		break;
+	}
+
+	Sniffer::dump_pos = pos + 1;
+}
+
+extern "C" void sniffer_read_done(uint8_t sent) {
+	Sniffer::read_done(sent);
+}
+
+ISR(USART_RX_vect) {
+	byte c = UDR0;
+
+	(void)c;
+	Sniffer::request();
+}
+
+ISR(USART_UDRE_vect) {
+	Sniffer::drain();
+}
+
+#endif
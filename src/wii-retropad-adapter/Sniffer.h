@@ -0,0 +1,157 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+I2C transaction sniffer (SNIFFER = 1 in the Makefile)
+------------------------------------------------------
+
+Every transaction the Wiimote makes with the extension (register address
+writes, data writes and reads) is logged to a RAM ring from the TWI ISR.
+Any byte received on RX (PD0, Arduino pin 0) dumps the records logged so
+far on TX (PD1) and frees them. The serial line is SNIFFER_BAUD 8N1, as
+for Trace.h, so SNIFFER and TRACE can't be used together.
+
+Each record is 4 bytes:
+
+      +--------------+--------------+---------+-------+
+      | delta (low)  | delta (high) | address | flags |
+      +--------------+--------------+---------+-------+
+
+ - delta: time since the previous record in SNIFFER_TICK_US units, 0xFFFF
+   if it was longer than that (~2.1s).
+ - address: start register address.
+ - flags: SNIFFER_WRITE, SNIFFER_CRYPT (encryption on when the transaction
+   was handled), SNIFFER_GAP (transactions were lost right before this one,
+   the ring was full) and the length in the low 5 bits. A write of length
+   0 only sets the address for the next read. A read's length is the
+   number of bytes the Wiimote clocked out.
+
+A dump is a 4 byte header followed by count records, oldest first:
+
+      +-----+-----+-------+---------+
+      | 'W' | 'S' | count | dropped |
+      +-----+-----+-------+---------+
+
+dropped is the number of transactions lost since the previous dump (up to
+0xFF). A read still in progress is left for the next dump. Dumps are meant
+to be requested periodically and concatenated, delta carries over from one
+dump to the next:
+
+  stty -F /dev/ttyUSB0 250000 raw
+  cat /dev/ttyUSB0 > sniff.bin &
+  while sleep 0.05; do printf d > /dev/ttyUSB0; done
+
+src/tools/wra-sniff.cpp splits a capture into sessions and summarizes the
+poll intervals and access patterns of each one.
+
+The ring takes SNIFFER_RING_SIZE * 4 bytes of RAM (512 on a 328p, 128 on
+a 168p). A game polling at 1kHz makes ~2000 records per second, so dumps
+have to be requested every ~50ms (328p) to keep up.
+*/
+
+#ifndef SNIFFER_H_
+#define SNIFFER_H_
+
+#include <avr/io.h>
+#include <inttypes.h>
+
+#ifndef SNIFFER
+#define SNIFFER 0
+#endif
+
+#if SNIFFER && TRACE
+#error SNIFFER and TRACE both use the serial port
+#endif
+
+#define SNIFFER_BAUD		250000
+#define SNIFFER_TICK_US		32
+
+#if RAMEND > 0x4FF
+#define SNIFFER_RING_SIZE	128 // Records, power of two up to 128
+#else
+#define SNIFFER_RING_SIZE	32
+#endif
+
+// Record flags
+#define SNIFFER_WRITE		0x80
+#define SNIFFER_CRYPT		0x40
+#define SNIFFER_GAP			0x20
+#define SNIFFER_LENGTH		0x1F
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void sniffer_read_done(uint8_t sent);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* Hook for the end of a slave transmission in Wire/utility/twi.c */
+#if SNIFFER
+#define SNIFFER_READ_DONE(sent)	sniffer_read_done(sent)
+#else
+#define SNIFFER_READ_DONE(sent)
+#endif
+
+#ifdef __cplusplus
+
+#include <WProgram.h>
+
+struct SnifferRecord {
+	unsigned int delta;
+	byte address;
+	byte flags;
+};
+
+class Sniffer {
+
+#if SNIFFER
+private:
+	static SnifferRecord ring[SNIFFER_RING_SIZE];
+	static volatile byte head;
+	static volatile byte tail;
+	static byte dropped;
+	static bool gap;
+	static bool open;
+	static unsigned long last_time;
+	static bool dumping;
+	static byte dump_count;
+	static unsigned int dump_pos;
+
+	static void log(byte address, byte flags);
+
+public:
+	static void init();
+	static void write(byte address, byte length, bool crypt);
+	static void read(byte address, bool crypt);
+	static void read_done(byte sent);
+	static void request();
+	static void drain();
+#else
+public:
+	static inline void init() { }
+	static inline void write(byte address, byte length, bool crypt) { }
+	static inline void read(byte address, bool crypt) { }
+#endif
+};
+
+#endif
+
+#endif /* SNIFFER_H_ */
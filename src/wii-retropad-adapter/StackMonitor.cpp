@@ -0,0 +1,90 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "StackMonitor.h"
+#include "Trace.h"
+
+#if STACK_MONITOR
+
+// Linker symbols: end of .bss and top of the stack
+extern byte _end;
+extern byte __stack;
+
+/* Bytes above _end still holding the canary */
+unsigned int StackMonitor::unused = 0;
+
+/*
+ * Paints the gap between .bss and the stack. Runs from .init1, before the
+ * stack pointer and r1 are set up, so it can't be plain C.
+ */
+extern "C" void StackMonitor_paint(void) __attribute__((naked, used, section(".init1")));
+
+extern "C" void StackMonitor_paint(void) {
+	__asm__ __volatile__ (
+		"	ldi r30, lo8(_end)\n"
+		"	ldi r31, hi8(_end)\n"
+		"	ldi r24, %0\n"
+		"	ldi r25, hi8(__stack)\n"
+		"	rjmp 2f\n"
+		"1:	st Z+, r24\n"
+		"2:	cpi r30, lo8(__stack)\n"
+		"	cpc r31, r25\n"
+		"	brlo 1b\n"
+		"	breq 1b\n"
+		:: "M" (STACKMON_CANARY));
+}
+
+/* Takes the first (full) measurement, call once from setup() */
+void StackMonitor::init() {
+	byte *p = &_end;
+
+	while(p <= &__stack && *p == STACKMON_CANARY)
+		p++;
+
+	StackMonitor::unused = p - &_end;
+}
+
+/* Updates the high-water mark, logs a TRACE_STACK event on each new low */
+void StackMonitor::poll() {
+	unsigned int u = StackMonitor::unused;
+
+	if(!u || (&_end)[u - 1] == STACKMON_CANARY)
+		return;
+
+	while(u && (&_end)[u - 1] != STACKMON_CANARY)
+		u--;
+
+	StackMonitor::unused = u;
+
+	Trace::event(TRACE_STACK, (u >> 3) > 0xFF ? 0xFF : (u >> 3));
+}
+
+/* Stack bytes never used since reset (high-water mark headroom) */
+unsigned int StackMonitor::unused_stack() {
+	return StackMonitor::unused;
+}
+
+/* SRAM currently free between .bss and the stack pointer */
+unsigned int StackMonitor::free_ram() {
+	byte top;
+
+	return &top - &_end;
+}
+
+#endif
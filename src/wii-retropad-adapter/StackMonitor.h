@@ -0,0 +1,71 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Stack high-water mark (enabled with STACK_MONITOR = 1 in the Makefile)
+-----------------------------------------------------------------------
+
+Before main() (.init1), all SRAM between the end of .bss and the top of the
+stack is filled with STACKMON_CANARY. There is no heap, so every byte of
+that gap that no longer holds the canary has been used by the stack, by
+the main loop or by an ISR nested on top of it.
+
+      _end                                               RAMEND
+      +------------+-------------------------+-----------------+
+      | .data/.bss | canary (never used)     | stack, used     |
+      +------------+-------------------------+-----------------+
+                   |<-- unused_stack() ----->|
+
+poll() runs once per pad loop pass (pad_idle() in wra.cpp) and walks down
+from the last mark only, so it costs a few cycles unless the stack went
+deeper. Each new low is sent as a TRACE_STACK event when TRACE = 1.
+
+A used byte that happens to hold the canary value can make the mark one
+byte too optimistic until the stack reaches past it again.
+*/
+
+#ifndef STACKMONITOR_H_
+#define STACKMONITOR_H_
+
+#include <WProgram.h>
+
+#ifndef STACK_MONITOR
+#define STACK_MONITOR 0
+#endif
+
+#define STACKMON_CANARY 0xC5
+
+class StackMonitor {
+
+#if STACK_MONITOR
+private:
+	static unsigned int unused;
+
+public:
+	static void init();
+	static void poll();
+	static unsigned int unused_stack();
+	static unsigned int free_ram();
+#else
+public:
+	static inline void init() { }
+	static inline void poll() { }
+#endif
+};
+
+#endif /* STACKMONITOR_H_ */
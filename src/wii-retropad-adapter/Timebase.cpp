@@ -0,0 +1,116 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "Timebase.h"
+
+/* Timer1 overflows seen so far, upper half of now() */
+unsigned long Timebase::overflows = 0;
+
+/* TCNT1 when fast() was called */
+unsigned int Timebase::fast_base;
+
+/* Timer1 free running at clk/8 (clk/1 and the overflow interrupt with PROFILER), normal mode. Call first in setup() */
+void Timebase::init() {
+	uint8_t oldSREG = SREG;
+
+	cli();
+
+	TCCR1A = 0;
+	TCCR1B = TIMEBASE_CS;
+	TIMSK1 = PROFILER ? _BV(TOIE1) : 0;
+	TCNT1 = 0;
+	TIFR1 = _BV(TOV1);
+
+	Timebase::overflows = 0;
+
+#if TIMER0_OFF
+	TIMSK0 &= ~_BV(TOIE0);
+#endif
+
+	SREG = oldSREG;
+}
+
+/* Microseconds since init(). Safe to call from both the main loop and ISRs */
+unsigned long Timebase::now() {
+	uint8_t oldSREG = SREG;
+	unsigned int t;
+	unsigned long r;
+
+	cli();
+
+	t = TCNT1;
+
+	// Timer wrapped since the last call, count it (t may predate the wrap)
+	if(TIFR1 & _BV(TOV1)) {
+		TIFR1 = _BV(TOV1);
+		Timebase::overflows++;
+		t = TCNT1;
+	}
+
+	r = (Timebase::overflows << (16 - TIMEBASE_SHIFT)) | (t >> TIMEBASE_SHIFT);
+
+	SREG = oldSREG;
+
+	return r;
+}
+
+/* Counts an overflow now() has not seen, from TIMER1_OVF_vect */
+void Timebase::overflow() {
+	Timebase::overflows++;
+}
+
+#if PROFILER
+ISR(TIMER1_OVF_vect) {
+	Timebase::overflow();
+}
+#endif
+
+/* Timer1 at clk/1, counting from 0. Interrupts must be disabled until slow() */
+void Timebase::fast() {
+#if !PROFILER
+	TCCR1B = 0;
+
+	// Count a pending overflow first, it can't be told apart later
+	Timebase::now();
+
+	Timebase::fast_base = TCNT1;
+	TCNT1 = 0;
+	TCCR1B = _BV(CS10);
+#endif
+}
+
+/* Back to clk/8, TCNT1 moved on by the time spent at clk/1 (less than 8ms) */
+void Timebase::slow() {
+#if PROFILER
+	TIFR1 = _BV(ICF1);
+#else
+	unsigned int t;
+
+	TCCR1B = 0;
+
+	t = Timebase::fast_base + (TCNT1 >> 3);
+
+	if(t < Timebase::fast_base)
+		Timebase::overflows++;
+
+	TCNT1 = t;
+	TIFR1 = _BV(TOV1) | _BV(ICF1);
+	TCCR1B = _BV(CS11);
+#endif
+}
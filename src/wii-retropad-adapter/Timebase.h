@@ -0,0 +1,94 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Tickless timebase
+-----------------
+
+Timer1 runs free at clk/8 (1us per tick at 8MHz) with no interrupt. now()
+returns a 32 bit microsecond count. The upper 16 bits are an overflow
+count, extended on demand from the TOV1 flag, so now() must be called at
+least once per Timer1 period (65.5ms). WMExtension::service() does it on
+every pass of every pad loop and of the pad init retry loops, PS2Pad::init()
+on every configuration try.
+
+With TIMER0_OFF = 1 in the Makefile the Arduino timer0 overflow interrupt
+(millis() bookkeeping) is disabled as well. It fires every 2.048ms, landing
+in the middle of the bit-banged PS2, Genesis and Saturn timing and delaying
+TWI service by as long as it runs. That is estimated at 100-150 cycles with
+its prologue / epilogue from the wiring.c source. Neither that load nor
+the jitter it adds to the pad timing has been measured, with or without
+TIMER0_OFF. To get them, build with PROFILER: slot PROF_TIMER0 gives the
+body in cycles, the interrupted counts of PROF_PS2 and PROF_PAD_READ how
+often it landed in a read, and PROFILER = 2 puts it on A1 for a scope
+next to the pad lines. Once it is off,
+millis(), micros() and delay() no longer advance; delayMicroseconds()
+is unaffected. Use Timebase::now() instead.
+
+fast() / slow() switch Timer1 to clk/1 and back for cycle exact input
+capture (JoybusTiming.h), with interrupts disabled. The time spent at
+clk/1 is added back to the count when it returns to clk/8.
+
+PROFILER builds run Timer1 at clk/1 all the time, so the profiler slots
+(Profiler.h) count CPU cycles. now() still returns microseconds, but the
+timer wraps every 8.2ms then, more often than the pad loops call now(),
+so TIMER1_OVF_vect is enabled to count the overflows too (a few cycles
+every 8.2ms, in those builds only). fast() and slow() leave the timer
+running as it is: it is at clk/1 already, and the slots around a capture
+stay right.
+*/
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include <WProgram.h>
+
+#ifndef TIMER0_OFF
+#define TIMER0_OFF 0
+#endif
+
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#define TIMEBASE_TICK_US 1
+
+// Timer1 prescaler and ticks per microsecond (log2), at 8MHz
+#if PROFILER
+#define TIMEBASE_CS		_BV(CS10)
+#define TIMEBASE_SHIFT	3
+#else
+#define TIMEBASE_CS		_BV(CS11)
+#define TIMEBASE_SHIFT	0
+#endif
+
+class Timebase {
+
+private:
+	static unsigned long overflows;
+	static unsigned int fast_base;
+
+public:
+	static void init();
+	static unsigned long now();
+	static void overflow();
+	static void fast();
+	static void slow();
+};
+
+#endif /* TIMEBASE_H_ */
@@ -0,0 +1,123 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "Trace.h"
+#include "WMExtension.h"
+#include "Timebase.h"
+
+#if TRACE
+
+byte Trace::buffer[TRACE_BUFFER_SIZE];
+
+/* Next byte to be written / sent. Ring is empty when both are equal */
+volatile byte Trace::head = 0;
+volatile byte Trace::tail = 0;
+
+/* Events lost since the last TRACE_DROPPED event */
+byte Trace::dropped = 0;
+
+/* WMExtension fetch counter on the last TRACE_PAD_SAMPLE */
+byte Trace::last_fetch = 0;
+
+/* pad_sample() calls seen, up to 2 (the first is before the pad loop's first report) */
+byte Trace::samples = 0;
+
+/* USART at TRACE_BAUD, transmitter only */
+void Trace::init() {
+	UBRR0 = (F_CPU / 8 / TRACE_BAUD) - 1;
+	UCSR0A = _BV(U2X0);
+	UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+	UCSR0B = _BV(TXEN0);
+}
+
+/* Queues one event record. Interrupts must be disabled */
+void Trace::put(byte type, byte arg, unsigned int time) {
+	byte h = Trace::head;
+
+	Trace::buffer[h] = type;
+	Trace::buffer[h + 1] = arg;
+	Trace::buffer[h + 2] = time & 0xFF;
+	Trace::buffer[h + 3] = time >> 8;
+
+	Trace::head = (h + 4) & (TRACE_BUFFER_SIZE - 1);
+}
+
+/* Logs an event. Safe to call from both the main loop and ISRs */
+void Trace::event(byte type, byte arg) {
+	unsigned int time = Timebase::now() / (TRACE_TICK_US / TIMEBASE_TICK_US);
+	uint8_t oldSREG = SREG;
+	byte room;
+
+	cli();
+
+	room = (Trace::tail - Trace::head - 1) & (TRACE_BUFFER_SIZE - 1);
+
+	if(room < (Trace::dropped ? 8 : 4)) {
+		if(Trace::dropped < 0xFF)
+			Trace::dropped++;
+	} else {
+		if(Trace::dropped) {
+			Trace::put(TRACE_DROPPED, Trace::dropped, time);
+			Trace::dropped = 0;
+		}
+
+		Trace::put(type, arg, time);
+
+		// Let the data register empty interrupt send it
+		UCSR0B |= _BV(UDRIE0);
+	}
+
+	SREG = oldSREG;
+}
+
+/*
+ * Logs TRACE_PAD_SAMPLE for the first pad loop pass after each report fetch,
+ * and TRACE_BOOT_PAD once the pad driver has sent its first report. Called
+ * from pad_idle() in wra.cpp.
+ */
+void Trace::pad_sample() {
+	byte fetch = WMExtension::get_fetch_count();
+
+	if(Trace::samples < 2 && ++Trace::samples == 2)
+		Trace::event(TRACE_BOOT, TRACE_BOOT_PAD);
+
+	if(fetch != Trace::last_fetch) {
+		Trace::last_fetch = fetch;
+		Trace::event(TRACE_PAD_SAMPLE, 0);
+	}
+}
+
+/* Sends the next queued byte, stops the interrupt once the ring is empty */
+void Trace::drain() {
+	byte t = Trace::tail;
+
+	if(t == Trace::head) {
+		UCSR0B &= ~_BV(UDRIE0);
+		return;
+	}
+
+	UDR0 = Trace::buffer[t];
+	Trace::tail = (t + 1) & (TRACE_BUFFER_SIZE - 1);
+}
+
+ISR(USART_UDRE_vect) {
+	Trace::drain();
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Binary event trace over the USART (enabled with TRACE = 1 in the Makefile)
+---------------------------------------------------------------------------
+
+Events are queued in a RAM ring and sent by the USART data register empty
+interrupt, so logging never waits on the serial line. When the ring is full
+events are dropped and a TRACE_DROPPED event with the count is sent once
+there is room again.
+
+TX is on PD1 (Arduino pin 1), 250000 baud (exact at 8MHz), 8N1.
+
+Each event is 4 bytes:
+
+      +------+-----+--------------+--------------+
+      | type | arg | time (low)   | time (high)  |
+      +------+-----+--------------+--------------+
+
+time is a 16 bit timestamp in TRACE_TICK_US units, it wraps around every
+~0.5s. Use src/tools/wra-trace.cpp to decode a capture.
+
+Boot times (TRACE_BOOT) count from setup(). The reset start-up delay
+(SUT fuse bits), the C runtime and the core's init() come before that.
+Boot-to-first-ACK from power up was not measured. To measure it, put a
+logic analyzer on VCC and SDA / SCL and take the time from power up to
+the first ACK of address 0x52. No boot figure from a board exists yet.
+*/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <WProgram.h>
+
+#ifndef TRACE
+#define TRACE 0
+#endif
+
+#define TRACE_BAUD			250000
+#define TRACE_BUFFER_SIZE	64 // Power of two, 4 bytes per event
+#define TRACE_TICK_US		8
+
+// Event types (arg meaning in parenthesis)
+#define TRACE_PAD_SAMPLE	0x01 // First pad sample after a fetch (0)
+#define TRACE_READ			0x02 // Wiimote read, plain (address)
+#define TRACE_READ_CRYPT	0x03 // Wiimote read, encrypted (address)
+#define TRACE_WRITE			0x04 // Wiimote write (start address)
+#define TRACE_KEY_SETUP		0x05 // Encryption key generated (0)
+#define TRACE_TIMEOUT		0x06 // Pad didn't answer (command)
+#define TRACE_DRIVER		0x07 // Pad loop started (detectPad() value)
+#define TRACE_DROPPED		0x08 // Events lost, ring was full (count)
+#define TRACE_STACK			0x09 // New stack low, see StackMonitor.h (unused bytes / 8)
+#define TRACE_BOOT			0x0A // Boot milestone (TRACE_BOOT_xxx), time 0 is setup()
+#define TRACE_REPLAY		0x0B // Recorded sample injected, see Replay.h (sample index)
+#define TRACE_REPORT		0x0C // Report after a replayed sample, 9 in a row (format, then registers 0-7)
+#define TRACE_JOYBUS		0x0D // GameCube bit timing, 11 in a row (see JoybusTiming::report())
+#define TRACE_ARENA			0x0E // Driver used an arena member it doesn't own, see Arena.h (owner << 4 | member)
+
+#define TRACE_BOOT_I2C		0x00 // Answering on 0x52 with the neutral report
+#define TRACE_BOOT_PAD		0x01 // First report from the pad driver
+
+class Trace {
+
+#if TRACE
+private:
+	static byte buffer[TRACE_BUFFER_SIZE];
+	static volatile byte head;
+	static volatile byte tail;
+	static byte dropped;
+	static byte last_fetch;
+	static byte samples;
+
+	static void put(byte type, byte arg, unsigned int time);
+
+public:
+	static void init();
+	static void event(byte type, byte arg);
+	static void pad_sample();
+	static void drain();
+#else
+public:
+	static inline void init() { }
+	static inline void event(byte type, byte arg) { }
+	static inline void pad_sample() { }
+#endif
+};
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,90 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "Turbo.h"
+
+#if TURBO
+
+const byte Turbo::half_period[TURBO_RATES] = { TURBO_RATE_FAST,
+		TURBO_RATE_MEDIUM, TURBO_RATE_SLOW };
+
+/* Fetches left until each rate flips its phase */
+byte Turbo::counter[TURBO_RATES] = { 0, 0, 0 };
+
+/* Bit r set: buttons on rate r are currently let through */
+byte Turbo::phase = 0;
+
+/* Buttons assigned to each rate (report bytes, 1 == turbo on) */
+byte Turbo::buttons[TURBO_RATES][2];
+
+/* Buttons pressed on the previous fetch, for hotkey edge detection */
+byte Turbo::held[2] = { 0, 0 };
+
+/* Moves each button in bits (report byte n) to the next rate, or off */
+void Turbo::cycle(byte n, byte bits) {
+	byte moving, r;
+
+	for(r = TURBO_RATES; r > 0; r--) {
+		moving = Turbo::buttons[r - 1][n] & bits;
+
+		Turbo::buttons[r - 1][n] &= ~moving;
+
+		if(r < TURBO_RATES)
+			Turbo::buttons[r][n] |= moving;
+
+		bits &= ~moving;
+	}
+
+	// Buttons that had no turbo go to the fastest rate
+	Turbo::buttons[0][n] |= bits;
+}
+
+/*
+ * Called from the TWI ISR when the Wiimote fetches the report. report points
+ * to the two (inverted) button bytes about to be sent, turbo buttons in
+ * their off phase are forced released there.
+ */
+void Turbo::apply(byte *report) {
+	byte pressed0 = ~report[0];
+	byte pressed1 = ~report[1];
+
+	if((pressed0 & TURBO_HOTKEY0) == TURBO_HOTKEY0) {
+		Turbo::cycle(0, pressed0 & ~Turbo::held[0] & TURBO_BUTTONS0);
+		Turbo::cycle(1, pressed1 & ~Turbo::held[1] & TURBO_BUTTONS1);
+	}
+
+	Turbo::held[0] = pressed0;
+	Turbo::held[1] = pressed1;
+
+	for(byte r = 0; r < TURBO_RATES; r++) {
+		if(Turbo::counter[r] == 0) {
+			Turbo::counter[r] = Turbo::half_period[r];
+			Turbo::phase ^= (1 << r);
+		}
+
+		Turbo::counter[r]--;
+
+		if(!(Turbo::phase & (1 << r))) {
+			report[0] |= Turbo::buttons[r][0];
+			report[1] |= Turbo::buttons[r][1];
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,68 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Turbo / autofire (enabled with TURBO = 1 in the Makefile)
+----------------------------------------------------------
+
+Hold DOWN + START (PLUS) and press A, B, X, Y, L, R, ZL or ZR to cycle that
+button through: off -> fast -> medium -> slow -> off.
+
+Nothing runs in the pad loops. The turbo phase is clocked by the Wiimote
+report fetches themselves (the TWI ISR, see WMExtension::handle_request),
+so every on/off state lasts a whole number of reports and is never lost
+between two polls. Turbo buttons are masked in the outgoing report only,
+the registers keep the real pad state.
+*/
+
+#ifndef TURBO_H_
+#define TURBO_H_
+
+#include <WProgram.h>
+
+#ifndef TURBO
+#define TURBO 0
+#endif
+
+// Half period of each turbo rate, in Wiimote report fetches
+#define TURBO_RATE_FAST		2
+#define TURBO_RATE_MEDIUM	4
+#define TURBO_RATE_SLOW		8
+#define TURBO_RATES			3
+
+// Hotkey (DOWN + PLUS) and turbo capable buttons, report byte 0 / byte 1
+#define TURBO_HOTKEY0	0x44
+#define TURBO_BUTTONS0	0x22 // L, R
+#define TURBO_BUTTONS1	0xFC // ZL, B, Y, A, X, ZR
+
+class Turbo {
+
+private:
+	static const byte half_period[TURBO_RATES];
+	static byte counter[TURBO_RATES];
+	static byte phase;
+	static byte buttons[TURBO_RATES][2];
+	static byte held[2];
+
+	static void cycle(byte n, byte bits);
+
+public:
+	static void apply(byte *report);
+};
+
+#endif /* TURBO_H_ */
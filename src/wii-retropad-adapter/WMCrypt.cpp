@@ -244,8 +244,8 @@ void WMCrypt::gentabs(const unsigned char* const rand, const unsigned char* cons
         sb[7] = pgm_read_byte(&WMCrypt::sboxes[idx][rand[2]]) ^ pgm_read_byte(&WMCrypt::sboxes[(idx+1)%8][rand[6]]);
 }
 
-/* Generate key from the 0x40-0x4c data in g_RegExt */
-void WMCrypt::wiimote_gen_key(const unsigned char* const keydata)
+/* Generate key from the 0x40-0x4c data in g_RegExt, tables go to ft and sb */
+void WMCrypt::wiimote_gen_key(const unsigned char* const keydata, unsigned char* const ft, unsigned char* const sb)
 {
         unsigned char rand[10];
         unsigned char skey[6];
@@ -266,7 +266,7 @@ void WMCrypt::wiimote_gen_key(const unsigned char* const keydata)
         }
         // default case is idx = 7 which is valid (homebrew uses it for the 0x17 case)
 
-        gentabs(rand, skey, idx, WMCrypt::wm_ft, WMCrypt::wm_sb);
+        gentabs(rand, skey, idx, ft, sb);
 
         // for homebrew, ft and sb are all 0x97 which is equivalent to 0x17
 }
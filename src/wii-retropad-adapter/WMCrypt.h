@@ -27,7 +27,7 @@ class WMCrypt {
 public:
 	static unsigned char wm_ft[8];
 	static unsigned char wm_sb[8];
-	static void wiimote_gen_key(const unsigned char* const keydata);
+	static void wiimote_gen_key(const unsigned char* const keydata, unsigned char* const ft, unsigned char* const sb);
 
 private:
 	static const unsigned char ans_tbl[7][6] PROGMEM;
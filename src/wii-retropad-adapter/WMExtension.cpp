@@ -23,16 +23,27 @@
 #include <Wire.h>
 #include "WMExtension.h"
 #include "WMCrypt.h"
+#include "WMReport.h"
+#include "Turbo.h"
+#include "Trace.h"
+#include "Timebase.h"
+#include "Replay.h"
+#include "Profiler.h"
+#include "Sniffer.h"
 
 /* Classic Controller ID */
-const byte WMExtension::id[6] = { 0x00, 0x00, 0xa4, 0x20, 0x01, 0x01 };
+const byte WMExtension::id[6] PROGMEM = { 0x00, 0x00, 0xa4, 0x20, 0x01, 0x01 };
 
 /*
- *  Classic Controller Calibration Data.
- * Last two bytes (checksum) will be calculated by the init() function
+ *  Classic Controller Calibration Data (max, min, center for LX, LY, RX, RY,
+ *  then LT and RT). Last two bytes are the checksum, computed at compile time.
   */
-byte WMExtension::calibration_data[16] = { 0xF8, 0x04, 0x7A, 0xF8, 0x04,
-		0x7A, 0xF8, 0x04, 0x7A, 0xF8, 0x04, 0x7A, 0x00, 0x00, 0x00, 0x00 };
+#define CAL_SUM				((4 * (CAL_STICK_MAX + CAL_STICK_MIN + CAL_STICK_CENTER)) & 0xFF)
+
+const byte WMExtension::calibration_data[16] PROGMEM = { CAL_STICK_MAX, CAL_STICK_MIN,
+		CAL_STICK_CENTER, CAL_STICK_MAX, CAL_STICK_MIN, CAL_STICK_CENTER, CAL_STICK_MAX,
+		CAL_STICK_MIN, CAL_STICK_CENTER, CAL_STICK_MAX, CAL_STICK_MIN, CAL_STICK_CENTER,
+		0x00, 0x00, (CAL_SUM + 0x55) & 0xFF, (CAL_SUM + 0xAA) & 0xFF };
 
 /* Address requested by the I2C Master Device (i.e., the Wiimote) */
 volatile byte WMExtension::address = 0;
@@ -40,8 +51,89 @@ volatile byte WMExtension::address = 0;
 /* Tells whether encryption was setup (enabled) or not */
 volatile byte WMExtension::crypt_setup_done = 0;
 
-/* Classic Controller 256 data registers */
-byte WMExtension::registers[0x100];
+/*
+ * Buttons pressed since the last time the Wiimote fetched the report at
+ * address 0x00 (same bit layout as the non-inverted report button bytes).
+ * Taps shorter than the Wiimote poll interval are kept here until sent.
+ * TAP_LATCH = 0 leaves it out, only for the wra-tap-test baseline (the
+ * taps the adapter dropped without it).
+ */
+#ifndef TAP_LATCH
+#define TAP_LATCH	1
+#endif
+
+volatile byte WMExtension::latched_buttons[2] = { 0, 0 };
+
+/*
+ * Buttons held in the last set_report() call, without the latched ones.
+ * What the report goes back to once a fetch has sent the latched presses.
+ */
+volatile byte WMExtension::held_buttons[2] = { 0, 0 };
+
+/*
+ * Encryption key setup state. Key generation (up to 7 genkey passes plus
+ * gentabs, see PROF_GEN_KEY or wra-bench -k for the cycles) is too long to
+ * run inside the TWI ISR, so receive_bytes() only flags it (KEY_PENDING)
+ * and service() does it from the main loop (KEY_BUSY while running). Until
+ * then hold_request() holds Wiimote reads and data writes with SCL low, the
+ * Wiimote waits instead of getting data with the wrong key: up to the next
+ * service() call (one pad loop pass, Power::idle() calls it on wake up) plus
+ * the key generation. A write disabling encryption isn't held, it drops the
+ * pending key.
+ */
+#define KEY_IDLE	0
+#define KEY_PENDING	1
+#define KEY_BUSY	2
+
+volatile byte WMExtension::key_state = KEY_IDLE;
+
+/* Number of report fetches (reads from 0x00) so far, wraps around */
+volatile byte WMExtension::fetch_count = 0;
+
+/*
+ * Classic Controller data registers. Only a few of the 256 registers can
+ * change, so only those take SRAM (44 bytes instead of 256):
+ *
+ * 0x00 - 0x14: report (8 bytes) followed by zeros, up to 21 bytes are read
+ * 0x20 - 0x3F: calibration data, twice, constant (flash)
+ * 0x40 - 0x4F: encryption key, written by the Wiimote
+ * 0xF0:        encryption enable/disable, written by the Wiimote
+ * 0xFA - 0xFF: extension ID, 0xFB and 0xFE (data format) are written
+ *
+ * Everything else reads as 0x00 and ignores writes. Use read_register() and
+ * write_register() for random access.
+ */
+#define REPORT_REGS_SIZE	0x15
+#define REG_FORMAT			(WMExtension::id_regs[0xFE - 0xFA])
+
+byte WMExtension::report_regs[REPORT_REGS_SIZE];
+byte WMExtension::key_regs[16];
+byte WMExtension::id_regs[6];
+byte WMExtension::enable_reg = 0;
+
+/*
+ * Readable register windows, kept encrypted with the current key so reads
+ * there are plain copies in the TWI ISR (see mirror_at()):
+ *
+ * 0x00 - 0x14: report, up to 21 bytes read from 0x00
+ * 0x20 - 0x44: calibration data and its copy, 21 bytes read from 0x20 or 0x30
+ * 0xFA - 0xFF: extension ID (and data format byte at 0xFE)
+ *
+ * Costs 64 bytes of SRAM. Only used while crypt_setup_done and mirror_valid
+ * are set: service() rebuilds it a byte at a time with interrupts on, reads
+ * meanwhile are encrypted on the fly.
+ */
+#define MIRROR_REPORT_END	0x15
+#define MIRROR_CALIB_START	0x20
+#define MIRROR_CALIB_END	0x45
+#define MIRROR_ID_START		0xFA
+
+#define MIRROR_CALIB_OFFSET	(MIRROR_REPORT_END)
+#define MIRROR_ID_OFFSET	(MIRROR_CALIB_OFFSET + MIRROR_CALIB_END - MIRROR_CALIB_START)
+#define MIRROR_SIZE			(MIRROR_ID_OFFSET + 0x100 - MIRROR_ID_START)
+
+byte WMExtension::mirror[MIRROR_SIZE];
+volatile byte WMExtension::mirror_valid = 0;
 
 /*
  * Callback function pointer that will be called after the Wiimote has requested
@@ -70,26 +162,126 @@ void WMExtension::set_button_data_callback(CBackPtr cb) {
 /* Returns 1 of the 16 possible bytes from the calibration data array */
 byte WMExtension::get_calibration_byte(int b) {
 	if(b >= 0 && b <= 15)
-		return WMExtension::calibration_data[b];
+		return pgm_read_byte(&WMExtension::calibration_data[b]);
 	else
 		return 0;
 }
 
+/* Returns how many reports the Wiimote fetched so far (wraps around) */
+byte WMExtension::get_fetch_count() {
+	return WMExtension::fetch_count;
+}
+
+/* Data format the Wiimote asked for (0xFE) */
+byte WMExtension::get_format() {
+	return REG_FORMAT;
+}
+
+/* Copies registers 0x00-0x07 (the report) to report, returns the data format (0xFE) */
+byte WMExtension::get_report(byte *report) {
+	memcpy(report, WMExtension::report_regs, 8);
+	return REG_FORMAT;
+}
+
+/* Returns the value of any of the 256 registers */
+byte WMExtension::read_register(byte addr) {
+	if(addr < REPORT_REGS_SIZE)
+		return WMExtension::report_regs[addr];
+
+	if(addr >= 0x20 && addr < 0x40)
+		return pgm_read_byte(&WMExtension::calibration_data[addr & 0x0F]);
+
+	if(addr >= 0x40 && addr < 0x50)
+		return WMExtension::key_regs[addr - 0x40];
+
+	if(addr >= 0xFA)
+		return WMExtension::id_regs[addr - 0xFA];
+
+	if(addr == 0xF0)
+		return WMExtension::enable_reg;
+
+	return 0x00;
+}
+
+/* Writes any of the 256 registers, constant ones ignore it */
+void WMExtension::write_register(byte addr, byte data) {
+	if(addr < REPORT_REGS_SIZE)
+		WMExtension::report_regs[addr] = data;
+	else if(addr >= 0x40 && addr < 0x50)
+		WMExtension::key_regs[addr - 0x40] = data;
+	else if(addr >= 0xFA)
+		WMExtension::id_regs[addr - 0xFA] = data;
+	else if(addr == 0xF0)
+		WMExtension::enable_reg = data;
+}
+
 /*
- * Setup Wiimote <-> Extension I2C communication encryption, if requested by
- * the application (game/homebrew).
+ * Returns where length bytes starting at addr are in the encrypted mirror,
+ * or NULL if they are not all inside one mirrored window.
  */
-void WMExtension::setup_encryption() {
-	WMCrypt::wiimote_gen_key(WMExtension::registers + 0x40);
+byte *WMExtension::mirror_at(byte addr, byte length) {
+	int end = addr + length;
 
-	WMExtension::crypt_setup_done = 1;
+	if(end <= MIRROR_REPORT_END)
+		return WMExtension::mirror + addr;
+
+	if(addr >= MIRROR_CALIB_START && end <= MIRROR_CALIB_END)
+		return WMExtension::mirror + MIRROR_CALIB_OFFSET + (addr - MIRROR_CALIB_START);
+
+	if(addr >= MIRROR_ID_START)
+		return WMExtension::mirror + MIRROR_ID_OFFSET + (addr - MIRROR_ID_START);
+
+	return NULL;
 }
 
 /*
- * Send 8 bytes data via Wire.send().
+ * Re-encrypts count registers from addr into the mirror, all in one go. They
+ * must be in one mirrored window. Call with interrupts off.
+ */
+void WMExtension::mirror_encrypt(byte addr, byte count) {
+	byte *m = WMExtension::mirror_at(addr, count);
+
+	if(!m || !WMExtension::crypt_setup_done)
+		return;
+
+	do {
+		*m++ = (WMExtension::read_register(addr) - WMCrypt::wm_ft[addr % 8]) ^ WMCrypt::wm_sb[addr % 8];
+		addr++;
+	} while(--count);
+}
+
+/*
+ * Re-encrypts count registers from addr into the mirror (if mirrored). Each
+ * byte is done with interrupts off, the ISR may read it or change the key
+ * between two of them.
+ */
+void WMExtension::mirror_update(byte addr, byte count) {
+	uint8_t oldSREG = SREG;
+
+	do {
+		cli();
+		WMExtension::mirror_encrypt(addr, 1);
+		SREG = oldSREG;
+
+		addr++;
+	} while(--count);
+}
+
+/*
+ * Re-encrypts all mirrored windows, after a key change. Doesn't set
+ * mirror_valid, the caller does once it's done.
+ */
+void WMExtension::mirror_rebuild() {
+	WMExtension::mirror_update(0x00, MIRROR_REPORT_END);
+	WMExtension::mirror_update(MIRROR_CALIB_START, MIRROR_CALIB_END - MIRROR_CALIB_START);
+	WMExtension::mirror_update(MIRROR_ID_START, 0x100 - MIRROR_ID_START);
+}
+
+/*
+ * Send up to 21 bytes from register addr on via Wire.send().
  * Supports Wiimote encryption, if enabled.
   */
-void WMExtension::send_data(uint8_t* data, uint8_t addr) {
+void WMExtension::send_data(uint8_t addr) {
 	static uint8_t buffer[21];
 	int i, lim;
 
@@ -100,13 +292,29 @@ void WMExtension::send_data(uint8_t* data, uint8_t addr) {
 	}
 
 	if (WMExtension::crypt_setup_done) {
+		uint8_t *m = WMExtension::mirror_valid ? WMExtension::mirror_at(addr, lim) : NULL;
+
+		// Pre-encrypted, no need to do it here
+		if(m) {
+			Wire.send(m, lim);
+			return;
+		}
+
 		for (i = 0; i < lim; i++) {
-			buffer[i] = (data[i] - WMCrypt::wm_ft[(addr + i) % 8]) ^ WMCrypt::wm_sb[(addr + i) % 8];
+			buffer[i] = (WMExtension::read_register(addr + i) - WMCrypt::wm_ft[(addr + i) % 8]) ^ WMCrypt::wm_sb[(addr + i) % 8];
 		}
 
 		Wire.send(buffer, lim);
+	} else if(addr + lim <= REPORT_REGS_SIZE) {
+		Wire.send(WMExtension::report_regs + addr, lim);
+	} else if(addr >= 0xFA) {
+		Wire.send(WMExtension::id_regs + (addr - 0xFA), lim);
 	} else {
-		Wire.send(data, lim);
+		for (i = 0; i < lim; i++) {
+			buffer[i] = WMExtension::read_register(addr + i);
+		}
+
+		Wire.send(buffer, lim);
 	}
 }
 
@@ -115,37 +323,50 @@ void WMExtension::receive_bytes(int count) {
 	byte crypt_keys_received = 0;
 	byte old_crypt_key_received = 0;
 
+	PROFILER_ENTER(PROF_RECEIVE);
+
 	if (count == 1) {
 
 		WMExtension::address = Wire.receive();
 
+		Sniffer::write(WMExtension::address, 0, WMExtension::crypt_setup_done);
+
+		PROFILER_EXIT(PROF_RECEIVE);
 		return;
 
 	} else if (count > 1) {
 
 		byte addr = Wire.receive();
 
+		Trace::event(TRACE_WRITE, addr);
+
+		Sniffer::write(addr, count - 1, WMExtension::crypt_setup_done);
+
 		for (int i = 1; i < count; i++) {
 			byte d = Wire.receive();
 
 			// Wii is trying to disable encryption...
 			if(addr == 0xF0 && (d == 0x55 || d == 0xAA)) {
 				WMExtension::crypt_setup_done = 0;
+				WMExtension::key_state = KEY_IDLE;
 			}
 
-			// Wii is probably trying to setup old encryption mode
-			if(addr == 0x40 && d == 0x00) {
+			// Wii is probably trying to setup old encryption mode. That's a
+			// single 0x00 written to 0x40, a 16 byte key may start with 0x00 too
+			if(addr == 0x40 && d == 0x00 && count == 2) {
 				old_crypt_key_received = 1;
 			}
 
 			if (WMExtension::crypt_setup_done) {
 				// Decrypt
-				WMExtension::registers[addr] = (d ^ WMCrypt::wm_sb[addr % 8]) + WMCrypt::wm_ft[addr
-						% 8];
+				WMExtension::write_register(addr, (d ^ WMCrypt::wm_sb[addr % 8]) + WMCrypt::wm_ft[addr
+						% 8]);
 			} else {
-				WMExtension::registers[addr] = d;
+				WMExtension::write_register(addr, d);
 			}
 
+			WMExtension::mirror_update(addr, 1);
+
 			// Check if last crypt key setup byte was received...
 			if (addr == 0x4F) {
 				crypt_keys_received = 1;
@@ -160,21 +381,134 @@ void WMExtension::receive_bytes(int count) {
 	if (crypt_keys_received || old_crypt_key_received) {
 
 		if(old_crypt_key_received)
-			memset(WMExtension::registers + 0x40, 0x00, 16);
+			memset(WMExtension::key_regs, 0x00, 16);
 
-		WMExtension::setup_encryption();
+		WMExtension::key_state = KEY_PENDING;
 	}
+
+	PROFILER_EXIT(PROF_RECEIVE);
+}
+
+/*
+ * TWI hold callback (see key_state): holds a read or a data write (count
+ * bytes, register address first) while a new key isn't set up yet. Setting
+ * the address needs no key, disabling encryption drops it.
+ */
+uint8_t WMExtension::hold_request(uint8_t *data, int count) {
+	if(WMExtension::key_state == KEY_IDLE || count == 1)
+		return 0;
+
+	return !(count > 1 && data[0] == 0xF0 && (data[1] == 0x55 || data[1] == 0xAA));
+}
+
+/*
+ * Runs the encryption key setup requested by the Wiimote outside of the TWI
+ * ISR, then lets the transfer held meanwhile go on. Pad loops call it
+ * (through pad_idle() in wra.cpp) on every iteration, so it also keeps the
+ * tickless timebase from missing a Timer1 overflow.
+ */
+void WMExtension::service() {
+	byte key[16], ft[8], sb[8];
+	uint8_t oldSREG;
+
+	Timebase::now();
+
+	if(WMExtension::key_state != KEY_PENDING)
+		return;
+
+	oldSREG = SREG;
+	cli();
+
+	// Work on a copy, the Wiimote may write a new key in the meantime
+	memcpy(key, WMExtension::key_regs, 16);
+	WMExtension::key_state = KEY_BUSY;
+
+	SREG = oldSREG;
+
+	PROFILER_ENTER(PROF_GEN_KEY);
+	WMCrypt::wiimote_gen_key(key, ft, sb);
+	PROFILER_EXIT(PROF_GEN_KEY);
+
+	cli();
+
+	// Only install it if encryption wasn't disabled meanwhile
+	if(WMExtension::key_state != KEY_BUSY) {
+		Wire.resume();
+		SREG = oldSREG;
+		return;
+	}
+
+	memcpy(WMCrypt::wm_ft, ft, 8);
+	memcpy(WMCrypt::wm_sb, sb, 8);
+
+	WMExtension::crypt_setup_done = 1;
+	WMExtension::mirror_valid = 0;
+	WMExtension::key_state = KEY_IDLE;
+
+	Trace::event(TRACE_KEY_SETUP, 0);
+
+	// The held transfer goes on once interrupts are back on, encrypted on
+	// the fly until the mirror is rebuilt
+	Wire.resume();
+
+	SREG = oldSREG;
+
+	// The whole mirror takes ~64 x 15 cycles, too long to keep the TWI
+	// waiting. A byte at a time instead, always with the key in use then
+	WMExtension::mirror_rebuild();
+	WMExtension::mirror_valid = 1;
 }
 
 /* I2C slave handler for data request from the Wiimote */
 void WMExtension::handle_request() {
 
-	WMExtension::send_data(WMExtension::registers + WMExtension::address, WMExtension::address);
+	Trace::event(WMExtension::crypt_setup_done ? TRACE_READ_CRYPT : TRACE_READ, WMExtension::address);
+	Sniffer::read(WMExtension::address, WMExtension::crypt_setup_done);
+
+#if TURBO
+	byte *buttons = NULL;
+	byte saved[2];
+
+	// Mask turbo buttons in the outgoing report only, restored right after
+	if(WMExtension::address == 0x00) {
+		buttons = WMExtension::report_regs + ((REG_FORMAT == 0x03) ? 6 : 4);
+		saved[0] = buttons[0];
+		saved[1] = buttons[1];
+
+		Turbo::apply(buttons);
+		WMExtension::mirror_update(buttons - WMExtension::report_regs, 2);
+	}
+#endif
+
+	PROFILER_ENTER(PROF_SEND);
+	WMExtension::send_data(WMExtension::address);
+	PROFILER_EXIT(PROF_SEND);
+
+#if TURBO
+	if(buttons) {
+		buttons[0] = saved[0];
+		buttons[1] = saved[1];
+		WMExtension::mirror_update(buttons - WMExtension::report_regs, 2);
+	}
+#endif
 
 	if(WMExtension::address == 0x00) {
+		// Latched presses were just sent, start accumulating again. The
+		// report goes back to the held buttons, the pad loop may not send
+		// a new one before the next fetch (GC / N64, arcade)
+		WMExtension::latched_buttons[0] = 0;
+		WMExtension::latched_buttons[1] = 0;
+
+		byte *held = WMExtension::report_regs + ((REG_FORMAT == 0x03) ? 6 : 4);
+		held[0] = ~WMExtension::held_buttons[0];
+		held[1] = ~WMExtension::held_buttons[1];
+		WMExtension::mirror_update(held - WMExtension::report_regs, 2);
+
 		if(WMExtension::cbPtr) {
 			WMExtension::cbPtr();
 		}
+
+		WMExtension::fetch_count++;
 	}
 
 	WMExtension::address += 8;
@@ -193,43 +527,78 @@ void WMExtension::set_button_data(int bdl, int bdr, int bdu, int bdd,
 		int ba, int bb, int bx, int by, int blt, int brt, int bminus, int bplus,
 		int bhome, byte lx, byte ly, byte rx, byte ry, int bzl, int bzr, int lt, int rt) {
 
-	byte _tmp1, _tmp2;
-
-	_tmp1 = ((bdr ? 1 : 0) << 7) | ((bdd ? 1 : 0) << 6) | ((blt ? 1 : 0)
-			<< 5) | ((bminus ? 1 : 0) << 4) | ((bplus ? 1 : 0) << 2)
-			| ((brt ? 1 : 0) << 1) | ((bhome ? 1 : 0) << 3);
-
-	_tmp2 = ((bb ? 1 : 0) << 6) | ((by ? 1 : 0) << 5) | ((ba ? 1 : 0)
-			<< 4) | ((bx ? 1 : 0) << 3) | ((bdl ? 1 : 0) << 1) | (bdu ? 1
-			: 0) | ((bzl ? 1 : 0) << 7) | ((bzr ? 1 : 0) << 2);
-
-	// registers[0xFE] == 0x03: Read mode encoding used by the NES Classic Edition
-	if(WMExtension::registers[0xFE] == 0x03) {
-		WMExtension::registers[0] = lx;
-		WMExtension::registers[1] = rx;
-		WMExtension::registers[2] = ly;
-		WMExtension::registers[3] = ry;
-		WMExtension::registers[4] = lt;
-		WMExtension::registers[5] = rt;
-		WMExtension::registers[6] = ~_tmp1;
-		WMExtension::registers[7] = ~_tmp2;
-	} else {
-		lx = lx >> 2;
-		ly = ly >> 2;
-		rx = rx >> 3;
-		ry = ry >> 3;
-		lt = lt >> 3;
-		rt = rt >> 3;
-
-		WMExtension::registers[0] = ((rx & 0x18) << 3) | (lx & 0x3F);
-		WMExtension::registers[1] = ((rx & 0x06) << 5) | (ly & 0x3F);
-		WMExtension::registers[2] = ((rx & 0x01) << 7) | ((lt & 0x18) << 2) | (ry & 0x1F);
-		WMExtension::registers[3] = ((lt & 0x07) << 5) | (rt & 0x1F);
-		WMExtension::registers[4] = ~_tmp1;
-		WMExtension::registers[5] = ~_tmp2;
-		WMExtension::registers[6] = 0;
-		WMExtension::registers[7] = 0;
-	}
+	byte b[2];
+
+	WMReport::pack(b, bdl, bdr, bdu, bdd, ba, bb, bx, by, blt, brt, bminus,
+			bplus, bhome, bzl, bzr);
+
+	WMExtension::set_report(b[0], b[1], lx, ly, rx, ry, lt, rt);
+}
+
+/*
+ * Same as set_button_data(), with the buttons already packed as in report
+ * bytes 4 and 5 (not inverted). Used by pads that report in this layout.
+ */
+void WMExtension::set_report(byte _tmp1, byte _tmp2, byte lx, byte ly,
+		byte rx, byte ry, byte lt, byte rt) {
+
+	uint8_t oldSREG;
+
+	PROFILER_ENTER(PROF_REPORT);
+
+	Replay::record(_tmp1, _tmp2, lx, ly, rx, ry, lt, rt);
+
+	// Report every press seen since the last fetch, even if already released.
+	// Done atomically, up to the report and its encrypted copy (8 x ~15
+	// cycles), so a fetch (which clears the latch) can't be undone and
+	// can't send a half updated mirror.
+	oldSREG = SREG;
+	cli();
+	WMExtension::held_buttons[0] = _tmp1;
+	WMExtension::held_buttons[1] = _tmp2;
+#if TAP_LATCH
+	_tmp1 = (WMExtension::latched_buttons[0] |= _tmp1);
+	_tmp2 = (WMExtension::latched_buttons[1] |= _tmp2);
+#endif
+
+	WMReport::encode(WMExtension::report_regs, REG_FORMAT, _tmp1, _tmp2, lx,
+			ly, rx, ry, lt, rt);
+	WMExtension::mirror_encrypt(0x00, 8);
+	SREG = oldSREG;
+
+	PROFILER_EXIT(PROF_REPORT);
+}
+
+/*
+ * Puts a Classic Controller report in the registers as it was read: size
+ * bytes already in the data format the Wiimote asked for, the inverted
+ * buttons last. Nothing is decoded or encoded, only the tap latch goes
+ * into the button bytes. The TWI ISR serves the registers while the pad
+ * is read, so the report comes in through this one copy, under cli as in
+ * set_report(). Not recorded by Replay.
+ */
+void WMExtension::forward_report(const byte *report, byte size) {
+	byte *buttons = WMExtension::report_regs + size - 2;
+	uint8_t oldSREG;
+
+	PROFILER_ENTER(PROF_REPORT);
+
+	oldSREG = SREG;
+	cli();
+	memcpy(WMExtension::report_regs, report, size - 2);
+	WMExtension::held_buttons[0] = ~report[size - 2];
+	WMExtension::held_buttons[1] = ~report[size - 1];
+#if TAP_LATCH
+	buttons[0] = ~(WMExtension::latched_buttons[0] |= WMExtension::held_buttons[0]);
+	buttons[1] = ~(WMExtension::latched_buttons[1] |= WMExtension::held_buttons[1]);
+#else
+	buttons[0] = report[size - 2];
+	buttons[1] = report[size - 1];
+#endif
+	WMExtension::mirror_encrypt(0x00, 8);
+	SREG = oldSREG;
+
+	PROFILER_EXIT(PROF_REPORT);
 }
 
 /*
@@ -237,36 +606,21 @@ void WMExtension::set_button_data(int bdl, int bdr, int bdu, int bdd,
  * setup function.
  */
 void WMExtension::init() {
-	byte calchecksum = 0;
-
-	memset(WMExtension::registers, 0x00, 0x100);
+	memset(WMExtension::report_regs, 0x00, REPORT_REGS_SIZE);
+	memset(WMExtension::key_regs, 0x00, 16);
 
 	// Set extension id on registers
-	for (int i = 0xFA; i <= 0xFF; i++) {
-		WMExtension::registers[i] = WMExtension::id[i - 0xFA];
-	}
-
-	// Fix calibration data checksum, just in case...
-	for(int i = 0; i < 14; i++) {
-		calchecksum += WMExtension::calibration_data[i];
-	}
-	WMExtension::calibration_data[14] = calchecksum + 0x55;
-	WMExtension::calibration_data[15] = calchecksum + 0xAA;
-
-	// Set calibration data on registers
-	for (int i = 0x20; i <= 0x2F; i++) {
-		WMExtension::registers[i] = WMExtension::calibration_data[i - 0x20]; // 0x20
-		WMExtension::registers[i + 0x10] = WMExtension::calibration_data[i - 0x20]; // 0x30
-	}
+	memcpy_P(WMExtension::id_regs, WMExtension::id, 6);
 
 	// Initialize buttons_data, otherwise, "Up+Right locked" bug...
-	WMExtension::set_button_data(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, WMExtension::calibration_data[2], WMExtension::calibration_data[5], WMExtension::calibration_data[8], WMExtension::calibration_data[11], 0, 0, 0, 0);
+	WMExtension::set_button_data(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, CAL_STICK_CENTER, CAL_STICK_CENTER, CAL_STICK_CENTER, CAL_STICK_CENTER, 0, 0, 0, 0);
 
 	// Join I2C bus
 	Wire.begin(0x52);
 
 	Wire.onReceive(WMExtension::receive_bytes);
 	Wire.onRequest(WMExtension::handle_request);
+	Wire.onHold(WMExtension::hold_request);
 }
 
 
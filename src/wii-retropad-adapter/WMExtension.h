@@ -23,24 +23,45 @@
 #define WMEXTENSION_H_
 
 #include <WProgram.h>
+#include <avr/pgmspace.h>
+
+// Calibration of all four stick axes (see calibration_data)
+#define CAL_STICK_MAX		0xF8
+#define CAL_STICK_MIN		0x04
+#define CAL_STICK_CENTER	0x7A
 
 class WMExtension {
 
 private:
 
-	static const byte id[6];
-	static byte calibration_data[16];
+	static const byte id[6] PROGMEM;
+	static const byte calibration_data[16] PROGMEM;
 	static volatile byte address;
 	static volatile byte crypt_setup_done;
-	static byte registers[0x100];
+	static volatile byte latched_buttons[2];
+	static volatile byte held_buttons[2];
+	static volatile byte fetch_count;
+	static volatile byte key_state;
+	static byte report_regs[];
+	static byte key_regs[16];
+	static byte id_regs[6];
+	static byte enable_reg;
+	static byte mirror[];
+	static volatile byte mirror_valid;
 
 	typedef void (*CBackPtr)();
 	static CBackPtr cbPtr;
 
-	static void setup_encryption();
-	static void send_data(uint8_t* data, uint8_t addr);
+	static byte read_register(byte addr);
+	static void write_register(byte addr, byte data);
+	static byte *mirror_at(byte addr, byte length);
+	static void mirror_encrypt(byte addr, byte count);
+	static void mirror_update(byte addr, byte count);
+	static void mirror_rebuild();
+	static void send_data(uint8_t addr);
 	static void receive_bytes(int count);
 	static void handle_request();
+	static uint8_t hold_request(uint8_t *data, int count);
 
 public:
 
@@ -49,7 +70,13 @@ public:
 	static void set_button_data(int bdl, int bdr, int bdu, int bdd,
 		int ba, int bb, int bx, int by, int blt, int brt, int bminus, int bplus,
 		int bhome, byte lx, byte ly, byte rx, byte ry, int bzl, int bzr, int lt, int rt);
+	static void set_report(byte b1, byte b2, byte lx, byte ly, byte rx, byte ry, byte lt, byte rt);
+	static void forward_report(const byte *report, byte size);
 	static byte get_calibration_byte(int b);
+	static byte get_fetch_count();
+	static byte get_format();
+	static byte get_report(byte *report);
+	static void service();
 };
 
 
@@ -0,0 +1,93 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Classic Controller report encoding
+-----------------------------------
+
+The button packing and data format encoding used by WMExtension, kept
+free of AVR and Arduino dependencies so src/tools/wra-encode-check.cpp
+can build them on the host and diff them against a reference encoder.
+Run it after changing anything here.
+
+Buttons are packed as in report bytes 4 and 5 (format 1) before the
+inversion, a set bit is a pressed button:
+
+      bit   7    6    5    4    3    2    1    0
+      b1    BDR  BDD  BLT  B-   BH   B+   BRT  -
+      b2    BZL  BB   BY   BA   BX   BZR  BDL  BDU
+*/
+
+#ifndef WMREPORT_H_
+#define WMREPORT_H_
+
+#include <inttypes.h>
+
+class WMReport {
+
+public:
+	/* Packs the buttons, in set_button_data() order, into b[0] and b[1] */
+	static inline void pack(uint8_t *b, int bdl, int bdr, int bdu, int bdd,
+			int ba, int bb, int bx, int by, int blt, int brt, int bminus,
+			int bplus, int bhome, int bzl, int bzr) {
+
+		b[0] = ((bdr ? 1 : 0) << 7) | ((bdd ? 1 : 0) << 6) | ((blt ? 1 : 0)
+				<< 5) | ((bminus ? 1 : 0) << 4) | ((bplus ? 1 : 0) << 2)
+				| ((brt ? 1 : 0) << 1) | ((bhome ? 1 : 0) << 3);
+
+		b[1] = ((bb ? 1 : 0) << 6) | ((by ? 1 : 0) << 5) | ((ba ? 1 : 0)
+				<< 4) | ((bx ? 1 : 0) << 3) | ((bdl ? 1 : 0) << 1) | (bdu ? 1
+				: 0) | ((bzl ? 1 : 0) << 7) | ((bzr ? 1 : 0) << 2);
+	}
+
+	/* Writes the 8 report bytes for data format (register 0xFE) */
+	static inline void encode(uint8_t *report, uint8_t format, uint8_t b1,
+			uint8_t b2, uint8_t lx, uint8_t ly, uint8_t rx, uint8_t ry,
+			uint8_t lt, uint8_t rt) {
+
+		// Format 3: Read mode encoding used by the NES Classic Edition
+		if(format == 0x03) {
+			report[0] = lx;
+			report[1] = rx;
+			report[2] = ly;
+			report[3] = ry;
+			report[4] = lt;
+			report[5] = rt;
+			report[6] = ~b1;
+			report[7] = ~b2;
+		} else {
+			lx = lx >> 2;
+			ly = ly >> 2;
+			rx = rx >> 3;
+			ry = ry >> 3;
+			lt = lt >> 3;
+			rt = rt >> 3;
+
+			report[0] = ((rx & 0x18) << 3) | (lx & 0x3F);
+			report[1] = ((rx & 0x06) << 5) | (ly & 0x3F);
+			report[2] = ((rx & 0x01) << 7) | ((lt & 0x18) << 2) | (ry & 0x1F);
+			report[3] = ((lt & 0x07) << 5) | (rt & 0x1F);
+			report[4] = ~b1;
+			report[5] = ~b2;
+			report[6] = 0;
+			report[7] = 0;
+		}
+	}
+};
+
+#endif /* WMREPORT_H_ */
@@ -0,0 +1,213 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <WProgram.h>
+#include "WiiCCPad.h"
+#include "digitalWriteFast.h"
+#include "Arena.h"
+#include "Trace.h"
+#include "Delay.h"
+
+/* Data format in use, 1 or 3 (see WMExtension.h) */
+byte WiiCCPad::_format = 1;
+
+/* SCL was held low for too long during the current transfer */
+bool WiiCCPad::_timeout = false;
+
+// Open drain: low is an output at 0, high is an input with the pull-up
+#define SDA_LOW()		do { digitalWriteFast(WIICC_SDA_PIN, LOW); pinModeFast(WIICC_SDA_PIN, OUTPUT); } while(0)
+#define SDA_HIGH()		do { pinModeFast(WIICC_SDA_PIN, INPUT); digitalWriteFast(WIICC_SDA_PIN, HIGH); } while(0)
+#define SCL_LOW()		do { digitalWriteFast(WIICC_SCL_PIN, LOW); pinModeFast(WIICC_SCL_PIN, OUTPUT); } while(0)
+#define SCL_HIGH()		do { pinModeFast(WIICC_SCL_PIN, INPUT); digitalWriteFast(WIICC_SCL_PIN, HIGH); } while(0)
+#define HALF_BIT()		DELAY_NS(WIICC_HALF_BIT_NS)
+
+/* Releases SCL and waits while the controller stretches the clock */
+bool WiiCCPad::scl_release() {
+	byte n = WIICC_STRETCH_LOOPS;
+
+	SCL_HIGH();
+
+	while(!digitalReadFast(WIICC_SCL_PIN)) {
+		if(!--n) {
+			WiiCCPad::_timeout = true;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* START condition, from an idle bus */
+void WiiCCPad::start() {
+	WiiCCPad::_timeout = false;
+
+	SDA_HIGH();
+	WiiCCPad::scl_release();
+	HALF_BIT();
+
+	SDA_LOW();
+	HALF_BIT();
+	SCL_LOW();
+}
+
+/* STOP condition, leaves the bus idle */
+void WiiCCPad::stop() {
+	SDA_LOW();
+	HALF_BIT();
+	WiiCCPad::scl_release();
+	HALF_BIT();
+	SDA_HIGH();
+	HALF_BIT();
+}
+
+/* Sends a byte, MSB first. Returns true if it was ACKed */
+bool WiiCCPad::send(byte data) {
+	bool ack;
+
+	for(byte i = 0; i < 8; i++) {
+		if(data & 0x80)
+			SDA_HIGH();
+		else
+			SDA_LOW();
+
+		data <<= 1;
+
+		HALF_BIT();
+		WiiCCPad::scl_release();
+		HALF_BIT();
+		SCL_LOW();
+	}
+
+	SDA_HIGH();
+	HALF_BIT();
+	WiiCCPad::scl_release();
+	HALF_BIT();
+	ack = !digitalReadFast(WIICC_SDA_PIN);
+	SCL_LOW();
+
+	return ack && !WiiCCPad::_timeout;
+}
+
+/* Receives a byte, MSB first, ACKs it if more are wanted */
+byte WiiCCPad::receive(bool ack) {
+	byte data = 0;
+
+	SDA_HIGH();
+
+	for(byte i = 0; i < 8; i++) {
+		HALF_BIT();
+		WiiCCPad::scl_release();
+		HALF_BIT();
+
+		data = (data << 1) | digitalReadFast(WIICC_SDA_PIN);
+
+		SCL_LOW();
+	}
+
+	if(ack)
+		SDA_LOW();
+
+	HALF_BIT();
+	WiiCCPad::scl_release();
+	HALF_BIT();
+	SCL_LOW();
+	SDA_HIGH();
+
+	return data;
+}
+
+/* Writes one controller register */
+bool WiiCCPad::write(byte addr, byte data) {
+	bool ok;
+
+	WiiCCPad::start();
+	ok = WiiCCPad::send(WIICC_ADDRESS << 1) && WiiCCPad::send(addr) && WiiCCPad::send(data);
+	WiiCCPad::stop();
+
+	DELAY_US(WIICC_WRITE_DELAY_US);
+
+	return ok;
+}
+
+/* Reads size controller registers from addr into data */
+bool WiiCCPad::read(byte addr, byte *data, byte size) {
+	bool ok;
+
+	WiiCCPad::start();
+	ok = WiiCCPad::send(WIICC_ADDRESS << 1) && WiiCCPad::send(addr);
+	WiiCCPad::stop();
+
+	if(!ok)
+		return false;
+
+	DELAY_US(WIICC_READ_DELAY_US);
+
+	WiiCCPad::start();
+	ok = WiiCCPad::send((WIICC_ADDRESS << 1) | 1);
+
+	if(ok) {
+		for(byte i = 0; i < size; i++)
+			data[i] = WiiCCPad::receive(i < size - 1);
+	}
+
+	WiiCCPad::stop();
+
+	return ok && !WiiCCPad::_timeout;
+}
+
+/* Unencrypted mode, data format 3 if the controller takes it */
+bool WiiCCPad::init() {
+	byte format;
+
+	pinModeFast(WIICC_SDA_PIN, INPUT);
+	digitalWriteFast(WIICC_SDA_PIN, HIGH);
+	pinModeFast(WIICC_SCL_PIN, INPUT);
+	digitalWriteFast(WIICC_SCL_PIN, HIGH);
+
+	if(!WiiCCPad::write(0xF0, 0x55) || !WiiCCPad::write(0xFB, 0x00))
+		return false;
+
+	WiiCCPad::write(0xFE, 0x03);
+
+	if(WiiCCPad::read(0xFE, &format, 1) && format == 0x03)
+		WiiCCPad::_format = 3;
+	else
+		WiiCCPad::_format = 1;
+
+	return true;
+}
+
+/* Reads the report (6 or 8 bytes, see format()) into report() */
+bool WiiCCPad::read() {
+	Arena::check(ARENA_WIICC);
+
+	if(WiiCCPad::read(0x00, Arena::data.wiicc.report, WiiCCPad::_format == 3 ? 8 : 6))
+		return true;
+
+	Trace::event(TRACE_TIMEOUT, 0x00);
+
+	return false;
+}
+
+byte *WiiCCPad::report() {
+	return Arena::data.wiicc.report;
+}
+
+byte WiiCCPad::format() {
+	return WiiCCPad::_format;
+}
@@ -0,0 +1,97 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Wii Classic Controller passthrough (PAD_WIICC)
+----------------------------------------------
+
+A Classic Controller (or clone) on the DB9 cable, read with a bit-banged
+I2C master:
+
+      DB9 pin     signal          DB9 pin     signal
+      1 (D2)      SDA             5           3.3V
+      2 (D3)      SCL             8           GND
+      6, 7, 9     GND (detection, PAD_WIICC)
+
+The lines are open drain with the internal pull-ups. They are weak
+(20-50k, ~35k typical), and with the cable and the controller on the
+bus (~150pF) a line takes about 6us to rise to the controller's logic
+high (0.7 x 3.3V). SCL is waited for (clock stretching), SDA is not, so
+the default WIICC_HALF_BIT_NS of 10us (a bit under 50kHz) leaves a
+bit of margin. A report read takes about 2ms then. With 2.2k pull-ups
+to 3.3V in the cable (0.4us rise), WIICC_HALF_BIT_NS 1250 gets close to
+the 400kHz the controllers accept. Do not go below 10us without them.
+
+A controller that doesn't answer (unplugged, or still powering up) is
+tried again every WIICC_RETRY_US, with the Wiimote serviced in between.
+
+With WIICC_FORWARD = 1 (and PAD_FILTER = 0) the report goes to the
+Wiimote as it was read whenever the Wiimote asks for the controller's
+data format (WMExtension::forward_report()). There is no decoding, no
+neutral radius and no center cache. The game gets the controller's own
+stick values against the adapter's calibration data (centers at
+CAL_STICK_CENTER). In any other format the report is decoded and
+encoded again as usual.
+
+init() turns encryption off the "new" way (0xF0 = 0x55, 0xFB = 0x00) and
+asks for data format 3 (8 bytes, 8 bit sticks and triggers). Clones that
+don't take it stay in format 1 (6 bytes). read() reads the report into
+the driver arena, where it is decoded in place.
+*/
+
+#ifndef WIICCPAD_H_
+#define WIICCPAD_H_
+
+#include <WProgram.h>
+
+#define WIICC_SDA_PIN			2
+#define WIICC_SCL_PIN			3
+
+#ifndef WIICC_FORWARD
+#define WIICC_FORWARD 0
+#endif
+
+#define WIICC_ADDRESS			0x52
+#define WIICC_HALF_BIT_NS		10000 // Internal pull-ups, see above
+#define WIICC_RETRY_US			10000 // Between init() tries
+#define WIICC_STRETCH_LOOPS		255 // Clock stretching timeout, ~150us
+#define WIICC_READ_DELAY_US		100 // Between setting the address and reading
+#define WIICC_WRITE_DELAY_US	1000 // After a register write
+
+class WiiCCPad {
+
+private:
+	static byte _format;
+	static bool _timeout;
+
+	static void start();
+	static void stop();
+	static bool scl_release();
+	static bool send(byte data);
+	static byte receive(bool ack);
+	static bool write(byte addr, byte data);
+	static bool read(byte addr, byte *data, byte size);
+
+public:
+	static bool init();
+	static bool read();
+	static byte *report();
+	static byte format();
+};
+
+#endif /* WIICCPAD_H_ */
@@ -255,6 +255,19 @@ void TwoWire::onRequest( void (*function)(void) )
   user_onRequest = function;
 }
 
+// sets function that can hold a slave read or write (clock stretching),
+// called with the bytes written (NULL, 0 for a read)
+void TwoWire::onHold( uint8_t (*function)(uint8_t*, int) )
+{
+  twi_attachSlaveHoldEvent(function);
+}
+
+// lets a held slave read or write go on
+void TwoWire::resume(void)
+{
+  twi_resume();
+}
+
 // Preinstantiate Objects //////////////////////////////////////////////////////
 
 TwoWire Wire = TwoWire();
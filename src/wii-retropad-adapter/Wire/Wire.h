@@ -59,6 +59,8 @@ class TwoWire
     uint8_t receive(void);
     void onReceive( void (*)(int) );
     void onRequest( void (*)(void) );
+    void onHold( uint8_t (*)(uint8_t*, int) );
+    void resume(void);
 };
 
 extern TwoWire Wire;
@@ -33,12 +33,16 @@
 #endif
 
 #include "twi.h"
+#include "Profiler.h"
+#include "Sniffer.h"
 
 static volatile uint8_t twi_state;
 static uint8_t twi_slarw;
 
 static void (*twi_onSlaveTransmit)(void);
 static void (*twi_onSlaveReceive)(uint8_t*, int);
+static uint8_t (*twi_onSlaveHold)(uint8_t*, int);
+static volatile uint8_t twi_held;
 
 static uint8_t twi_masterBuffer[TWI_BUFFER_LENGTH];
 static volatile uint8_t twi_masterBufferIndex;
@@ -277,6 +281,51 @@ void twi_attachSlaveTxEvent( void (*function)(void) )
   twi_onSlaveTransmit = function;
 }
 
+/* 
+ * Function twi_attachSlaveHoldEvent
+ * Desc     sets function called before a slave read and at the end of a
+ *          slave write, non-zero holds the bus until twi_resume()
+ * Input    function: callback function to use, gets the bytes written
+ *          (NULL, 0 for a read)
+ * Output   none
+ */
+void twi_attachSlaveHoldEvent( uint8_t (*function)(uint8_t*, int) )
+{
+  twi_onSlaveHold = function;
+}
+
+/* 
+ * Function twi_hold
+ * Desc     asks the hold callback, if it holds leaves TWINT set with the
+ *          interrupt off: SCL stays low, the master waits (clock stretching)
+ * Input    data, count: bytes written by the master, NULL, 0 for a read
+ * Output   1 if the bus is held
+ */
+static uint8_t twi_hold(uint8_t *data, int count)
+{
+  if(!twi_onSlaveHold || !twi_onSlaveHold(data, count)){
+    return 0;
+  }
+  // TWINT isn't written, it stays set
+  TWCR = _BV(TWEN) | _BV(TWEA);
+  twi_held = 1;
+  return 1;
+}
+
+/* 
+ * Function twi_resume
+ * Desc     lets a held transfer go on, the TWI interrupt takes it from there
+ * Input    none
+ * Output   none
+ */
+void twi_resume(void)
+{
+  if(twi_held){
+    twi_held = 0;
+    TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA);
+  }
+}
+
 /* 
  * Function twi_reply
  * Desc     sends byte or readys receive line
@@ -331,6 +380,8 @@ void twi_releaseBus(void)
 
 SIGNAL(TWI_vect)
 {
+  PROFILER_ENTER(PROF_TWI);
+
   switch(TW_STATUS){
     // All Master
     case TW_START:     // sent start condition
@@ -409,6 +460,10 @@ SIGNAL(TWI_vect)
       }
       break;
     case TW_SR_STOP: // stop or repeated start condition received
+      // wait with the callback if the user can't take the data yet
+      if(twi_hold(twi_rxBuffer, twi_rxBufferIndex)){
+        break;
+      }
       // put a null char after data if there's room
       if(twi_rxBufferIndex < TWI_BUFFER_LENGTH){
         twi_rxBuffer[twi_rxBufferIndex] = '\0';
@@ -431,6 +486,10 @@ SIGNAL(TWI_vect)
     // Slave Transmitter
     case TW_ST_SLA_ACK:          // addressed, returned ack
     case TW_ST_ARB_LOST_SLA_ACK: // arbitration lost, returned ack
+      // wait with the callback if the user can't send yet
+      if(twi_hold(NULL, 0)){
+        break;
+      }
       // enter slave transmitter mode
       twi_state = TWI_STX;
       // ready the tx buffer index for iteration
@@ -458,6 +517,7 @@ SIGNAL(TWI_vect)
       break;
     case TW_ST_DATA_NACK: // received nack, we are done 
     case TW_ST_LAST_DATA: // received ack, but we are done already!
+      SNIFFER_READ_DONE(twi_txBufferIndex);
       // ack future responses
       twi_reply(1);
       // leave slave receiver state
@@ -472,5 +532,7 @@ SIGNAL(TWI_vect)
       twi_stop();
       break;
   }
+
+  PROFILER_EXIT(PROF_TWI);
 }
 
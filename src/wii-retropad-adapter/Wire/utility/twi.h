@@ -49,6 +49,8 @@
   uint8_t twi_transmit(uint8_t*, uint8_t);
   void twi_attachSlaveRxEvent( void (*)(uint8_t*, int) );
   void twi_attachSlaveTxEvent( void (*)(void) );
+  void twi_attachSlaveHoldEvent( uint8_t (*)(uint8_t*, int) );
+  void twi_resume(void);
   void twi_reply(uint8_t);
   void twi_stop(void);
   void twi_releaseBus(void);
@@ -23,6 +23,7 @@
 */
 
 #include "wiring_private.h"
+#include "../Profiler.h"
 
 // the prescaler is set so that timer0 ticks every 64 clock cycles, and the
 // the overflow handler is called every 256 ticks.
@@ -43,6 +44,8 @@ static unsigned char timer0_fract = 0;
 
 SIGNAL(TIMER0_OVF_vect)
 {
+	PROFILER_ENTER(PROF_TIMER0);
+
 	// copy these to local variables so they can be stored in registers
 	// (volatile variables must be read from memory on every access)
 	unsigned long m = timer0_millis;
@@ -58,6 +61,8 @@ SIGNAL(TIMER0_OVF_vect)
 	timer0_fract = f;
 	timer0_millis = m;
 	timer0_overflow_count++;
+
+	PROFILER_EXIT(PROF_TIMER0);
 }
 
 unsigned long millis()
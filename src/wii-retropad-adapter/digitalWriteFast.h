@@ -135,9 +135,9 @@
 
 
 #define __atomicWrite__(A,P,V) \
-if ( (int)(A) < 0x40) { bitWrite(*((volatile uint8_t*) A), __digitalPinToBit(P), (V) );}  \
+if ( (uintptr_t)(A) < 0x40) { bitWrite(*((volatile uint8_t*) A), __digitalPinToBit(P), (V) );}  \
 else {                                                         \
-uint8_t register saveSreg = SREG;                          \
+uint8_t saveSreg = SREG;                                   \
 cli();                                                     \
 bitWrite(*((volatile uint8_t*)A), __digitalPinToBit(P), (V) );                   \
 SREG=saveSreg;                                             \
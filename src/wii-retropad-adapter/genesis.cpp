@@ -19,6 +19,7 @@
 #include <WProgram.h>
 #include "genesis.h"
 #include "digitalWriteFast.h"
+#include "Delay.h"
 
 #define DB9P1 2
 #define DB9P2 3
@@ -28,7 +29,7 @@
 #define DB9P7 7
 #define DB9P9 8
 
-#define DELAY 14
+#define SETTLE()	DELAY_US_MIN(GENESIS_SETTLE_US, GENESIS_SETTLE_MIN_NS)
 
 void genesis_init() {
 	pinModeFast(DB9P1, INPUT);
@@ -56,7 +57,7 @@ int genesis_read() {
 
 	// Get D-PAD, B, C buttons state
 	digitalWriteFast(DB9P7, HIGH);
-	delayMicroseconds(DELAY);
+	SETTLE();
 
 	normalbuttons |= (!digitalReadFast(DB9P1) << 0);
 	normalbuttons |= (!digitalReadFast(DB9P2) << 1);
@@ -67,7 +68,7 @@ int genesis_read() {
 
 	// 1
 	digitalWriteFast(DB9P7, LOW);
-	delayMicroseconds(DELAY);
+	SETTLE();
 
 	// If using a SEGA Genesis controller, LEFT and RIGHT will be ACTIVE here
 	if(!(!digitalReadFast(DB9P3) && !digitalReadFast(DB9P4))) {
@@ -81,22 +82,22 @@ int genesis_read() {
 	normalbuttons |= (!digitalReadFast(DB9P9) << 7);
 
 	digitalWriteFast(DB9P7, HIGH);
-	delayMicroseconds(DELAY);
+	SETTLE();
 
 	// 2
 	digitalWriteFast(DB9P7, LOW);
-	delayMicroseconds(DELAY);
+	SETTLE();
 	digitalWriteFast(DB9P7, HIGH);
-	delayMicroseconds(DELAY);
+	SETTLE();
 
 	// 3
 	digitalWriteFast(DB9P7, LOW);
-	delayMicroseconds(DELAY);
+	SETTLE();
 
 	// Up, Down, Left and Right are low if 6-button controller
 	if(!digitalReadFast(DB9P1) && !digitalReadFast(DB9P2) && !digitalReadFast(DB9P3) && !digitalReadFast(DB9P4)) {
 		digitalWriteFast(DB9P7, HIGH);
-		delayMicroseconds(DELAY);
+		SETTLE();
 
 		extrabuttons |= (!digitalReadFast(DB9P1) << 0);
 		extrabuttons |= (!digitalReadFast(DB9P2) << 1);
@@ -105,11 +106,11 @@ int genesis_read() {
 
 		// 4
 		digitalWriteFast(DB9P7, LOW);
-		delayMicroseconds(DELAY);
+		SETTLE();
 		digitalWriteFast(DB9P7, HIGH);
 
 		// Delay needed for settling joystick down
-		delayMicroseconds(2000);
+		DELAY_US(2000);
 	}
 
 	retval = normalbuttons | (extrabuttons << 8);
@@ -35,4 +35,9 @@ int genesis_read();
 #define GENESIS_START 0x80
 #define GENESIS_MODE 0x800
 
+// SELECT to the reads. Six button pads are microcontrollers, only ever run
+// at the delayMicroseconds(14) (111 cycles at 8MHz) this was: the minimum
+#define GENESIS_SETTLE_US		14
+#define GENESIS_SETTLE_MIN_NS	13875
+
 #endif /* GENESIS_H_ */
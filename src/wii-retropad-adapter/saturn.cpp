@@ -19,6 +19,7 @@
 #include <WProgram.h>
 #include "saturn.h"
 #include "digitalWriteFast.h"
+#include "Delay.h"
 
 #define D1 2
 #define D0 3
@@ -27,7 +28,7 @@
 #define D3 7
 #define D2 8
 
-#define DELAY 7
+#define SETTLE()	DELAY_US_MIN(SATURN_SETTLE_US, SATURN_SETTLE_MIN_NS)
 
 void saturn_init() {
 	pinModeFast(D1, INPUT);
@@ -57,14 +58,14 @@ int saturn_read() {
 	// Reading L
 	digitalWriteFast(S0, HIGH);
 	digitalWriteFast(S1, HIGH);
-	delayMicroseconds(DELAY);
+	SETTLE();
 
 	retval |= (!digitalReadFast(D3) << 12); // L
 
 	// Reading Z, Y, X and R
 	digitalWriteFast(S0, LOW);
 	digitalWriteFast(S1, LOW);
-	delayMicroseconds(DELAY);
+	SETTLE();
 
 	retval |= (!digitalReadFast(D0) << 0); // Z
 	retval |= (!digitalReadFast(D1) << 1); // Y
@@ -74,7 +75,7 @@ int saturn_read() {
 	// Reading B, C, A and Start
 	digitalWriteFast(S0, HIGH);
 	digitalWriteFast(S1, LOW);
-	delayMicroseconds(DELAY);
+	SETTLE();
 
 	retval |= (!digitalReadFast(D0) << 4); // B
 	retval |= (!digitalReadFast(D1) << 5); // C
@@ -84,7 +85,7 @@ int saturn_read() {
 	// Reading Up, Down, Left, Right
 	digitalWriteFast(S0, LOW);
 	digitalWriteFast(S1, HIGH);
-	delayMicroseconds(DELAY);
+	SETTLE();
 
 	retval |= (!digitalReadFast(D0) << 8); // Up
 	retval |= (!digitalReadFast(D1) << 9); // Down
@@ -36,4 +36,9 @@ int saturn_read();
 #define SATURN_L 		0x1000
 #define SATURN_R 		0x08
 
+// S0 / S1 to the reads, at least the delayMicroseconds(7) (55 cycles at
+// 8MHz) the pads have been run with
+#define SATURN_SETTLE_US		7
+#define SATURN_SETTLE_MIN_NS	6875
+
 #endif /* SATURN_H_ */
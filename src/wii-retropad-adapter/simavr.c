@@ -0,0 +1,47 @@
+/*
+* Wii RetroPad Adapter - Nintendo Wiimote adapter for retro-controllers!
+* Copyright (c) 2011 Bruno Freitas - bruno@brunofreitas.com
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * simavr metadata (built with SIMAVR = 1 in the Makefile).
+ *
+ * Tags wra.elf with the MCU and F_CPU it was built for, so simavr loads it
+ * at the real 8MHz without extra command line options, and asks it to dump
+ * the pad and TWI pins into wra.vcd for cycle exact timing analysis.
+ *
+ * Needs simavr's avr_mcu_section.h in the include path (SIMAVR_INC).
+ */
+
+#if SIMAVR
+
+#include <avr/io.h>
+#include <avr_mcu_section.h>
+
+AVR_MCU(F_CPU, SIMAVR_MCU);
+
+AVR_MCU_VCD_FILE("wra.vcd", 1000);
+
+const struct avr_mmcu_vcd_trace_t simavr_vcd_trace[] _MMCU_ = {
+	{ AVR_MCU_VCD_SYMBOL("PIND"), .what = (void*)&PIND, }, // DB9 pins 1-4, 6, 7
+	{ AVR_MCU_VCD_SYMBOL("PORTD"), .what = (void*)&PORTD, },
+	{ AVR_MCU_VCD_SYMBOL("PINB"), .what = (void*)&PINB, }, // DB9 pin 9
+	{ AVR_MCU_VCD_SYMBOL("PINC"), .what = (void*)&PINC, }, // SDA / SCL
+	{ AVR_MCU_VCD_SYMBOL("TWSR"), .what = (void*)&TWSR, },
+	{ AVR_MCU_VCD_SYMBOL("SREG"), .what = (void*)&SREG, }, // I flag
+};
+
+#endif
@@ -0,0 +1,56 @@
+# Static RAM from the linker map ($(TARGET).map), what is left in .data,
+# .bss and .noinit after --gc-sections. Used by "make sramreport" (bytes per
+# object, then the total) and "make sramsymbols" (-v sym=1: one line per
+# input section, named after the variable thanks to -fdata-sections).
+
+# Map sizes are hex, mawk has no strtonum()
+function hex(s,    i, v) {
+	s = tolower(substr(s, 3))
+	v = 0
+
+	for(i = 1; i <= length(s); i++)
+		v = v * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+
+	return v
+}
+
+function add(section, size, object,    name) {
+	if(!size)
+		return
+
+	sub(/.*\//, "", object)
+
+	if(sym) {
+		name = section
+		sub(/^\.(data|bss|noinit)\.?/, "", name)
+		printf "%6d  %-20s %s\n", size, object, (name == "" || name == "COMMON") ? "(" section ")" : name
+	} else {
+		ram[object] += size
+	}
+
+	total += size
+}
+
+# Skip the discarded input sections listed before the map itself
+/^Linker script and memory map/ { map = 1; next }
+!map { next }
+
+# Output section, only the SRAM ones matter
+/^[^ ]/ { ram_section = ($1 == ".data" || $1 == ".bss" || $1 == ".noinit"); pending = ""; next }
+!ram_section { next }
+
+# Long input section names are alone on their line, the rest on the next
+pending != "" && NF == 3 && $1 ~ /^0x/ && $2 ~ /^0x/ { add(pending, hex($2), $3); pending = ""; next }
+{ pending = "" }
+
+/^ [.A-Z]/ && NF == 1 { pending = $1; next }
+/^ [.A-Z]/ && NF == 4 && $2 ~ /^0x/ && $3 ~ /^0x/ { add($1, hex($3), $4) }
+
+END {
+	if(!sym) {
+		for(object in ram)
+			printf "%6d  %s\n", ram[object], object
+	}
+
+	printf "%6d  total\n", total
+}
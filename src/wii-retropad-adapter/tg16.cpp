@@ -18,6 +18,9 @@
 
 #include "tg16.h"
 #include "digitalWriteFast.h"
+#include "Delay.h"
+
+#define SETTLE()	DELAY_NS_MIN(TG16_SETTLE_NS, TG16_SETTLE_MIN_NS)
 
 void tg16_init(void) {
 	// Configure Data pins
@@ -53,13 +56,13 @@ int tg16_read(void) {
 	for(int i = 0; i < 2; i++) {
 		// /OE LOW
 		digitalWriteFast(8, LOW);
-		delayMicroseconds(1);
+		SETTLE();
 
 		// If four directions are low, then it's an Avenue6 Pad
 		if(!digitalReadFast(2) && !digitalReadFast(4) && !digitalReadFast(5) && !digitalReadFast(6)) {
 			// Data Select LOW
 			digitalWriteFast(7, LOW);
-			delayMicroseconds(1);
+			SETTLE();
 
 			retval |= (!digitalReadFast(2) << 8);  // III
 			retval |= (!digitalReadFast(4) << 9);  // IV
@@ -74,7 +77,7 @@ int tg16_read(void) {
 
 			// Data Select LOW
 			digitalWriteFast(7, LOW);
-			delayMicroseconds(1);
+			SETTLE();
 
 			retval |= (!digitalReadFast(2) << 4); // I
 			retval |= (!digitalReadFast(4) << 5); // II
@@ -32,6 +32,11 @@
 #define TG16_V		10
 #define TG16_VI		11
 
+// /OE low and SELECT to the reads. The 74HC157 needs far less, but pads
+// have only been run at the ~1.75us delayMicroseconds(1) gave
+#define TG16_SETTLE_NS		1750
+#define TG16_SETTLE_MIN_NS	1750
+
 void tg16_init(void);
 int tg16_read(void);
 
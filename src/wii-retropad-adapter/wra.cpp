@@ -25,6 +25,20 @@
 #include "NESPad.h"
 #include "GCPad.h"
 #include "tg16.h"
+#include "PadFilter.h"
+#include "Trace.h"
+#include "Arena.h"
+#include "StackMonitor.h"
+#include "Profiler.h"
+#include "Timebase.h"
+#include "Delay.h"
+#include "PadCache.h"
+#include "Replay.h"
+#include "Power.h"
+#include "Arcade.h"
+#include "WiiCCPad.h"
+#include "Sniffer.h"
+#include "JoybusTiming.h"
 
 // Classic Controller Buttons
 int bdl = 0; // D-Pad Left state
@@ -45,15 +59,20 @@ int bzr = 0; // ZR button state
 int lt = 0; // L analog value
 int rt = 0; // R analog value
 
-// Analog Buttons
-byte lx = WMExtension::get_calibration_byte(2);
-byte ly = WMExtension::get_calibration_byte(5);
-byte rx = WMExtension::get_calibration_byte(8);
-byte ry = WMExtension::get_calibration_byte(11);
+// Analog Buttons (static data, no constructor code runs before main())
+byte lx = CAL_STICK_CENTER;
+byte ly = CAL_STICK_CENTER;
+byte rx = CAL_STICK_CENTER;
+byte ry = CAL_STICK_CENTER;
 
 // Analog stick neutral radius
 #define ANALOG_NEUTRAL_RADIUS 10
 
+// Cached centers revalidation, see settle_centers()
+#define CENTER_SETTLE_RADIUS	(ANALOG_NEUTRAL_RADIUS / 2) // Stick noise at rest
+#define CENTER_SETTLE_MAX		(4 * ANALOG_NEUTRAL_RADIUS) // Further out is a held stick
+#define CENTER_SETTLE_US		1000000UL
+
 // Extension cable detection pins
 #define DETPIN0 3  // DB9P2
 #define DETPIN1	5  // DB9P4
@@ -97,6 +116,11 @@ byte ry = WMExtension::get_calibration_byte(11);
 int detectPad() {
 	int pad;
 
+#if ARCADE
+	// Switches wired straight to the pins can't be detected, see Arcade.h
+	return PAD_ARCADE;
+#endif
+
 	// Set pad/arcade detection pins as input, turning pull-ups on
 	pinMode(DETPIN0, INPUT);
 	digitalWrite(DETPIN0, HIGH);
@@ -138,6 +162,21 @@ int detectPad() {
 }
 
 
+/*
+ * Background work of the pad loops, done once per pass at their idle point
+ * (before sleeping or reading the pad) instead of in set_report(), which
+ * only packs, encodes and publishes the report.
+ */
+void pad_idle() {
+	Trace::pad_sample();
+	StackMonitor::poll();
+	PadCache::service();
+	Replay::service();
+	JoybusTiming::service();
+
+	WMExtension::service();
+}
+
 // Genesis pad loop
 void genesis_loop() {
 	int button_data;
@@ -145,7 +184,9 @@ void genesis_loop() {
 	genesis_init();
 
 	for (;;) {
-		button_data = genesis_read();
+		pad_idle();
+		Power::idle();
+		button_data = PadFilter::vote(genesis_read);
 
 		bdl = button_data & GENESIS_LEFT;
 		bdr = button_data & GENESIS_RIGHT;
@@ -166,6 +207,10 @@ void genesis_loop() {
 	}
 }
 
+int nes_read_helper(void) {
+	return NESPad::read(8);
+}
+
 // NES pad loop
 void nes_loop() {
 	int button_data;
@@ -173,8 +218,10 @@ void nes_loop() {
 	NESPad::init();
 
 	for (;;) {
+		pad_idle();
+		Power::idle();
 
-		button_data = NESPad::read(8);
+		button_data = PadFilter::vote(nes_read_helper);
 
 		bdl = button_data & 64;
 		bdr = button_data & 128;
@@ -191,6 +238,10 @@ void nes_loop() {
 	}
 }
 
+int snes_read_helper(void) {
+	return NESPad::read(16);
+}
+
 // SNES pad loop
 void snes_loop() {
 	int button_data;
@@ -198,7 +249,9 @@ void snes_loop() {
 	NESPad::init();
 
 	for (;;) {
-		button_data = NESPad::read(16);
+		pad_idle();
+		Power::idle();
+		button_data = PadFilter::vote(snes_read_helper);
 
 		bdl = button_data & 64;
 		bdr = button_data & 128;
@@ -219,10 +272,83 @@ void snes_loop() {
 	}
 }
 
+// Cached centers in use, settle_centers() is watching the sticks
+bool center_settling = false;
+byte settle_ref[4];
+unsigned long settle_since;
+
+/*
+ * Picks the stick centers of a pad that was just read into center[]. The
+ * first read is used (and cached) if it is close to the cached centers, or
+ * if there are none. Otherwise either the stick was held at plug-in or this
+ * is another pad of the same type, resting somewhere else: the cached
+ * centers are used and settle_centers() finds out which.
+ */
+void select_centers(int pad, PadCacheData *cache, bool cached, byte *center, byte axes) {
+	center_settling = false;
+
+	if(cached) {
+		for(byte i = 0; i < axes; i++) {
+			if(abs(center[i] - cache->center[i]) > ANALOG_NEUTRAL_RADIUS) {
+				memcpy(settle_ref, center, axes);
+				settle_since = Timebase::now();
+				center_settling = true;
+
+				memcpy(center, cache->center, axes);
+				return;
+			}
+		}
+	}
+
+	memcpy(cache->center, center, axes);
+	PadCache::store(pad, cache);
+}
+
+/*
+ * Called with every stick sample while center_settling. Once all axes have
+ * stayed within CENTER_SETTLE_RADIUS of one position for CENTER_SETTLE_US,
+ * that is the rest position: if it is away from the cached centers, but
+ * within CENTER_SETTLE_MAX of them (further out is a stick held still), it
+ * becomes the center and is cached.
+ */
+void settle_centers(int pad, PadCacheData *cache, byte *center, const byte *sample, byte axes) {
+	unsigned long now = Timebase::now();
+	bool off = false;
+
+	for(byte i = 0; i < axes; i++) {
+		if(abs(sample[i] - settle_ref[i]) > CENTER_SETTLE_RADIUS) {
+			memcpy(settle_ref, sample, axes);
+			settle_since = now;
+			return;
+		}
+	}
+
+	if(now - settle_since < CENTER_SETTLE_US)
+		return;
+
+	for(byte i = 0; i < axes; i++) {
+		if(abs(settle_ref[i] - center[i]) > CENTER_SETTLE_MAX) {
+			settle_since = now;
+			return;
+		}
+
+		if(abs(settle_ref[i] - center[i]) > ANALOG_NEUTRAL_RADIUS)
+			off = true;
+	}
+
+	if(off) {
+		memcpy(center, settle_ref, axes);
+		memcpy(cache->center, settle_ref, axes);
+		PadCache::store(pad, cache);
+	}
+
+	center_settling = false;
+}
+
 // PS2 pad loop
 void ps2_loop() {
 
-	byte center_lx, center_ly, center_rx, center_ry;
+	byte center[4];
 	byte _lx, _ly, _rx, _ry;
 
 	byte clx = WMExtension::get_calibration_byte(2);
@@ -230,24 +356,40 @@ void ps2_loop() {
 	byte crx = WMExtension::get_calibration_byte(8);
 	byte cry = WMExtension::get_calibration_byte(11);
 
-	while (PS2Pad::init(false));
+	PadCacheData cache = { 0, 1, { clx, cly, crx, cry } };
+	bool cached = PadCache::load(PAD_PS2, &cache);
+
+	Arena::claim(ARENA_PS2);
+
+	while (PS2Pad::init(false, cache.read_delay))
+		WMExtension::service();
+
+	// Only remember the read delay if it got the pad into analog mode
+	if(PS2Pad::type() == 1)
+		cache.read_delay = PS2Pad::read_delay();
 
 	PS2Pad::read();
 
 	// If Pad mode is digital
 	if(PS2Pad::PS2Pad_mode() == 4) {
-		center_lx = clx;
-		center_ly = cly;
-		center_rx = crx;
-		center_ry = cry;
+		center[0] = clx;
+		center[1] = cly;
+		center[2] = crx;
+		center[3] = cry;
+
+		PadCache::store(PAD_PS2, &cache);
 	} else {
-		center_lx = PS2Pad::stick(PSS_LX);
-		center_ly = PS2Pad::stick(PSS_LY);
-		center_rx = PS2Pad::stick(PSS_RX);
-		center_ry = PS2Pad::stick(PSS_RY);
+		center[0] = PS2Pad::stick(PSS_LX);
+		center[1] = PS2Pad::stick(PSS_LY);
+		center[2] = PS2Pad::stick(PSS_RX);
+		center[3] = PS2Pad::stick(PSS_RY);
+
+		select_centers(PAD_PS2, &cache, cached, center, 4);
 	}
 
 	for (;;) {
+		pad_idle();
+		Power::idle();
 		PS2Pad::read();
 
 		bdl = PS2Pad::button(PSB_PAD_LEFT);
@@ -278,25 +420,30 @@ void ps2_loop() {
 			rx = crx;
 			ry = cry;
 		} else {
-			_lx = PS2Pad::stick(PSS_LX);
-			_ly = PS2Pad::stick(PSS_LY);
-			_rx = PS2Pad::stick(PSS_RX);
-			_ry = PS2Pad::stick(PSS_RY);
+			_lx = PadFilter::smooth(PADFILTER_LX, PS2Pad::stick(PSS_LX));
+			_ly = PadFilter::smooth(PADFILTER_LY, PS2Pad::stick(PSS_LY));
+			_rx = PadFilter::smooth(PADFILTER_RX, PS2Pad::stick(PSS_RX));
+			_ry = PadFilter::smooth(PADFILTER_RY, PS2Pad::stick(PSS_RY));
+
+			if(center_settling) {
+				byte sample[4] = { _lx, _ly, _rx, _ry };
+				settle_centers(PAD_PS2, &cache, center, sample, 4);
+			}
 
-			if((_lx >= (center_lx - ANALOG_NEUTRAL_RADIUS)) && (_lx <= (center_lx + ANALOG_NEUTRAL_RADIUS))) {
+			if((_lx >= (center[0] - ANALOG_NEUTRAL_RADIUS)) && (_lx <= (center[0] + ANALOG_NEUTRAL_RADIUS))) {
 				_lx = clx;
 			}
 
-			if((_ly >= (center_ly - ANALOG_NEUTRAL_RADIUS)) && (_ly <= (center_ly + ANALOG_NEUTRAL_RADIUS))) {
+			if((_ly >= (center[1] - ANALOG_NEUTRAL_RADIUS)) && (_ly <= (center[1] + ANALOG_NEUTRAL_RADIUS))) {
 				_ly = cly;
 			}
 
 
-			if((_rx >= (center_rx - ANALOG_NEUTRAL_RADIUS/2)) && (_rx <= (center_rx + ANALOG_NEUTRAL_RADIUS/2))) {
+			if((_rx >= (center[2] - ANALOG_NEUTRAL_RADIUS/2)) && (_rx <= (center[2] + ANALOG_NEUTRAL_RADIUS/2))) {
 				_rx = crx;
 			}
 
-			if((_ry >= (center_ry - ANALOG_NEUTRAL_RADIUS/2)) && (_ry <= (center_ry + ANALOG_NEUTRAL_RADIUS/2))) {
+			if((_ry >= (center[3] - ANALOG_NEUTRAL_RADIUS/2)) && (_ry <= (center[3] + ANALOG_NEUTRAL_RADIUS/2))) {
 				_ry = cry;
 			}
 
@@ -318,8 +465,9 @@ void gc_loop_helper(void) {
 
 void gc_loop() {
 	byte *button_data;
+	byte fetches, f;
 
-	byte center_lx, center_ly, center_rx, center_ry;
+	byte center[4];
 	byte _lx, _ly, _rx, _ry;
 
 	byte clx = WMExtension::get_calibration_byte(2);
@@ -327,24 +475,49 @@ void gc_loop() {
 	byte crx = WMExtension::get_calibration_byte(8);
 	byte cry = WMExtension::get_calibration_byte(11);
 
+	PadCacheData cache = { 0, 1, { clx, cly, crx, cry } };
+	bool cached;
+
+	Arena::claim(ARENA_JOYBUS);
+
+	// No pad yet: keep the timebase and the key setup going meanwhile
 	while(!GCPad_init(true, true)) {
-		delayMicroseconds(10000);
+		WMExtension::service();
+		DELAY_US(10000);
 	}
 
-	delayMicroseconds(10000);
+	DELAY_US(10000);
 
 	GCPad_read(true);
 
 	button_data = GCPad_data();
 
-	center_lx = button_data[2];
-	center_ly = button_data[3];
-	center_rx = button_data[4];
-	center_ry = button_data[5];
+	center[0] = button_data[2];
+	center[1] = button_data[3];
+	center[2] = button_data[4];
+	center[3] = button_data[5];
+
+	cached = PadCache::load(PAD_GC, &cache);
+	select_centers(PAD_GC, &cache, cached, center, 4);
 
 	WMExtension::set_button_data_callback(gc_loop_helper);
 
+	fetches = WMExtension::get_fetch_count() - 1;
+
 	for(;;) {
+		pad_idle();
+
+		// Pad is only sampled when the Wiimote fetches a report (see
+		// gc_loop_helper), so there is nothing new to decode until then
+		f = WMExtension::get_fetch_count();
+
+		if(f == fetches) {
+			Power::wait_fetch(f);
+			continue;
+		}
+
+		fetches = f;
+
 		button_data = GCPad_data();
 
 		bdl = button_data[1] & 0x01;
@@ -366,24 +539,29 @@ void gc_loop() {
 
 		bhome = (bdu && bp); // UP + START == HOME
 
-		_lx = button_data[2];
-		_ly = button_data[3];
-		_rx = button_data[4];
-		_ry = button_data[5];
+		_lx = PadFilter::smooth(PADFILTER_LX, button_data[2]);
+		_ly = PadFilter::smooth(PADFILTER_LY, button_data[3]);
+		_rx = PadFilter::smooth(PADFILTER_RX, button_data[4]);
+		_ry = PadFilter::smooth(PADFILTER_RY, button_data[5]);
+
+		if(center_settling) {
+			byte sample[4] = { _lx, _ly, _rx, _ry };
+			settle_centers(PAD_GC, &cache, center, sample, 4);
+		}
 
-		if((_lx >= (center_lx - ANALOG_NEUTRAL_RADIUS)) && (_lx <= (center_lx + ANALOG_NEUTRAL_RADIUS))) {
+		if((_lx >= (center[0] - ANALOG_NEUTRAL_RADIUS)) && (_lx <= (center[0] + ANALOG_NEUTRAL_RADIUS))) {
 			_lx = clx;
 		}
 
-		if((_ly >= (center_ly - ANALOG_NEUTRAL_RADIUS)) && (_ly <= (center_ly + ANALOG_NEUTRAL_RADIUS))) {
+		if((_ly >= (center[1] - ANALOG_NEUTRAL_RADIUS)) && (_ly <= (center[1] + ANALOG_NEUTRAL_RADIUS))) {
 			_ly = cly;
 		}
 
-		if((_rx >= (center_rx - ANALOG_NEUTRAL_RADIUS/2)) && (_rx <= (center_rx + ANALOG_NEUTRAL_RADIUS/2))) {
+		if((_rx >= (center[2] - ANALOG_NEUTRAL_RADIUS/2)) && (_rx <= (center[2] + ANALOG_NEUTRAL_RADIUS/2))) {
 			_rx = crx;
 		}
 
-		if((_ry >= (center_ry - ANALOG_NEUTRAL_RADIUS/2)) && (_ry <= (center_ry + ANALOG_NEUTRAL_RADIUS/2))) {
+		if((_ry >= (center[3] - ANALOG_NEUTRAL_RADIUS/2)) && (_ry <= (center[3] + ANALOG_NEUTRAL_RADIUS/2))) {
 			_ry = cry;
 		}
 
@@ -392,8 +570,8 @@ void gc_loop() {
 		rx = _rx;
 		ry = _ry;
 
-		lt = button_data[6]; //map(button_data[6], 0, 255, 0, 31);
-		rt = button_data[7]; //map(button_data[7], 0, 255, 0, 31);
+		lt = PadFilter::smooth(PADFILTER_LT, button_data[6]); //map(button_data[6], 0, 255, 0, 31);
+		rt = PadFilter::smooth(PADFILTER_RT, button_data[7]); //map(button_data[7], 0, 255, 0, 31);
 
 		WMExtension::set_button_data(bdl, bdr, bdu, bdd, ba, bb, bx, by, bl, br,
 				bm, bp, bhome, lx, ly, rx, ry, bzl, bzr, lt, rt);
@@ -407,9 +585,10 @@ void n64_loop_helper(void) {
 
 void n64_loop() {
 	byte *button_data;
+	byte fetches, f;
 	bool swap_l_z = false;
 
-	byte center_lx, center_ly;
+	byte center[2];
 	byte _lx, _ly, _rx, _ry;
 
 	byte clx = WMExtension::get_calibration_byte(2);
@@ -417,27 +596,58 @@ void n64_loop() {
 	byte crx = WMExtension::get_calibration_byte(8);
 	byte cry = WMExtension::get_calibration_byte(11);
 
+	PadCacheData cache = { 0, 1, { clx, cly, crx, cry } };
+	bool cached;
+
+	Arena::claim(ARENA_JOYBUS);
+
+	// No pad yet: keep the timebase and the key setup going meanwhile
 	while(!GCPad_init(true, true)) {
-		delayMicroseconds(10000);
+		WMExtension::service();
+		DELAY_US(10000);
 	}
 
-	delayMicroseconds(10000);
+	DELAY_US(10000);
 
 	N64Pad_read(true);
 
 	button_data = N64Pad_data();
 
-	center_lx = ((button_data[2] >= 128) ? button_data[2] - 128 : button_data[2] + 128);
-	center_ly = ((button_data[3] >= 128) ? button_data[3] - 128 : button_data[3] + 128);
+	center[0] = ((button_data[2] >= 128) ? button_data[2] - 128 : button_data[2] + 128);
+	center[1] = ((button_data[3] >= 128) ? button_data[3] - 128 : button_data[3] + 128);
+
+	cached = PadCache::load(PAD_N64, &cache);
+
+	// If plugged in with L pressed, L and Z buttons swap is toggled (for Zelda games' sake!)
+	// Only kept across power ups with PAD_CACHE_SWAP (see PadCache.h)
+	swap_l_z = PAD_CACHE_SWAP && (cache.flags & PADCACHE_SWAP_L_Z);
 
-	// If plugged in with L pressed, L and Z buttons will be swapped (for Zelda games' sake!)
 	if (button_data[1] & 0x20) {
-		swap_l_z = true;
+		swap_l_z = !swap_l_z;
 	}
 
+	cache.flags = (PAD_CACHE_SWAP && swap_l_z) ? PADCACHE_SWAP_L_Z : 0;
+
+	select_centers(PAD_N64, &cache, cached, center, 2);
+
 	WMExtension::set_button_data_callback(n64_loop_helper);
 
+	fetches = WMExtension::get_fetch_count() - 1;
+
 	for(;;) {
+		pad_idle();
+
+		// Pad is only sampled when the Wiimote fetches a report (see
+		// n64_loop_helper), so there is nothing new to decode until then
+		f = WMExtension::get_fetch_count();
+
+		if(f == fetches) {
+			Power::wait_fetch(f);
+			continue;
+		}
+
+		fetches = f;
+
 		button_data = N64Pad_data();
 
 		bdl = button_data[0] & 0x02;
@@ -481,14 +691,19 @@ void n64_loop() {
 		by = button_data[1] & 0x02; // Y == C Left
 		bx = button_data[1] & 0x01; // X == C Right
 
-		_lx = ((button_data[2] >= 128) ? button_data[2] - 128 : button_data[2] + 128);
-		_ly = ((button_data[3] >= 128) ? button_data[3] - 128 : button_data[3] + 128);
+		_lx = PadFilter::smooth(PADFILTER_LX, ((button_data[2] >= 128) ? button_data[2] - 128 : button_data[2] + 128));
+		_ly = PadFilter::smooth(PADFILTER_LY, ((button_data[3] >= 128) ? button_data[3] - 128 : button_data[3] + 128));
+
+		if(center_settling) {
+			byte sample[2] = { _lx, _ly };
+			settle_centers(PAD_N64, &cache, center, sample, 2);
+		}
 
-		if((_lx >= (center_lx - ANALOG_NEUTRAL_RADIUS)) && (_lx <= (center_lx + ANALOG_NEUTRAL_RADIUS))) {
+		if((_lx >= (center[0] - ANALOG_NEUTRAL_RADIUS)) && (_lx <= (center[0] + ANALOG_NEUTRAL_RADIUS))) {
 			_lx = clx;
 		}
 
-		if((_ly >= (center_ly - ANALOG_NEUTRAL_RADIUS)) && (_ly <= (center_ly + ANALOG_NEUTRAL_RADIUS))) {
+		if((_ly >= (center[1] - ANALOG_NEUTRAL_RADIUS)) && (_ly <= (center[1] + ANALOG_NEUTRAL_RADIUS))) {
 			_ly = cly;
 		}
 
@@ -509,7 +724,9 @@ void neogeo_loop() {
 	NESPad::init();
 
 	for (;;) {
-		button_data = NESPad::read(16);
+		pad_idle();
+		Power::idle();
+		button_data = PadFilter::vote(snes_read_helper);
 
 		bdl = button_data & 0x02;
 		bdr = button_data & 0x800;
@@ -534,7 +751,9 @@ void saturn_loop() {
 	saturn_init();
 
 	for (;;) {
-		button_data = saturn_read();
+		pad_idle();
+		Power::idle();
+		button_data = PadFilter::vote(saturn_read);
 
 		bdl = button_data & SATURN_LEFT;
 		bdr = button_data & SATURN_RIGHT;
@@ -566,8 +785,10 @@ void tg16_loop() {
 	tg16_init();
 
 	for (;;) {
+		pad_idle();
+		Power::idle();
 
-		button_data = tg16_read();
+		button_data = PadFilter::vote(tg16_read);
 
 		bdl = button_data & (1 << TG16_LEFT);
 		bdr = button_data & (1 << TG16_RIGHT);
@@ -584,18 +805,184 @@ void tg16_loop() {
 	}
 }
 
-void unsupported_pad(void) {
-	for(;;);
+#if ARCADE
+// Arcade loop, only sends a report when a switch changes (see Arcade.h)
+void arcade_loop() {
+	word state, last = 0xFFFF; // Never a valid state, first pass reports
+	byte seen;
+
+	Arcade::init();
+
+	for (;;) {
+		pad_idle();
+
+		seen = Arcade::edge_count();
+		state = Arcade::read();
+
+		// Nothing new, wait for the next edge or the end of a lockout
+		if(state == last) {
+			Power::wait_change(Arcade::edge_count, seen, Arcade::settle_time());
+			continue;
+		}
+
+		last = state;
+
+		bdu = state & ARCADE_UP;
+		bdd = state & ARCADE_DOWN;
+		bdl = state & ARCADE_LEFT;
+		bdr = state & ARCADE_RIGHT;
+		ba = state & ARCADE_A;
+		bb = state & ARCADE_B;
+		bx = state & ARCADE_X;
+		by = state & ARCADE_Y;
+		bl = state & ARCADE_L;
+		br = state & ARCADE_R;
+		bzl = state & ARCADE_ZL;
+		bzr = state & ARCADE_ZR;
+		bm = state & ARCADE_MINUS;
+		bp = state & ARCADE_PLUS;
+		bhome = (state & ARCADE_HOME) || (bm && bp); // SELECT + START == HOME
+
+		WMExtension::set_button_data(bdl, bdr, bdu, bdd, ba, bb, bx, by, bl, br,
+				bm, bp, bhome, lx, ly, rx, ry, bzl, bzr, lt, rt);
+	}
+}
+#endif
+
+// Decodes a Classic Controller report into 8 bit lx, ly, rx, ry, lt, rt
+void wiicc_axes(const byte *report, byte format, byte *axes) {
+	if(format == 3) {
+		axes[0] = report[0];
+		axes[1] = report[2];
+		axes[2] = report[1];
+		axes[3] = report[3];
+		axes[4] = report[4];
+		axes[5] = report[5];
+	} else {
+		axes[0] = report[0] << 2;
+		axes[1] = report[1] << 2;
+		axes[2] = (((report[0] >> 3) & 0x18) | ((report[1] >> 5) & 0x06) | (report[2] >> 7)) << 3;
+		axes[3] = report[2] << 3;
+		axes[4] = (((report[2] >> 2) & 0x18) | (report[3] >> 5)) << 3;
+		axes[5] = report[3] << 3;
+	}
+}
+
+// Wii Classic Controller passthrough (see WiiCCPad.h)
+void wiicc_loop() {
+	byte *report = WiiCCPad::report();
+	byte *buttons;
+	byte axes[6];
+	byte center[4];
+
+	byte clx = WMExtension::get_calibration_byte(2);
+	byte cly = WMExtension::get_calibration_byte(5);
+	byte crx = WMExtension::get_calibration_byte(8);
+	byte cry = WMExtension::get_calibration_byte(11);
+
+	PadCacheData cache = { 0, 1, { clx, cly, crx, cry } };
+	bool cached;
+
+	Arena::claim(ARENA_WIICC);
+
+	// No pad yet: keep the timebase and the key setup going meanwhile
+	while(!WiiCCPad::init() || !WiiCCPad::read()) {
+		WMExtension::service();
+		DELAY_US(WIICC_RETRY_US);
+	}
+
+	wiicc_axes(report, WiiCCPad::format(), center);
+
+	cached = PadCache::load(PAD_WIICC, &cache);
+	select_centers(PAD_WIICC, &cache, cached, center, 4);
+
+	for (;;) {
+		pad_idle();
+		Power::idle();
+
+		// Unplugged or glitched: release everything, set it up again
+		if(!WiiCCPad::read()) {
+			WMExtension::set_report(0, 0, clx, cly, crx, cry, 0, 0);
+
+			while(!WiiCCPad::init()) {
+				WMExtension::service();
+				DELAY_US(WIICC_RETRY_US);
+			}
+
+			continue;
+		}
+
+#if WIICC_FORWARD && !PAD_FILTER
+		// Already in the Wiimote's format, nothing to change: as read
+		if(WiiCCPad::format() == WMExtension::get_format()) {
+			WMExtension::forward_report(report, WiiCCPad::format() == 3 ? 8 : 6);
+			continue;
+		}
+#endif
+
+		// The report is decoded once, in place, buttons are already in
+		// the Wiimote's layout
+		wiicc_axes(report, WiiCCPad::format(), axes);
+		buttons = report + (WiiCCPad::format() == 3 ? 6 : 4);
+
+		axes[0] = PadFilter::smooth(PADFILTER_LX, axes[0]);
+		axes[1] = PadFilter::smooth(PADFILTER_LY, axes[1]);
+		axes[2] = PadFilter::smooth(PADFILTER_RX, axes[2]);
+		axes[3] = PadFilter::smooth(PADFILTER_RY, axes[3]);
+		axes[4] = PadFilter::smooth(PADFILTER_LT, axes[4]);
+		axes[5] = PadFilter::smooth(PADFILTER_RT, axes[5]);
+
+		if(center_settling)
+			settle_centers(PAD_WIICC, &cache, center, axes, 4);
+
+		if((axes[0] >= (center[0] - ANALOG_NEUTRAL_RADIUS)) && (axes[0] <= (center[0] + ANALOG_NEUTRAL_RADIUS))) {
+			axes[0] = clx;
+		}
+
+		if((axes[1] >= (center[1] - ANALOG_NEUTRAL_RADIUS)) && (axes[1] <= (center[1] + ANALOG_NEUTRAL_RADIUS))) {
+			axes[1] = cly;
+		}
+
+		if((axes[2] >= (center[2] - ANALOG_NEUTRAL_RADIUS/2)) && (axes[2] <= (center[2] + ANALOG_NEUTRAL_RADIUS/2))) {
+			axes[2] = crx;
+		}
+
+		if((axes[3] >= (center[3] - ANALOG_NEUTRAL_RADIUS/2)) && (axes[3] <= (center[3] + ANALOG_NEUTRAL_RADIUS/2))) {
+			axes[3] = cry;
+		}
+
+		WMExtension::set_report(~buttons[0], ~buttons[1], axes[0], axes[1], axes[2],
+				axes[3], axes[4], axes[5]);
+	}
 }
 
 void setup() {
-	// Prepare wiimote communications
+	Timebase::init();
+	Trace::init();
+	Sniffer::init();
+
+	// Answer the Wiimote first, the pad is brought up later in loop()
 	WMExtension::init();
+	Trace::event(TRACE_BOOT, TRACE_BOOT_I2C);
+
+	StackMonitor::init();
+	profiler_init();
+	Power::init();
 }
 
 void loop() {
+	int pad;
+
+	// REPLAY = 2: never returns if there is a recording
+	Replay::play();
+
+	pad = detectPad();
+
+	Trace::event(TRACE_DRIVER, pad);
+	Replay::start(pad);
+
 	// Select pad loop based on pad auto-detection routine. Genesis pad is the default.
-	switch (detectPad()) {
+	switch (pad) {
 	case PAD_NES:
 		nes_loop();
 		break;
@@ -621,8 +1008,13 @@ void loop() {
 		tg16_loop();
 		break;
 	case PAD_WIICC:
-		unsupported_pad();
+		wiicc_loop();
+		break;
+#if ARCADE
+	case PAD_ARCADE:
+		arcade_loop();
 		break;
+#endif
 	default:
 		genesis_loop();
 		break;